@@ -301,6 +301,7 @@ static GameActor* gameActorNew(GameWindow *window)
 
       glhckAnimatorAnimation(actor->animator, animations[0]);
       glhckAnimatorInsertBones(actor->animator, bones, numBones);
+      glhckAnimatorLod(actor->animator, 100.0f, 300.0f, 4);
    }
 
    for (a = window->actor; a && a->next; a = a->next);
@@ -285,6 +285,8 @@ PYGLMAP enum glhckDataType {
    GLHCK_UNSIGNED_INT_8_8_8_8_REV,
    GLHCK_UNSIGNED_INT_10_10_10_2,
    GLHCK_UNSIGNED_INT_2_10_10_10_REV,
+   GLHCK_INT_2_10_10_10_REV,
+   GLHCK_HALF_FLOAT,
 } glhckDataType;
 
 /* blending modes */
@@ -385,12 +387,31 @@ typedef struct glhckRenderFeaturesTexture {
    int maxRenderbufferSize;
 } glhckRenderFeaturesTexture;
 
+/* \brief skinning render features */
+typedef struct glhckRenderFeaturesSkinning {
+   int maxBones; /* 0 when renderer can't skin on GPU */
+} glhckRenderFeaturesSkinning;
+
+/* \brief vertex render features */
+typedef struct glhckRenderFeaturesVertex {
+   char hasPackedAttributes; /* half float and 2_10_10_10 attributes can be drawn */
+} glhckRenderFeaturesVertex;
+
 /* \brief renderer features */
 typedef struct glhckRenderFeatures {
    glhckRenderFeaturesVersion version;
    glhckRenderFeaturesTexture texture;
+   glhckRenderFeaturesSkinning skinning;
+   glhckRenderFeaturesVertex vertex;
 } glhckRenderFeatures;
 
+/* \brief dynamic geometry streaming statistics */
+typedef struct glhckRenderStreamStatistics {
+   size_t size;       /* size of the streaming ring buffer in bytes */
+   size_t streamed;   /* total bytes streamed through the ring buffer */
+   unsigned int wraps; /* times the ring buffer has wrapped around */
+} glhckRenderStreamStatistics;
+
 /* texture parameters struct */
 typedef struct glhckTextureParameters {
    float maxAnisotropy;
@@ -469,6 +490,10 @@ typedef enum glhckTextureCompression {
 typedef struct glhckImportModelParameters {
    char animated; /* tells importer that model with animation data was requested */
    char flatten; /* tells importer to join all mesh nodes into one */
+   char optimize; /* tells importer to optimize geometry for vertex cache, overdraw and vertex fetch,
+                   * off by default since it reorders indices and vertices of the imported geometry */
+   char weld; /* tells importer to merge identical vertices */
+   char meshlets; /* tells importer to split big geometry to meshlets for culling */
 } glhckImportModelParameters;
 
 /* texture import parameters */
@@ -494,6 +519,10 @@ typedef struct glhckVector2b {
    char x, y;
 } glhckVector2b;
 
+typedef struct glhckVector2h {
+   unsigned short x, y; /* half floats */
+} glhckVector2h;
+
 typedef struct glhckVector3s {
    short x, y, z;
 } glhckVector3s;
@@ -552,6 +581,21 @@ typedef struct glhckVertexData2b {
    glhckColorb color;
 } glhckVertexData2b;
 
+/* packed vertex data, normal is signed 2_10_10_10_REV and coords are half floats */
+typedef struct glhckVertexData3fp {
+   glhckVector3f vertex;
+   unsigned int normal;
+   glhckVector2h coord;
+   glhckColorb color;
+} glhckVertexData3fp;
+
+typedef struct glhckVertexData2fp {
+   glhckVector2f vertex;
+   unsigned int normal;
+   glhckVector2h coord;
+   glhckColorb color;
+} glhckVertexData2fp;
+
 /* feed glhck the highest precision */
 typedef glhckVertexData3f glhckImportVertexData;
 typedef unsigned int glhckImportIndexData;
@@ -563,9 +607,20 @@ typedef enum glhckBuiltinVertexType {
    GLHCK_VTX_V2S,
    GLHCK_VTX_V3B,
    GLHCK_VTX_V2B,
+   GLHCK_VTX_V3FP,
+   GLHCK_VTX_V2FP,
    GLHCK_VTX_AUTO = 255,
 } glhckBuiltinVertexType;
 
+/* geometry optimizations */
+typedef enum glhckGeometryOptimizeFlags {
+   GLHCK_OPTIMIZE_VERTEX_CACHE  = 1<<0, /* reorder triangles for post-transform cache */
+   GLHCK_OPTIMIZE_OVERDRAW      = 1<<1, /* reorder clusters of triangles to reduce overdraw */
+   GLHCK_OPTIMIZE_VERTEX_FETCH  = 1<<2, /* reorder vertices in order of use */
+   GLHCK_OPTIMIZE_INDICES       = GLHCK_OPTIMIZE_VERTEX_CACHE | GLHCK_OPTIMIZE_OVERDRAW,
+   GLHCK_OPTIMIZE_ALL           = GLHCK_OPTIMIZE_INDICES | GLHCK_OPTIMIZE_VERTEX_FETCH,
+} glhckGeometryOptimizeFlags;
+
 typedef enum glhckBuiltinIndexType {
    GLHCK_IDX_UINT,
    GLHCK_IDX_USHRT,
@@ -577,7 +632,10 @@ typedef enum glhckBuiltinIndexType {
 struct glhckGeometry;
 struct _glhckSkinBone;
 
-/* function map for vertexType */
+/* function map for vertexType
+ * transform is optional, it's only used for CPU skinning of types
+ * with other than byte, short or float positions. it gets geometry with positions zeroed,
+ * and accumulates weighted positions of the bind pose to it. */
 typedef struct glhckVertexTypeFunctionMap {
    void (*convert)(const glhckImportVertexData *import, int memb, void *out, glhckVector3f *bias, glhckVector3f *scale);
    void (*minMax)(struct glhckGeometry *geometry, glhckVector3f *min, glhckVector3f *max);
@@ -589,6 +647,25 @@ typedef struct glhckIndexTypeFunctionMap {
    void (*convert)(const glhckImportIndexData *import, int memb, void *out);
 } glhckIndexTypeFunctionMap;
 
+/* cluster of triangles in geometry, culled as a unit
+ * bounds and cone are in geometry space, bias and scale are not applied */
+typedef struct glhckMeshlet {
+   kmAABB aabb;
+   kmVec3 center;
+   kmScalar radius;
+
+   /* all triangles face away from axis by at least acos(-coneCutoff),
+    * cutoff of 1 means the cone is too wide for backface culling */
+   kmVec3 coneAxis;
+   kmScalar coneCutoff;
+
+   /* range of indices the meshlet owns */
+   unsigned int indexOffset, indexCount;
+} glhckMeshlet;
+
+/* called when geometry releases vertex or index data it adopted */
+typedef void (*glhckGeometryReleaseFunc)(void *data, void *userData);
+
 /* geometry datatype for low-level raw access */
 typedef struct glhckGeometry {
    /* geometry transformation needed
@@ -596,12 +673,26 @@ typedef struct glhckGeometry {
    glhckVector3f bias;
    glhckVector3f scale;
 
+   /* maximum position error after
+    * precision conversion */
+   float error;
+
    /* vertices && indices*/
    void *vertices, *indices;
 
+   /* triangle clusters for culling,
+    * released when vertices or indices change */
+   glhckMeshlet *meshlets;
+   int meshletCount;
+
    /* counts for vertices && indices */
    int vertexCount, indexCount;
 
+   /* release callbacks of adopted vertices && indices,
+    * NULL when glhck's allocator owns them */
+   glhckGeometryReleaseFunc vertexRelease, indexRelease;
+   void *vertexReleaseData, *indexReleaseData;
+
    /* transformed texture range
     * the texture matrix is scaled with
     * 1.0f/textureRange of geometry before
@@ -681,8 +772,25 @@ typedef struct __GLHCKcontext           glhckContext;
 
 typedef void (*glhckDebugHookFunc)(const char *file, int line, const char *function, glhckDebugLevel level, const char *str);
 
+/* allocator callbacks
+ * channel is the tracing channel of the allocation (OBJECT, TEXTURE, etc..)
+ * callbacks are called from glhck's job threads too, so they must be thread-safe */
+typedef void* (*glhckMallocFunc)(const char *channel, size_t size, void *userData);
+typedef void* (*glhckReallocFunc)(const char *channel, void *ptr, size_t size, void *userData);
+typedef void (*glhckFreeFunc)(void *ptr, void *userData);
+
+/* host provided allocator */
+typedef struct glhckAllocator {
+   glhckMallocFunc malloc;
+   glhckReallocFunc realloc;
+   glhckFreeFunc free;
+   void *userData;
+} glhckAllocator;
+
 /* can be called before context */
 GLHCKAPI void glhckGetCompileFeatures(glhckCompileFeatures *features);
+GLHCKAPI void glhckSetAllocator(const glhckAllocator *allocator);
+GLHCKAPI void glhckGetAllocator(glhckAllocator *allocator);
 
 /* init && terminate */
 GLHCKAPI int glhckInitialized(void);
@@ -692,8 +800,14 @@ GLHCKAPI glhckContext* glhckContextCreate(int argc, char **argv);
 GLHCKAPI void glhckContextTerminate(void);
 GLHCKAPI void glhckMassacreWorld(void);
 GLHCKAPI void glhckLogColor(char color);
+
+/* jobs */
+GLHCKAPI int glhckJobThreads(unsigned int threads);
+GLHCKAPI unsigned int glhckJobGetThreads(void);
 GLHCKAPI void glhckSetGlobalPrecision(unsigned char itype, unsigned char vtype);
 GLHCKAPI void glhckGetGlobalPrecision(unsigned char *itype, unsigned char *vtype);
+GLHCKAPI void glhckSetGlobalPrecisionError(float error);
+GLHCKAPI float glhckGetGlobalPrecisionError(void);
 
 /* import */
 GLHCKAPI const glhckImportModelParameters* glhckImportDefaultModelParameters(void);
@@ -708,6 +822,7 @@ GLHCKAPI void glhckDisplayResize(int width, int height);
 GLHCKAPI const char* glhckRenderName(void);
 GLHCKAPI glhckDriverType glhckRenderGetDriver(void);
 GLHCKAPI const glhckRenderFeatures* glhckRenderGetFeatures(void);
+GLHCKAPI void glhckRenderGetStreamStatistics(glhckRenderStreamStatistics *statistics);
 GLHCKAPI void glhckRenderResize(int width, int height);
 GLHCKAPI void glhckRenderViewport(const glhckRect *viewport);
 GLHCKAPI void glhckRenderViewporti(int x, int y, int width, int height);
@@ -844,6 +959,7 @@ GLHCKAPI void glhckObjectScalef(glhckObject *object, const kmScalar x, const kmS
 /* object geometry */
 GLHCKAPI int glhckObjectInsertVertices(glhckObject *object, unsigned char type, const glhckImportVertexData *vertices, int memb);
 GLHCKAPI int glhckObjectInsertIndices(glhckObject *object, unsigned char type, const glhckImportIndexData *indices, int memb);
+GLHCKAPI int glhckObjectInsertWeldedVertices(glhckObject *object, unsigned char itype, unsigned char vtype, const glhckImportVertexData *vertices, int memb, float epsilon);
 GLHCKAPI void glhckObjectUpdate(glhckObject *object);
 GLHCKAPI glhckGeometry* glhckObjectNewGeometry(glhckObject *object);
 GLHCKAPI glhckGeometry* glhckObjectGetGeometry(const glhckObject *object);
@@ -901,6 +1017,7 @@ GLHCKAPI int glhckAnimationNodeInsertRotations(glhckAnimationNode *object, const
 GLHCKAPI const glhckAnimationQuaternionKey* glhckAnimationNodeRotations(glhckAnimationNode *object, unsigned int *memb);
 GLHCKAPI int glhckAnimationNodeInsertScalings(glhckAnimationNode *object, const glhckAnimationVectorKey *keys, unsigned int memb);
 GLHCKAPI const glhckAnimationVectorKey* glhckAnimationNodeScalings(glhckAnimationNode *object, unsigned int *memb);
+GLHCKAPI int glhckAnimationNodeCompress(glhckAnimationNode *object, float vectorError, float rotationError);
 
 /* animations */
 GLHCKAPI glhckAnimation* glhckAnimationNew(void);
@@ -914,6 +1031,7 @@ GLHCKAPI void glhckAnimationDuration(glhckAnimation *object, float duration);
 GLHCKAPI float glhckAnimationGetDuration(glhckAnimation *object);
 GLHCKAPI int glhckAnimationInsertNodes(glhckAnimation *object, glhckAnimationNode **nodes, unsigned int memb);
 GLHCKAPI glhckAnimationNode** glhckAnimationNodes(glhckAnimation *object, unsigned int *memb);
+GLHCKAPI int glhckAnimationCompress(glhckAnimation *object, float vectorError, float rotationError);
 
 /* animator */
 GLHCKAPI glhckAnimator* glhckAnimatorNew(void);
@@ -924,6 +1042,12 @@ GLHCKAPI int glhckAnimatorInsertBones(glhckAnimator *object, glhckBone **bones,
 GLHCKAPI glhckBone** glhckAnimatorBones(glhckAnimator *object, unsigned int *memb);
 GLHCKAPI void glhckAnimatorTransform(glhckAnimator *object, glhckObject *gobject);
 GLHCKAPI void glhckAnimatorUpdate(glhckAnimator *object, float playTime);
+GLHCKAPI void glhckAnimatorUpdateMany(glhckAnimator **objects, const float *playTimes, unsigned int memb);
+GLHCKAPI void glhckAnimatorTransformMany(glhckAnimator **objects, glhckObject **gobjects, unsigned int memb);
+GLHCKAPI void glhckAnimatorTimeStep(glhckAnimator *object, float step);
+GLHCKAPI float glhckAnimatorGetTimeStep(glhckAnimator *object);
+GLHCKAPI void glhckAnimatorLod(glhckAnimator *object, float nearDistance, float farDistance, unsigned int maxInterval);
+GLHCKAPI unsigned int glhckAnimatorGetUpdateInterval(glhckAnimator *object);
 
 /* text */
 GLHCKAPI glhckText* glhckTextNew(int cacheWidth, int cacheHeight);
@@ -933,6 +1057,7 @@ GLHCKAPI void glhckTextFontFree(glhckText *object, unsigned int font_id);
 GLHCKAPI void glhckTextFlushCache(glhckText *object);
 GLHCKAPI void glhckTextGetMetrics(glhckText *object, unsigned int font_id, float size, float *ascender, float *descender, float *lineHeight);
 GLHCKAPI void glhckTextGetMinMax(glhckText *object, unsigned int font_id, float size, const char *s, kmVec2 *min, kmVec2 *max);
+GLHCKAPI void glhckTextPrewarm(glhckText *object, unsigned int font_id, float size, const char *s);
 GLHCKAPI void glhckTextColor(glhckText *object, const glhckColorb *color);
 GLHCKAPI void glhckTextColorb(glhckText *object, unsigned char r, unsigned char g, unsigned char b, unsigned char a);
 GLHCKAPI const glhckColorb* glhckTextGetColor(glhckText *object);
@@ -941,10 +1066,14 @@ GLHCKAPI unsigned int glhckTextFontNewFromMemory(glhckText *object, const void *
 GLHCKAPI unsigned int glhckTextFontNew(glhckText *object, const char *file);
 GLHCKAPI unsigned int glhckTextFontNewFromTexture(glhckText *object, glhckTexture *texture, int ascent, int descent, int lineGap);
 GLHCKAPI unsigned int glhckTextFontNewFromBitmap(glhckText *object, const char *file, int ascent, int descent, int lineGap);
+GLHCKAPI void glhckTextFontDistanceField(glhckText *object, unsigned int font_id, float referenceSize);
 GLHCKAPI void glhckTextGlyphNew(glhckText *object, unsigned int font_id, const char *s,
       short size, short base, int x, int y, int w, int h,
       float xoff, float yoff, float xadvance);
 GLHCKAPI void glhckTextStash(glhckText *object, unsigned int font_id, float size, float x, float y, const char *s, float *width);
+GLHCKAPI unsigned int glhckTextLayoutNew(glhckText *object, unsigned int font_id, float size, const char *s);
+GLHCKAPI void glhckTextLayoutFree(glhckText *object, unsigned int layout_id);
+GLHCKAPI void glhckTextLayoutStash(glhckText *object, unsigned int layout_id, float x, float y, float *width);
 GLHCKAPI void glhckTextClear(glhckText *object);
 GLHCKAPI void glhckTextRender(glhckText *object);
 GLHCKAPI void glhckTextShader(glhckText *object, glhckShader *shader);
@@ -1100,6 +1229,13 @@ GLHCKAPI void glhckRenderPrintTextureQueue(void);
 GLHCKAPI void glhckGeometryCalculateBB(glhckGeometry *geometry, kmAABB *bb);
 GLHCKAPI int glhckGeometryInsertVertices(glhckGeometry *geometry, unsigned char type, const void *data, int memb);
 GLHCKAPI int glhckGeometryInsertIndices(glhckGeometry *geometry, unsigned char type, const void *data, int memb);
+GLHCKAPI int glhckGeometryAdoptVertices(glhckGeometry *geometry, unsigned char type, void *data, int memb,
+      glhckGeometryReleaseFunc release, void *userData);
+GLHCKAPI int glhckGeometryAdoptIndices(glhckGeometry *geometry, unsigned char type, void *data, int memb,
+      glhckGeometryReleaseFunc release, void *userData);
+GLHCKAPI int glhckGeometryOptimize(glhckGeometry *geometry, unsigned int flags);
+GLHCKAPI int glhckGeometryCacheStatistics(const glhckGeometry *geometry, unsigned int cacheSize, float *acmr, float *atvr);
+GLHCKAPI int glhckGeometryBuildMeshlets(glhckGeometry *geometry, unsigned int maxTriangles);
 
 /* collisions
  * XXX: incomplete */
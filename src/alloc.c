@@ -1,11 +1,42 @@
 #include "internal.h"
 #include <stdlib.h>  /* for malloc */
+#include <stdint.h>  /* for SIZE_MAX */
 #include <stdio.h>   /* for printf */
 #include <assert.h>  /* for assert */
 
 /* tracing channel for this file */
 #define GLHCK_CHANNEL GLHCK_CHANNEL_ALLOC
 
+/* \brief default malloc callback */
+static void* _glhckDefaultMalloc(const char *channel, size_t size, void *userData)
+{
+   (void)channel, (void)userData;
+   return malloc(size);
+}
+
+/* \brief default realloc callback */
+static void* _glhckDefaultRealloc(const char *channel, void *ptr, size_t size, void *userData)
+{
+   (void)channel, (void)userData;
+   return realloc(ptr, size);
+}
+
+/* \brief default free callback */
+static void _glhckDefaultFree(void *ptr, void *userData)
+{
+   (void)userData;
+   free(ptr);
+}
+
+/* allocator used for all glhck allocations.
+ * this is shared by all contexts, since memory may move beetwen them. */
+static glhckAllocator _glhckAllocator = {
+   _glhckDefaultMalloc,
+   _glhckDefaultRealloc,
+   _glhckDefaultFree,
+   NULL
+};
+
 /* allocation tracking on debug build */
 #ifndef NDEBUG
 #define GLHCK_ALLOC_CRITICAL 100 * 1048576 /* 100 MiB */
@@ -114,11 +145,13 @@ void* __glhckMalloc(const char *channel, size_t size)
    void *ptr;
    CALL(3, "%s, %zu", channel, size);
 
-   if (!(ptr = malloc(size)))
+   if (!(ptr = _glhckAllocator.malloc(channel, size, _glhckAllocator.userData)))
       goto fail;
 
 #ifndef NDEBUG
+   _glhckJobLock();
    trackAlloc(channel, ptr, size);
+   _glhckJobUnlock();
 #endif
 
    RET(3, "%p", ptr);
@@ -136,18 +169,26 @@ void* __glhckCalloc(const char *channel, size_t nmemb, size_t size)
    void *ptr;
    CALL(3, "%s, %zu, %zu", channel, nmemb, size);
 
-   if (!(ptr = calloc(nmemb, size)))
+   /* calloc would check this for us */
+   if (size && nmemb > SIZE_MAX / size)
+      goto fail;
+
+   if (!(ptr = _glhckAllocator.malloc(channel, nmemb * size, _glhckAllocator.userData)))
       goto fail;
 
+   memset(ptr, 0, nmemb * size);
+
 #ifndef NDEBUG
+   _glhckJobLock();
    trackAlloc(channel, ptr, nmemb * size);
+   _glhckJobUnlock();
 #endif
 
    RET(3, "%p", ptr);
    return ptr;
 
 fail:
-   DEBUG(GLHCK_DBG_ERROR, "Failed to allocate %zu bytes", nmemb * size);
+   DEBUG(GLHCK_DBG_ERROR, "Failed to allocate %zu * %zu bytes", nmemb, size);
    RET(3, "%p", NULL);
    return NULL;
 }
@@ -156,13 +197,18 @@ fail:
 char* __glhckStrdup(const char *channel, const char *s)
 {
    char *s2;
+   size_t size;
    CALL(3, "%s, %s", channel, s);
 
-   if (!(s2 = _glhckStrdupNoTrack(s)))
+   if (!s || !(s2 = _glhckAllocator.malloc(channel, (size = strlen(s) + 1), _glhckAllocator.userData)))
       goto fail;
 
+   memcpy(s2, s, size);
+
 #ifndef NDEBUG
-   trackAlloc(channel, s2, strlen(s2) + 1);
+   _glhckJobLock();
+   trackAlloc(channel, s2, size);
+   _glhckJobUnlock();
 #endif
 
    RET(3, "%s", s2);
@@ -199,17 +245,19 @@ void* __glhckRealloc(const char *channel, void *ptr, size_t omemb, size_t nmemb,
    void *ptr2;
    CALL(3, "%p, %zu, %zu, %zu", ptr, omemb, nmemb, size);
 
-   if (!(ptr2 = realloc(ptr, nmemb * size))) {
-      if (!(ptr2 = malloc(nmemb * size)))
+   if (!(ptr2 = _glhckAllocator.realloc(channel, ptr, nmemb * size, _glhckAllocator.userData))) {
+      if (!(ptr2 = _glhckAllocator.malloc(channel, nmemb * size, _glhckAllocator.userData)))
          goto fail;
       memcpy(ptr2, ptr, omemb * size);
-      free(ptr);
+      _glhckAllocator.free(ptr, _glhckAllocator.userData);
    }
 
 #ifndef NDEBUG
    /* http://llvm.org/bugs/show_bug.cgi?id=16499 */
 #ifndef __clang_analyzer__
+   _glhckJobLock();
    trackRealloc(channel, ptr, ptr2, nmemb * size);
+   _glhckJobUnlock();
 #endif
 #endif
 
@@ -230,16 +278,46 @@ void _glhckFree(void *ptr)
    assert(ptr);
 
 #ifndef NDEBUG
+   _glhckJobLock();
    trackFree(ptr);
+   _glhckJobUnlock();
 #endif
 
-   free(ptr);
+   _glhckAllocator.free(ptr, _glhckAllocator.userData);
 }
 
 /***
  * public api
  ***/
 
+/* \brief set allocator used for all glhck allocations, can be called before context.
+ * NULL restores the default libc allocator.
+ *
+ * NOTE: Memory is released with the allocator that is active at the time,
+ * so change allocator only when there is no glhck context alive.
+ * The callbacks are also called from job threads, so they must be thread-safe. */
+GLHCKAPI void glhckSetAllocator(const glhckAllocator *allocator)
+{
+   if (!allocator) {
+      _glhckAllocator.malloc = _glhckDefaultMalloc;
+      _glhckAllocator.realloc = _glhckDefaultRealloc;
+      _glhckAllocator.free = _glhckDefaultFree;
+      _glhckAllocator.userData = NULL;
+      return;
+   }
+
+   assert(allocator->malloc && allocator->realloc && allocator->free);
+   memcpy(&_glhckAllocator, allocator, sizeof(glhckAllocator));
+}
+
+/* \brief get allocator used for glhck allocations, can be called before context.
+ * useful for chaining allocators (budgets, statistics, etc..) */
+GLHCKAPI void glhckGetAllocator(glhckAllocator *allocator)
+{
+   assert(allocator);
+   memcpy(allocator, &_glhckAllocator, sizeof(glhckAllocator));
+}
+
 /* \brief output memory usage graph */
 GLHCKAPI void glhckMemoryGraph(void)
 {
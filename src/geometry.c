@@ -1,5 +1,7 @@
 #include "internal.h"
 #include <limits.h> /* for type limits */
+#include <float.h>  /* for FLT_MAX */
+#include <math.h>   /* for sqrtf */
 
 #ifndef __STRING
 #  define __STRING(x) #x
@@ -50,6 +52,16 @@ static void _glhckDataTypeAttributes(glhckDataType dataType, unsigned char *size
          if (size) *size = sizeof(float);
          if (normalized) *normalized = 0;
          return;
+      case GLHCK_HALF_FLOAT:
+         if (max) *max = 1;
+         if (size) *size = sizeof(unsigned short);
+         if (normalized) *normalized = 0;
+         return;
+      case GLHCK_INT_2_10_10_10_REV:
+         if (max) *max = 511;
+         if (size) *size = sizeof(unsigned int);
+         if (normalized) *normalized = 1;
+         return;
       default:break;
    }
 
@@ -109,292 +121,93 @@ static unsigned char _glhckGeometryCheckIndexType(unsigned char type, const glhc
 /* \brief get max && min for import vertex data */
 static void _glhckImportVertexDataMaxMin(const glhckImportVertexData *import, int memb, glhckVector3f *vmin, glhckVector3f *vmax)
 {
-   int i;
    assert(import && vmin && vmax);
 
-   memcpy(vmin, &import[0].vertex, sizeof(glhckVector3f));
-   memcpy(vmax, &import[0].vertex, sizeof(glhckVector3f));
-   for (i = 1; i < memb; ++i) {
-      glhckMaxV3(vmax, &import[i].vertex);
-      glhckMinV3(vmin, &import[i].vertex);
+   /* no positions to bound, don't leave caller's bounds uninitialized */
+   if (memb <= 0) {
+      memset(vmin, 0, sizeof(glhckVector3f));
+      memset(vmax, 0, sizeof(glhckVector3f));
+      return;
    }
 
-   /* lie about bounds by 1 point so, we don't get artifacts */
-   vmax->x++; vmax->y++; vmax->z++;
-   vmin->x--; vmin->y--; vmin->z--;
+   _glhckPositionsMinMax(&import[0].vertex, sizeof(glhckImportVertexData), sizeof(glhckImportVertexData) - offsetof(glhckImportVertexData, vertex),
+         memb, GLHCK_FLOAT, 3, vmin, vmax);
 }
 
-/* \brief transform V2B */
-static void _glhckGeometryTransformV2B(glhckGeometry *geometry, const void *bindPose, glhckSkinBone **skinBones, unsigned int memb)
+/* \brief get bias and scale, that map positions in [vmin, vmax] to integers in [-max+1, max-1]
+ * flat axes get scale of 1, so they don't divide by zero */
+static void _glhckGeometryQuantization(const glhckVector3f *vmin, const glhckVector3f *vmax, float max, glhckVector3f *bias, glhckVector3f *scale)
 {
-   unsigned int i, w;
-   kmMat4 bias, biasinv, scale, scaleinv;
-   glhckVertexData3b *internal = geometry->vertices;
-
-   kmMat4Translation(&bias, geometry->bias.x, geometry->bias.y, geometry->bias.z);
-   kmMat4Scaling(&scale, geometry->scale.x, geometry->scale.y, geometry->scale.z);
-   kmMat4Inverse(&biasinv, &bias);
-   kmMat4Inverse(&scaleinv, &scale);
-
-   for (i = 0; i < memb; ++i) {
-      kmMat4 poseMatrix, transformedMatrix, offsetMatrix;
-      kmMat4Multiply(&transformedMatrix, &biasinv, &skinBones[i]->bone->transformedMatrix);
-      kmMat4Multiply(&transformedMatrix, &scaleinv, &transformedMatrix);
-      kmMat4Multiply(&offsetMatrix, &skinBones[i]->offsetMatrix, &bias);
-      kmMat4Multiply(&offsetMatrix, &offsetMatrix, &scale);
-      kmMat4Multiply(&poseMatrix, &transformedMatrix, &offsetMatrix);
-
-      for (w = 0; w < skinBones[i]->numWeights; ++w) {
-         kmVec3 v1;
-         glhckVertexWeight *weight = &skinBones[i]->weights[w];
-         const glhckVertexData2b *bdata = bindPose + weight->vertexIndex * sizeof(glhckVertexData2b);
-         glhckSetV2(&v1, &bdata->vertex); v1.z = 0.0f;
-         kmVec3MultiplyMat4(&v1, &v1, &poseMatrix);
-         internal[weight->vertexIndex].vertex.x += v1.x * weight->weight;
-         internal[weight->vertexIndex].vertex.y += v1.y * weight->weight;
-      }
-   }
+   /* leave one step of room on both sides, so positions skinned on CPU can go slightly out of bounds */
+   max -= 1.0f;
+   scale->x = (vmax->x > vmin->x ? (vmax->x - vmin->x) / (2.0f * max) : 1.0f);
+   scale->y = (vmax->y > vmin->y ? (vmax->y - vmin->y) / (2.0f * max) : 1.0f);
+   scale->z = (vmax->z > vmin->z ? (vmax->z - vmin->z) / (2.0f * max) : 1.0f);
+   bias->x = vmin->x + max * scale->x;
+   bias->y = vmin->y + max * scale->y;
+   bias->z = vmin->z + max * scale->z;
 }
 
-/* \brief transform V3B */
-static void _glhckGeometryTransformV3B(glhckGeometry *geometry, const void *bindPose, glhckSkinBone **skinBones, unsigned int memb)
+/* \brief quantize position component with bias and scale to integer in [-max, max] */
+static float _glhckGeometryQuantize(float value, float bias, float scale, float max)
 {
-   unsigned int i, w;
-   kmMat4 bias, biasinv, scale, scaleinv;
-   glhckVertexData3b *internal = geometry->vertices;
-
-   kmMat4Translation(&bias, geometry->bias.x, geometry->bias.y, geometry->bias.z);
-   kmMat4Scaling(&scale, geometry->scale.x, geometry->scale.y, geometry->scale.z);
-   kmMat4Inverse(&biasinv, &bias);
-   kmMat4Inverse(&scaleinv, &scale);
-
-   for (i = 0; i < memb; ++i) {
-      kmMat4 poseMatrix, transformedMatrix, offsetMatrix;
-      kmMat4Multiply(&transformedMatrix, &biasinv, &skinBones[i]->bone->transformedMatrix);
-      kmMat4Multiply(&transformedMatrix, &scaleinv, &transformedMatrix);
-      kmMat4Multiply(&offsetMatrix, &skinBones[i]->offsetMatrix, &bias);
-      kmMat4Multiply(&offsetMatrix, &offsetMatrix, &scale);
-      kmMat4Multiply(&poseMatrix, &transformedMatrix, &offsetMatrix);
-
-      for (w = 0; w < skinBones[i]->numWeights; ++w) {
-         kmVec3 v1;
-         glhckVertexWeight *weight = &skinBones[i]->weights[w];
-         const glhckVertexData3b *bdata = bindPose + weight->vertexIndex * sizeof(glhckVertexData3b);
-         glhckSetV3(&v1, &bdata->vertex);
-         kmVec3MultiplyMat4(&v1, &v1, &poseMatrix);
-         internal[weight->vertexIndex].vertex.x += v1.x * weight->weight;
-         internal[weight->vertexIndex].vertex.y += v1.y * weight->weight;
-         internal[weight->vertexIndex].vertex.z += v1.z * weight->weight;
-      }
-   }
+   value = floorf((value - bias) / scale + 0.5f);
+   return (value < -max ? -max : (value > max ? max : value));
 }
 
-/* \brief transform V2S */
-static void _glhckGeometryTransformV2S(glhckGeometry *geometry, const void *bindPose, glhckSkinBone **skinBones, unsigned int memb)
+/* \brief convert float to half float (round to nearest) */
+static unsigned short _glhckFloatToHalf(float value)
 {
-   unsigned int i, w;
-   kmMat4 bias, biasinv, scale, scaleinv;
-   glhckVertexData2s *internal = geometry->vertices;
-
-   kmMat4Translation(&bias, geometry->bias.x, geometry->bias.y, geometry->bias.z);
-   kmMat4Scaling(&scale, geometry->scale.x, geometry->scale.y, geometry->scale.z);
-   kmMat4Inverse(&biasinv, &bias);
-   kmMat4Inverse(&scaleinv, &scale);
-
-   for (i = 0; i < memb; ++i) {
-      kmMat4 poseMatrix, transformedMatrix, offsetMatrix;
-      kmMat4Multiply(&transformedMatrix, &biasinv, &skinBones[i]->bone->transformedMatrix);
-      kmMat4Multiply(&transformedMatrix, &scaleinv, &transformedMatrix);
-      kmMat4Multiply(&offsetMatrix, &skinBones[i]->offsetMatrix, &bias);
-      kmMat4Multiply(&offsetMatrix, &offsetMatrix, &scale);
-      kmMat4Multiply(&poseMatrix, &transformedMatrix, &offsetMatrix);
-
-      for (w = 0; w < skinBones[i]->numWeights; ++w) {
-         kmVec3 v1;
-         glhckVertexWeight *weight = &skinBones[i]->weights[w];
-         const glhckVertexData2s *bdata = bindPose + weight->vertexIndex * sizeof(glhckVertexData2s);
-         glhckSetV2(&v1, &bdata->vertex); v1.z = 0.0f;
-         kmVec3MultiplyMat4(&v1, &v1, &poseMatrix);
-         internal[weight->vertexIndex].vertex.x += v1.x * weight->weight;
-         internal[weight->vertexIndex].vertex.y += v1.y * weight->weight;
-      }
+   union { float f; unsigned int u; } v;
+   unsigned int sign, mantissa, half;
+   int exponent;
+
+   v.f = value;
+   sign = (v.u >> 16) & 0x8000;
+   exponent = (int)((v.u >> 23) & 0xff) - 127 + 15;
+   mantissa = v.u & 0x7fffff;
+
+   /* inf && nan */
+   if (((v.u >> 23) & 0xff) == 0xff)
+      return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+
+   /* overflow */
+   if (exponent >= 31)
+      return sign | 0x7c00;
+
+   /* denormals && underflow */
+   if (exponent <= 0) {
+      if (exponent < -10) return sign;
+      mantissa |= 0x800000;
+      half = mantissa >> (14 - exponent);
+      if ((mantissa >> (13 - exponent)) & 1) ++half;
+      return sign | half;
    }
-}
-
-/* \brief transform V3S */
-static void _glhckGeometryTransformV3S(glhckGeometry *geometry, const void *bindPose, glhckSkinBone **skinBones, unsigned int memb)
-{
-   unsigned int i, w;
-   kmMat4 bias, biasinv, scale, scaleinv;
-   glhckVertexData3s *internal = geometry->vertices;
 
-   kmMat4Translation(&bias, geometry->bias.x, geometry->bias.y, geometry->bias.z);
-   kmMat4Scaling(&scale, geometry->scale.x, geometry->scale.y, geometry->scale.z);
-   kmMat4Inverse(&biasinv, &bias);
-   kmMat4Inverse(&scaleinv, &scale);
-
-   for (i = 0; i < memb; ++i) {
-      kmMat4 poseMatrix, transformedMatrix, offsetMatrix;
-      kmMat4Multiply(&transformedMatrix, &biasinv, &skinBones[i]->bone->transformedMatrix);
-      kmMat4Multiply(&transformedMatrix, &scaleinv, &transformedMatrix);
-      kmMat4Multiply(&offsetMatrix, &skinBones[i]->offsetMatrix, &bias);
-      kmMat4Multiply(&offsetMatrix, &offsetMatrix, &scale);
-      kmMat4Multiply(&poseMatrix, &transformedMatrix, &offsetMatrix);
-
-      for (w = 0; w < skinBones[i]->numWeights; ++w) {
-         kmVec3 v1;
-         glhckVertexWeight *weight = &skinBones[i]->weights[w];
-         const glhckVertexData3s *bdata = bindPose + weight->vertexIndex * sizeof(glhckVertexData3s);
-         glhckSetV3(&v1, &bdata->vertex);
-         kmVec3MultiplyMat4(&v1, &v1, &poseMatrix);
-         internal[weight->vertexIndex].vertex.x += v1.x * weight->weight;
-         internal[weight->vertexIndex].vertex.y += v1.y * weight->weight;
-         internal[weight->vertexIndex].vertex.z += v1.z * weight->weight;
-      }
-   }
+   /* rounding may carry to exponent, which is what we want */
+   half = sign | (exponent << 10) | (mantissa >> 13);
+   if (mantissa & 0x1000) ++half;
+   return half;
 }
 
-/* \brief transform V2F */
-static void _glhckGeometryTransformV2F(glhckGeometry *geometry, const void *bindPose, glhckSkinBone **skinBones, unsigned int memb)
+/* \brief pack normal to signed 2_10_10_10_REV */
+static unsigned int _glhckPackNormal(const glhckVector3f *normal)
 {
-   unsigned int i, w;
-   kmMat4 bias, biasinv;
-   glhckVertexData2f *internal = geometry->vertices;
-
-   /* scale is always 1.0f, we can skip it */
-   kmMat4Translation(&bias, geometry->bias.x, geometry->bias.y, geometry->bias.z);
-   kmMat4Inverse(&biasinv, &bias);
+   const float n[3] = { normal->x, normal->y, normal->z };
+   unsigned int i, packed = 0;
+   int c;
 
-   for (i = 0; i < memb; ++i) {
-      kmMat4 poseMatrix, transformedMatrix, offsetMatrix;
-      kmMat4Multiply(&transformedMatrix, &biasinv, &skinBones[i]->bone->transformedMatrix);
-      kmMat4Multiply(&offsetMatrix, &skinBones[i]->offsetMatrix, &bias);
-      kmMat4Multiply(&poseMatrix, &transformedMatrix, &offsetMatrix);
-
-      for (w = 0; w < skinBones[i]->numWeights; ++w) {
-         kmVec3 v1;
-         glhckVertexWeight *weight = &skinBones[i]->weights[w];
-         const glhckVertexData2f *bdata = bindPose + weight->vertexIndex * sizeof(glhckVertexData2f);
-         glhckSetV2(&v1, &bdata->vertex); v1.z = 0.0f;
-         kmVec3MultiplyMat4(&v1, &v1, &poseMatrix);
-         internal[weight->vertexIndex].vertex.x += v1.x * weight->weight;
-         internal[weight->vertexIndex].vertex.y += v1.y * weight->weight;
-      }
+   for (i = 0; i != 3; ++i) {
+      c = (int)floorf((n[i] < -1.0f ? -1.0f : (n[i] > 1.0f ? 1.0f : n[i])) * 511.0f + 0.5f);
+      packed |= ((unsigned int)c & 0x3ff) << (i * 10);
    }
-}
 
-/* \brief transform V3F */
-static void _glhckGeometryTransformV3F(glhckGeometry *geometry, const void *bindPose, glhckSkinBone **skinBones, unsigned int memb)
-{
-   unsigned int i, w;
-   kmMat4 bias, biasinv;
-   glhckVertexData3f *internal = geometry->vertices;
-
-   /* scale is always 1.0f, we can skip it */
-   kmMat4Translation(&bias, geometry->bias.x, geometry->bias.y, geometry->bias.z);
-   kmMat4Inverse(&biasinv, &bias);
-
-   for (i = 0; i < memb; ++i) {
-      kmMat4 poseMatrix, transformedMatrix, offsetMatrix;
-      kmMat4Multiply(&transformedMatrix, &biasinv, &skinBones[i]->bone->transformedMatrix);
-      kmMat4Multiply(&offsetMatrix, &skinBones[i]->offsetMatrix, &bias);
-      kmMat4Multiply(&poseMatrix, &transformedMatrix, &offsetMatrix);
-
-      for (w = 0; w < skinBones[i]->numWeights; ++w) {
-         kmVec3 v1;
-         glhckVertexWeight *weight = &skinBones[i]->weights[w];
-         const glhckVertexData3f *bdata = bindPose + weight->vertexIndex * sizeof(glhckVertexData3f);
-         kmVec3MultiplyMat4(&v1, (kmVec3*)&bdata->vertex, &poseMatrix);
-         internal[weight->vertexIndex].vertex.x += v1.x * weight->weight;
-         internal[weight->vertexIndex].vertex.y += v1.y * weight->weight;
-         internal[weight->vertexIndex].vertex.z += v1.z * weight->weight;
-      }
-   }
-}
-
-/* \brief get min && max of V2B vertices */
-static void _glhckGeometryMinMaxV2B(glhckGeometry *geometry, glhckVector3f *min, glhckVector3f *max)
-{
-   int i = 0;
-   glhckVertexData2b *internal = geometry->vertices;
-   glhckSetV2(max, &internal[0].vertex);
-   glhckSetV2(min, &internal[0].vertex);
-   for (i = 1; i < geometry->vertexCount; ++i) {
-      glhckMaxV2(max, &internal[i].vertex);
-      glhckMinV2(min, &internal[i].vertex);
-   }
-}
-
-/* \brief get min && max of V3B vertices */
-static void _glhckGeometryMinMaxV3B(glhckGeometry *geometry, glhckVector3f *min, glhckVector3f *max)
-{
-   int i = 0;
-   glhckVertexData3b *internal = geometry->vertices;
-   glhckSetV3(max, &internal[0].vertex);
-   glhckSetV3(min, &internal[0].vertex);
-   for (i = 1; i < geometry->vertexCount; ++i) {
-      glhckMaxV3(max, &internal[i].vertex);
-      glhckMinV3(min, &internal[i].vertex);
-   }
-}
-
-/* \brief get min && max of V2S vertices */
-static void _glhckGeometryMinMaxV2S(glhckGeometry *geometry, glhckVector3f *min, glhckVector3f *max)
-{
-   int i = 0;
-   glhckVertexData2s *internal = geometry->vertices;
-   glhckSetV2(max, &internal[0].vertex);
-   glhckSetV2(min, &internal[0].vertex);
-   for (i = 1; i < geometry->vertexCount; ++i) {
-      glhckMaxV2(max, &internal[i].vertex);
-      glhckMinV2(min, &internal[i].vertex);
-   }
-}
-
-/* \brief get min && max of V3S vertices */
-static void _glhckGeometryMinMaxV3S(glhckGeometry *geometry, glhckVector3f *min, glhckVector3f *max)
-{
-   int i = 0;
-   glhckVertexData3s *internal = geometry->vertices;
-   glhckSetV3(max, &internal[0].vertex);
-   glhckSetV3(min, &internal[0].vertex);
-   for (i = 1; i < geometry->vertexCount; ++i) {
-      glhckMaxV3(max, &internal[i].vertex);
-      glhckMinV3(min, &internal[i].vertex);
-   }
-}
-
-/* \brief get min && max of V2F vertices */
-static void _glhckGeometryMinMaxV2F(glhckGeometry *geometry, glhckVector3f *min, glhckVector3f *max)
-{
-   int i = 0;
-   glhckVertexData2f *internal = geometry->vertices;
-   glhckSetV2(max, &internal[0].vertex);
-   glhckSetV2(min, &internal[0].vertex);
-   for (i = 1; i < geometry->vertexCount; ++i) {
-      glhckMaxV2(max, &internal[i].vertex);
-      glhckMinV2(min, &internal[i].vertex);
-   }
-}
-
-/* \brief get min && max of V3F vertices */
-static void _glhckGeometryMinMaxV3F(glhckGeometry *geometry, glhckVector3f *min, glhckVector3f *max)
-{
-   int i = 0;
-   glhckVertexData3f *internal = geometry->vertices;
-   memcpy(min, &internal[0].vertex, sizeof(glhckVector3f));
-   memcpy(max, &internal[0].vertex, sizeof(glhckVector3f));
-   for (i = 1; i < geometry->vertexCount; ++i) {
-      glhckMaxV3(max, &internal[i].vertex);
-      glhckMinV3(min, &internal[i].vertex);
-   }
+   return packed;
 }
 
 /* \brief convert import vertex data to V2B */
 static void _glhckGeometryConvertV2B(const glhckImportVertexData *import, int memb, void *out, glhckVector3f *bias, glhckVector3f *scale)
 {
-   const float srange = UCHAR_MAX - 1.0f;
-   const float brange = CHAR_MAX / srange;
    int i;
    glhckVector3f vmin, vmax;
    glhckVertexData2b *internal;
@@ -402,11 +215,15 @@ static void _glhckGeometryConvertV2B(const glhckImportVertexData *import, int me
    internal = out;
 
    _glhckImportVertexDataMaxMin(import, memb, &vmin, &vmax);
+   _glhckGeometryQuantization(&vmin, &vmax, CHAR_MAX, bias, scale);
+
+   /* there is no z, so keep it in the center */
+   bias->z = 0.5f * (vmax.z - vmin.z) + vmin.z;
+   scale->z = 1.0f;
 
-   /* center geometry */
    for (i = 0; i < memb; ++i) {
-      internal[i].vertex.x = floorf(((import[i].vertex.x - vmin.x) / (vmax.x - vmin.x)) * UCHAR_MAX - CHAR_MAX + 0.5f);
-      internal[i].vertex.y = floorf(((import[i].vertex.y - vmin.y) / (vmax.y - vmin.y)) * UCHAR_MAX - CHAR_MAX + 0.5f);
+      internal[i].vertex.x = _glhckGeometryQuantize(import[i].vertex.x, bias->x, scale->x, CHAR_MAX);
+      internal[i].vertex.y = _glhckGeometryQuantize(import[i].vertex.y, bias->y, scale->y, CHAR_MAX);
       internal[i].normal.x = import[i].normal.x * SHRT_MAX;
       internal[i].normal.y = import[i].normal.y * SHRT_MAX;
       internal[i].normal.z = import[i].normal.z * SHRT_MAX;
@@ -414,21 +231,11 @@ static void _glhckGeometryConvertV2B(const glhckImportVertexData *import, int me
       internal[i].coord.y = import[i].coord.y * SHRT_MAX;
       memcpy(&internal[i].color, &import[i].color, sizeof(glhckColorb));
    }
-
-   /* fix bias after centering */
-   bias->x = brange * (vmax.x - vmin.x) + vmin.x;
-   bias->y = brange * (vmax.y - vmin.y) + vmin.y;
-   bias->z = brange * (vmax.z - vmin.z) + vmin.z;
-   scale->x = (vmax.x - vmin.x) / srange;
-   scale->y = (vmax.y - vmin.y) / srange;
-   scale->z = (vmax.z - vmin.z) / srange;
 }
 
 /* \brief convert import vertex data to V3B */
 static void _glhckGeometryConvertV3B(const glhckImportVertexData *import, int memb, void *out, glhckVector3f *bias, glhckVector3f *scale)
 {
-   const float srange = UCHAR_MAX - 1.0f;
-   const float brange = CHAR_MAX / srange;
    int i;
    glhckVector3f vmin, vmax;
    glhckVertexData3b *internal;
@@ -436,12 +243,12 @@ static void _glhckGeometryConvertV3B(const glhckImportVertexData *import, int me
    internal = out;
 
    _glhckImportVertexDataMaxMin(import, memb, &vmin, &vmax);
+   _glhckGeometryQuantization(&vmin, &vmax, CHAR_MAX, bias, scale);
 
-   /* center geometry */
    for (i = 0; i < memb; ++i) {
-      internal[i].vertex.x = floorf(((import[i].vertex.x - vmin.x) / (vmax.x - vmin.x)) * UCHAR_MAX - CHAR_MAX + 0.5f);
-      internal[i].vertex.y = floorf(((import[i].vertex.y - vmin.y) / (vmax.y - vmin.y)) * UCHAR_MAX - CHAR_MAX + 0.5f);
-      internal[i].vertex.z = floorf(((import[i].vertex.z - vmin.z) / (vmax.z - vmin.z)) * UCHAR_MAX - CHAR_MAX + 0.5f);
+      internal[i].vertex.x = _glhckGeometryQuantize(import[i].vertex.x, bias->x, scale->x, CHAR_MAX);
+      internal[i].vertex.y = _glhckGeometryQuantize(import[i].vertex.y, bias->y, scale->y, CHAR_MAX);
+      internal[i].vertex.z = _glhckGeometryQuantize(import[i].vertex.z, bias->z, scale->z, CHAR_MAX);
       internal[i].normal.x = import[i].normal.x * SHRT_MAX;
       internal[i].normal.y = import[i].normal.y * SHRT_MAX;
       internal[i].normal.z = import[i].normal.z * SHRT_MAX;
@@ -449,21 +256,11 @@ static void _glhckGeometryConvertV3B(const glhckImportVertexData *import, int me
       internal[i].coord.y = import[i].coord.y * SHRT_MAX;
       memcpy(&internal[i].color, &import[i].color, sizeof(glhckColorb));
    }
-
-   /* fix bias after centering */
-   bias->x = brange * (vmax.x - vmin.x) + vmin.x;
-   bias->y = brange * (vmax.y - vmin.y) + vmin.y;
-   bias->z = brange * (vmax.z - vmin.z) + vmin.z;
-   scale->x = (vmax.x - vmin.x) / srange;
-   scale->y = (vmax.y - vmin.y) / srange;
-   scale->z = (vmax.z - vmin.z) / srange;
 }
 
 /* \brief convert import vertex data to V2S */
 static void _glhckGeometryConvertV2S(const glhckImportVertexData *import, int memb, void *out, glhckVector3f *bias, glhckVector3f *scale)
 {
-   const float srange = USHRT_MAX - 1.0f;
-   const float brange = SHRT_MAX / srange;
    int i;
    glhckVector3f vmin, vmax;
    glhckVertexData2s *internal;
@@ -471,11 +268,15 @@ static void _glhckGeometryConvertV2S(const glhckImportVertexData *import, int me
    internal = out;
 
    _glhckImportVertexDataMaxMin(import, memb, &vmin, &vmax);
+   _glhckGeometryQuantization(&vmin, &vmax, SHRT_MAX, bias, scale);
+
+   /* there is no z, so keep it in the center */
+   bias->z = 0.5f * (vmax.z - vmin.z) + vmin.z;
+   scale->z = 1.0f;
 
-   /* center geometry */
    for (i = 0; i < memb; ++i) {
-      internal[i].vertex.x = floorf(((import[i].vertex.x - vmin.x) / (vmax.x - vmin.x)) * USHRT_MAX - SHRT_MAX + 0.5f);
-      internal[i].vertex.y = floorf(((import[i].vertex.y - vmin.y) / (vmax.y - vmin.y)) * USHRT_MAX - SHRT_MAX + 0.5f);
+      internal[i].vertex.x = _glhckGeometryQuantize(import[i].vertex.x, bias->x, scale->x, SHRT_MAX);
+      internal[i].vertex.y = _glhckGeometryQuantize(import[i].vertex.y, bias->y, scale->y, SHRT_MAX);
       internal[i].normal.x = import[i].normal.x * SHRT_MAX;
       internal[i].normal.y = import[i].normal.y * SHRT_MAX;
       internal[i].normal.z = import[i].normal.z * SHRT_MAX;
@@ -483,21 +284,11 @@ static void _glhckGeometryConvertV2S(const glhckImportVertexData *import, int me
       internal[i].coord.y = import[i].coord.y * SHRT_MAX;
       memcpy(&internal[i].color, &import[i].color, sizeof(glhckColorb));
    }
-
-   /* fix bias after centering */
-   bias->x = brange * (vmax.x - vmin.x) + vmin.x;
-   bias->y = brange * (vmax.y - vmin.y) + vmin.y;
-   bias->z = brange * (vmax.z - vmin.z) + vmin.z;
-   scale->x = (vmax.x - vmin.x) / srange;
-   scale->y = (vmax.y - vmin.y) / srange;
-   scale->z = (vmax.z - vmin.z) / srange;
 }
 
 /* \brief convert import vertex data to V3S */
 static void _glhckGeometryConvertV3S(const glhckImportVertexData *import, int memb, void *out, glhckVector3f *bias, glhckVector3f *scale)
 {
-   const float srange = USHRT_MAX - 1.0f;
-   const float brange = SHRT_MAX / srange;
    int i;
    glhckVector3f vmin, vmax;
    glhckVertexData3s *internal;
@@ -505,12 +296,12 @@ static void _glhckGeometryConvertV3S(const glhckImportVertexData *import, int me
    internal = out;
 
    _glhckImportVertexDataMaxMin(import, memb, &vmin, &vmax);
+   _glhckGeometryQuantization(&vmin, &vmax, SHRT_MAX, bias, scale);
 
-   /* center geometry */
    for (i = 0; i < memb; ++i) {
-      internal[i].vertex.x = floorf(((import[i].vertex.x - vmin.x) / (vmax.x - vmin.x)) * USHRT_MAX - SHRT_MAX + 0.5f);
-      internal[i].vertex.y = floorf(((import[i].vertex.y - vmin.y) / (vmax.y - vmin.y)) * USHRT_MAX - SHRT_MAX + 0.5f);
-      internal[i].vertex.z = floorf(((import[i].vertex.z - vmin.z) / (vmax.z - vmin.z)) * USHRT_MAX - SHRT_MAX + 0.5f);
+      internal[i].vertex.x = _glhckGeometryQuantize(import[i].vertex.x, bias->x, scale->x, SHRT_MAX);
+      internal[i].vertex.y = _glhckGeometryQuantize(import[i].vertex.y, bias->y, scale->y, SHRT_MAX);
+      internal[i].vertex.z = _glhckGeometryQuantize(import[i].vertex.z, bias->z, scale->z, SHRT_MAX);
       internal[i].normal.x = import[i].normal.x * SHRT_MAX;
       internal[i].normal.y = import[i].normal.y * SHRT_MAX;
       internal[i].normal.z = import[i].normal.z * SHRT_MAX;
@@ -518,14 +309,6 @@ static void _glhckGeometryConvertV3S(const glhckImportVertexData *import, int me
       internal[i].coord.y = import[i].coord.y * SHRT_MAX;
       memcpy(&internal[i].color, &import[i].color, sizeof(glhckColorb));
    }
-
-   /* fix bias after centering */
-   bias->x = brange * (vmax.x - vmin.x) + vmin.x;
-   bias->y = brange * (vmax.y - vmin.y) + vmin.y;
-   bias->z = brange * (vmax.z - vmin.z) + vmin.z;
-   scale->x = (vmax.x - vmin.x) / srange;
-   scale->y = (vmax.y - vmin.y) / srange;
-   scale->z = (vmax.z - vmin.z) / srange;
 }
 
 /* \brief convert import vertex data to V2F */
@@ -544,8 +327,8 @@ static void _glhckGeometryConvertV2F(const glhckImportVertexData *import, int me
       memcpy(&internal[i].normal, &import[i].normal, sizeof(glhckVector3f));
       memcpy(&internal[i].coord, &import[i].coord, sizeof(glhckVector2f));
       memcpy(&internal[i].color, &import[i].color, sizeof(glhckColorb));
-      internal[i].vertex.x = import[i].vertex.x + 0.5f * (vmax.x - vmin.x) + vmin.x;
-      internal[i].vertex.y = import[i].vertex.y + 0.5f * (vmax.y - vmin.y) + vmin.y;
+      internal[i].vertex.x = import[i].vertex.x - (0.5f * (vmax.x - vmin.x) + vmin.x);
+      internal[i].vertex.y = import[i].vertex.y - (0.5f * (vmax.y - vmin.y) + vmin.y);
    }
 
    /* fix bias after centering */
@@ -565,7 +348,7 @@ static void _glhckGeometryConvertV3F(const glhckImportVertexData *import, int me
    internal = out;
 
    _glhckImportVertexDataMaxMin(import, memb, &vmin, &vmax);
-   memcpy(internal, import, memb * sizeof(glhckVertexData3f));
+   if (internal != (void*)import) memcpy(internal, import, memb * sizeof(glhckVertexData3f));
 
    /* center geometry */
    for (i = 0; i < memb; ++i) {
@@ -580,6 +363,61 @@ static void _glhckGeometryConvertV3F(const glhckImportVertexData *import, int me
    bias->z = 0.5f * (vmax.z - vmin.z) + vmin.z;
 }
 
+/* \brief convert import vertex data to V2FP */
+static void _glhckGeometryConvertV2FP(const glhckImportVertexData *import, int memb, void *out, glhckVector3f *bias, glhckVector3f *scale)
+{
+   int i;
+   glhckVector3f vmin, vmax;
+   glhckVertexData2fp *internal;
+   CALL(0, "%p, %d, %p %p, %p", import, memb, out, bias, scale);
+   internal = out;
+
+   _glhckImportVertexDataMaxMin(import, memb, &vmin, &vmax);
+
+   /* center geometry */
+   for (i = 0; i < memb; ++i) {
+      internal[i].vertex.x = import[i].vertex.x - (0.5f * (vmax.x - vmin.x) + vmin.x);
+      internal[i].vertex.y = import[i].vertex.y - (0.5f * (vmax.y - vmin.y) + vmin.y);
+      internal[i].normal = _glhckPackNormal(&import[i].normal);
+      internal[i].coord.x = _glhckFloatToHalf(import[i].coord.x);
+      internal[i].coord.y = _glhckFloatToHalf(import[i].coord.y);
+      memcpy(&internal[i].color, &import[i].color, sizeof(glhckColorb));
+   }
+
+   /* fix bias after centering */
+   bias->x = 0.5f * (vmax.x - vmin.x) + vmin.x;
+   bias->y = 0.5f * (vmax.y - vmin.y) + vmin.y;
+   bias->z = 0.5f * (vmax.z - vmin.z) + vmin.z;
+}
+
+/* \brief convert import vertex data to V3FP */
+static void _glhckGeometryConvertV3FP(const glhckImportVertexData *import, int memb, void *out, glhckVector3f *bias, glhckVector3f *scale)
+{
+   int i;
+   glhckVector3f vmin, vmax;
+   glhckVertexData3fp *internal;
+   CALL(0, "%p, %d, %p %p, %p", import, memb, out, bias, scale);
+   internal = out;
+
+   _glhckImportVertexDataMaxMin(import, memb, &vmin, &vmax);
+
+   /* center geometry */
+   for (i = 0; i < memb; ++i) {
+      internal[i].vertex.x = import[i].vertex.x - (0.5f * (vmax.x - vmin.x) + vmin.x);
+      internal[i].vertex.y = import[i].vertex.y - (0.5f * (vmax.y - vmin.y) + vmin.y);
+      internal[i].vertex.z = import[i].vertex.z - (0.5f * (vmax.z - vmin.z) + vmin.z);
+      internal[i].normal = _glhckPackNormal(&import[i].normal);
+      internal[i].coord.x = _glhckFloatToHalf(import[i].coord.x);
+      internal[i].coord.y = _glhckFloatToHalf(import[i].coord.y);
+      memcpy(&internal[i].color, &import[i].color, sizeof(glhckColorb));
+   }
+
+   /* fix bias after centering */
+   bias->x = 0.5f * (vmax.x - vmin.x) + vmin.x;
+   bias->y = 0.5f * (vmax.y - vmin.y) + vmin.y;
+   bias->z = 0.5f * (vmax.z - vmin.z) + vmin.z;
+}
+
 /* \brief convert import index data to IUB */
 static void _glhckGeometryConvertIUB(const glhckImportIndexData *import, int memb, void *out)
 {
@@ -605,7 +443,135 @@ static void _glhckGeometryConvertIUI(const glhckImportIndexData *import, int mem
 {
    CALL(0, "%p, %d, %p", import, memb, out);
    assert(sizeof(glhckImportIndexData) == sizeof(unsigned int));
-   memcpy(out, import, memb * GLHCKIT(GLHCK_IDX_UINT)->size);
+   if (out != (void*)import) memcpy(out, import, memb * GLHCKIT(GLHCK_IDX_UINT)->size);
+}
+
+/* \brief read position of vertex from vertex data of type
+ * position is in geometry space, bias and scale are not applied */
+int _glhckGeometryVertexPosition(const __GLHCKvertexType *type, const void *vertices, unsigned int index, kmVec3 *out)
+{
+   const char *data = (const char*)vertices + index * type->size + type->offset[0];
+   float v[3] = { 0.0f, 0.0f, 0.0f };
+   int i;
+
+   for (i = 0; i != type->memb[0] && i != 3; ++i) {
+      switch (type->dataType[0]) {
+         case GLHCK_BYTE: v[i] = ((const char*)data)[i]; break;
+         case GLHCK_SHORT: v[i] = ((const short*)data)[i]; break;
+         case GLHCK_FLOAT: v[i] = ((const float*)data)[i]; break;
+         default: return RETURN_FAIL;
+      }
+   }
+
+   kmVec3Fill(out, v[0], v[1], v[2]);
+   return RETURN_OK;
+}
+
+/* \brief write position of vertex to vertex data, type must be readable by _glhckGeometryVertexPosition */
+void _glhckGeometryWriteVertexPosition(const __GLHCKvertexType *type, void *vertices, unsigned int index, const kmVec3 *position)
+{
+   char *data = (char*)vertices + index * type->size + type->offset[0];
+   const float v[3] = { position->x, position->y, position->z };
+   int i;
+
+   for (i = 0; i != type->memb[0] && i != 3; ++i) {
+      switch (type->dataType[0]) {
+         case GLHCK_BYTE: ((char*)data)[i] = (char)floorf((v[i] < CHAR_MIN ? CHAR_MIN : (v[i] > CHAR_MAX ? CHAR_MAX : v[i])) + 0.5f); break;
+         case GLHCK_SHORT: ((short*)data)[i] = (short)floorf((v[i] < SHRT_MIN ? SHRT_MIN : (v[i] > SHRT_MAX ? SHRT_MAX : v[i])) + 0.5f); break;
+         case GLHCK_FLOAT: ((float*)data)[i] = v[i]; break;
+         default: assert(0 && "unsupported vertex position type"); break;
+      }
+   }
+}
+
+/* \brief can vertex type be written vertex by vertex with _glhckGeometryWriteVertex? */
+static int _glhckGeometryCanWriteVertex(const __GLHCKvertexType *type)
+{
+   switch (type->dataType[0]) {
+      case GLHCK_BYTE: case GLHCK_SHORT: case GLHCK_FLOAT: break;
+      default: return 0;
+   }
+   switch (type->dataType[1]) {
+      case GLHCK_BYTE: case GLHCK_SHORT: case GLHCK_FLOAT: case GLHCK_INT_2_10_10_10_REV: break;
+      default: return 0;
+   }
+   switch (type->dataType[2]) {
+      case GLHCK_BYTE: case GLHCK_SHORT: case GLHCK_FLOAT: case GLHCK_HALF_FLOAT: break;
+      default: return 0;
+   }
+   return (type->dataType[3] == GLHCK_UNSIGNED_BYTE);
+}
+
+/* \brief bias and scale of vertex type for positions in [vmin, vmax]
+ * same mapping the convert functions of built-in types use */
+static void _glhckGeometryVertexBiasScale(const __GLHCKvertexType *type, const glhckVector3f *vmin, const glhckVector3f *vmax,
+      glhckVector3f *bias, glhckVector3f *scale)
+{
+   if (type->dataType[0] == GLHCK_FLOAT) {
+      /* float positions are only centered */
+      bias->x = 0.5f * (vmax->x - vmin->x) + vmin->x;
+      bias->y = 0.5f * (vmax->y - vmin->y) + vmin->y;
+      bias->z = 0.5f * (vmax->z - vmin->z) + vmin->z;
+      scale->x = scale->y = scale->z = 1.0f;
+      return;
+   }
+
+   _glhckGeometryQuantization(vmin, vmax, type->max[0], bias, scale);
+
+   /* there is no z, so keep it in the center */
+   if (type->memb[0] < 3) {
+      bias->z = 0.5f * (vmax->z - vmin->z) + vmin->z;
+      scale->z = 1.0f;
+   }
+}
+
+/* \brief write import vertex as one vertex of type, type must pass _glhckGeometryCanWriteVertex */
+static void _glhckGeometryWriteVertex(const __GLHCKvertexType *type, void *out, const glhckImportVertexData *vertex,
+      const glhckVector3f *bias, const glhckVector3f *scale)
+{
+   const float position[3] = { vertex->vertex.x, vertex->vertex.y, vertex->vertex.z };
+   const float normal[3] = { vertex->normal.x, vertex->normal.y, vertex->normal.z };
+   const float coord[2] = { vertex->coord.x, vertex->coord.y };
+   const float b[3] = { bias->x, bias->y, bias->z };
+   const float s[3] = { scale->x, scale->y, scale->z };
+   unsigned int packed;
+   char *data;
+   int i;
+
+   data = (char*)out + type->offset[0];
+   for (i = 0; i != type->memb[0] && i != 3; ++i) {
+      switch (type->dataType[0]) {
+         case GLHCK_BYTE: ((char*)data)[i] = _glhckGeometryQuantize(position[i], b[i], s[i], CHAR_MAX); break;
+         case GLHCK_SHORT: ((short*)data)[i] = _glhckGeometryQuantize(position[i], b[i], s[i], SHRT_MAX); break;
+         default: ((float*)data)[i] = position[i] - b[i]; break;
+      }
+   }
+
+   data = (char*)out + type->offset[1];
+   if (type->dataType[1] == GLHCK_INT_2_10_10_10_REV) {
+      packed = _glhckPackNormal(&vertex->normal);
+      memcpy(data, &packed, sizeof(unsigned int));
+   } else {
+      for (i = 0; i != type->memb[1] && i != 3; ++i) {
+         switch (type->dataType[1]) {
+            case GLHCK_BYTE: ((char*)data)[i] = normal[i] * CHAR_MAX; break;
+            case GLHCK_SHORT: ((short*)data)[i] = normal[i] * SHRT_MAX; break;
+            default: ((float*)data)[i] = normal[i]; break;
+         }
+      }
+   }
+
+   data = (char*)out + type->offset[2];
+   for (i = 0; i != type->memb[2] && i != 2; ++i) {
+      switch (type->dataType[2]) {
+         case GLHCK_BYTE: ((char*)data)[i] = coord[i] * CHAR_MAX; break;
+         case GLHCK_SHORT: ((short*)data)[i] = coord[i] * SHRT_MAX; break;
+         case GLHCK_HALF_FLOAT: ((unsigned short*)data)[i] = _glhckFloatToHalf(coord[i]); break;
+         default: ((float*)data)[i] = coord[i]; break;
+      }
+   }
+
+   memcpy((char*)out + type->offset[3], &vertex->color, sizeof(glhckColorb));
 }
 
 #define GLHCK_API_CHECK(x) \
@@ -623,7 +589,6 @@ int glhckGeometryAddVertexType(const glhckVertexTypeFunctionMap *api, const glhc
 
    GLHCK_API_CHECK(convert);
    GLHCK_API_CHECK(minMax);
-   GLHCK_API_CHECK(transform);
 
    for (i = 0; i < GLHCKW()->numVertexTypes; ++i) {
       if (!memcmp(GLHCKW()->vertexType[i].dataType, dataType, 4 * sizeof(glhckDataType)) &&
@@ -749,8 +714,7 @@ int _glhckGeometryInit(void)
       glhckVertexTypeFunctionMap map;
       memset(&map, 0, sizeof(glhckVertexTypeFunctionMap));
       map.convert = _glhckGeometryConvertV3F;
-      map.minMax = _glhckGeometryMinMaxV3F;
-      map.transform = _glhckGeometryTransformV3F;
+      map.minMax = _glhckGeometryMinMax;
       if (glhckGeometryAddVertexType(&map, dataType, memb, offset, sizeof(glhckVertexData3f)) != GLHCK_VTX_V3F)
          goto fail;
    }
@@ -768,8 +732,7 @@ int _glhckGeometryInit(void)
       glhckVertexTypeFunctionMap map;
       memset(&map, 0, sizeof(glhckVertexTypeFunctionMap));
       map.convert = _glhckGeometryConvertV2F;
-      map.minMax = _glhckGeometryMinMaxV2F;
-      map.transform = _glhckGeometryTransformV2F;
+      map.minMax = _glhckGeometryMinMax;
       if (glhckGeometryAddVertexType(&map, dataType, memb, offset, sizeof(glhckVertexData2f)) != GLHCK_VTX_V2F)
          goto fail;
    }
@@ -787,8 +750,7 @@ int _glhckGeometryInit(void)
       glhckVertexTypeFunctionMap map;
       memset(&map, 0, sizeof(glhckVertexTypeFunctionMap));
       map.convert = _glhckGeometryConvertV3S;
-      map.minMax = _glhckGeometryMinMaxV3S;
-      map.transform = _glhckGeometryTransformV3S;
+      map.minMax = _glhckGeometryMinMax;
       if (glhckGeometryAddVertexType(&map, dataType, memb, offset, sizeof(glhckVertexData3s)) != GLHCK_VTX_V3S)
          goto fail;
    }
@@ -806,8 +768,7 @@ int _glhckGeometryInit(void)
       glhckVertexTypeFunctionMap map;
       memset(&map, 0, sizeof(glhckVertexTypeFunctionMap));
       map.convert = _glhckGeometryConvertV2S;
-      map.minMax = _glhckGeometryMinMaxV2S;
-      map.transform = _glhckGeometryTransformV2S;
+      map.minMax = _glhckGeometryMinMax;
       if (glhckGeometryAddVertexType(&map, dataType, memb, offset, sizeof(glhckVertexData2s)) != GLHCK_VTX_V2S)
          goto fail;
    }
@@ -825,8 +786,7 @@ int _glhckGeometryInit(void)
       glhckVertexTypeFunctionMap map;
       memset(&map, 0, sizeof(glhckVertexTypeFunctionMap));
       map.convert = _glhckGeometryConvertV3B;
-      map.minMax = _glhckGeometryMinMaxV3B;
-      map.transform = _glhckGeometryTransformV3B;
+      map.minMax = _glhckGeometryMinMax;
       if (glhckGeometryAddVertexType(&map, dataType, memb, offset, sizeof(glhckVertexData3b)) != GLHCK_VTX_V3B)
          goto fail;
    }
@@ -844,12 +804,47 @@ int _glhckGeometryInit(void)
       glhckVertexTypeFunctionMap map;
       memset(&map, 0, sizeof(glhckVertexTypeFunctionMap));
       map.convert = _glhckGeometryConvertV2B;
-      map.minMax = _glhckGeometryMinMaxV2B;
-      map.transform = _glhckGeometryTransformV2B;
+      map.minMax = _glhckGeometryMinMax;
       if (glhckGeometryAddVertexType(&map, dataType, memb, offset, sizeof(glhckVertexData2b)) != GLHCK_VTX_V2B)
          goto fail;
    }
 
+   /* V3FP */
+   {
+      size_t offset[4] = {
+         offsetof(glhckVertexData3fp, vertex),
+         offsetof(glhckVertexData3fp, normal),
+         offsetof(glhckVertexData3fp, coord),
+         offsetof(glhckVertexData3fp, color)
+      };
+      char memb[4] = { 3, 4, 2, 4 };
+      glhckDataType dataType[4] = { GLHCK_FLOAT, GLHCK_INT_2_10_10_10_REV, GLHCK_HALF_FLOAT, GLHCK_UNSIGNED_BYTE };
+      glhckVertexTypeFunctionMap map;
+      memset(&map, 0, sizeof(glhckVertexTypeFunctionMap));
+      map.convert = _glhckGeometryConvertV3FP;
+      map.minMax = _glhckGeometryMinMax;
+      if (glhckGeometryAddVertexType(&map, dataType, memb, offset, sizeof(glhckVertexData3fp)) != GLHCK_VTX_V3FP)
+         goto fail;
+   }
+
+   /* V2FP */
+   {
+      size_t offset[4] = {
+         offsetof(glhckVertexData2fp, vertex),
+         offsetof(glhckVertexData2fp, normal),
+         offsetof(glhckVertexData2fp, coord),
+         offsetof(glhckVertexData2fp, color)
+      };
+      char memb[4] = { 2, 4, 2, 4 };
+      glhckDataType dataType[4] = { GLHCK_FLOAT, GLHCK_INT_2_10_10_10_REV, GLHCK_HALF_FLOAT, GLHCK_UNSIGNED_BYTE };
+      glhckVertexTypeFunctionMap map;
+      memset(&map, 0, sizeof(glhckVertexTypeFunctionMap));
+      map.convert = _glhckGeometryConvertV2FP;
+      map.minMax = _glhckGeometryMinMax;
+      if (glhckGeometryAddVertexType(&map, dataType, memb, offset, sizeof(glhckVertexData2fp)) != GLHCK_VTX_V2FP)
+         goto fail;
+   }
+
    return RETURN_OK;
 
 fail:
@@ -868,10 +863,24 @@ void _glhckGeometryTerminate(void)
    GLHCKW()->numVertexTypes = 0;
 }
 
+/* \brief release vertex or index data, with the callback it was adopted with */
+static void _glhckGeometryReleaseData(void **data, glhckGeometryReleaseFunc *release, void **userData)
+{
+   if (*data) {
+      if (*release) (*release)(*data, *userData);
+      else _glhckFree(*data);
+   }
+
+   *data = NULL;
+   *release = NULL;
+   *userData = NULL;
+}
+
 /* \brief free geometry's vertex data */
 static void _glhckGeometryFreeVertices(glhckGeometry *object)
 {
-   IFDO(_glhckFree, object->vertices);
+   _glhckGeometryFreeMeshlets(object);
+   _glhckGeometryReleaseData(&object->vertices, &object->vertexRelease, &object->vertexReleaseData);
    object->vertexType   = GLHCK_VTX_AUTO;
    object->vertexCount  = 0;
    object->textureRange = 1;
@@ -885,13 +894,15 @@ static void _glhckGeometrySetVertices(glhckGeometry *object, unsigned char type,
    object->vertexType   = type;
    object->vertexCount  = memb;
    object->textureRange = GLHCKVT(type)->max[2];
+   object->error        = 0.0f;
 }
 
 /* \brief free indices from object */
 static void _glhckGeometryFreeIndices(glhckGeometry *object)
 {
    /* set index type to none */
-   IFDO(_glhckFree, object->indices);
+   _glhckGeometryFreeMeshlets(object);
+   _glhckGeometryReleaseData(&object->indices, &object->indexRelease, &object->indexReleaseData);
    object->indexType  = GLHCK_IDX_AUTO;
    object->indexCount = 0;
 }
@@ -905,6 +916,121 @@ static void _glhckGeometrySetIndices(glhckGeometry *object, unsigned char type,
    object->indexCount = memb;
 }
 
+/* \brief worst case position error of vertex type for bounds, FLT_MAX if it can't represent them */
+static float _glhckGeometryPositionError(const __GLHCKvertexType *type, const glhckVector3f *vmin, const glhckVector3f *vmax)
+{
+   float step[3];
+   unsigned int i;
+
+   /* 2D types lose z, unless it's flat */
+   if (type->memb[0] < 3 && vmax->z > vmin->z)
+      return FLT_MAX;
+
+   switch (type->dataType[0]) {
+      case GLHCK_FLOAT: return 0.0f;
+      case GLHCK_BYTE: case GLHCK_SHORT: break;
+      default: return FLT_MAX;
+   }
+
+   /* rounding error is half of quantization step on each axis */
+   step[0] = (vmax->x - vmin->x) / (2.0f * (type->max[0] - 1.0f));
+   step[1] = (vmax->y - vmin->y) / (2.0f * (type->max[0] - 1.0f));
+   step[2] = (type->memb[0] < 3 ? 0.0f : (vmax->z - vmin->z) / (2.0f * (type->max[0] - 1.0f)));
+   for (i = 0; i != 3; ++i) step[i] *= 0.5f;
+   return sqrtf(step[0] * step[0] + step[1] * step[1] + step[2] * step[2]);
+}
+
+/* \brief worst case texture coordinate error of vertex type, FLT_MAX if it can't represent them */
+static float _glhckGeometryCoordError(const __GLHCKvertexType *type, float coordMax)
+{
+   switch (type->dataType[2]) {
+      case GLHCK_FLOAT: return 0.0f;
+      case GLHCK_HALF_FLOAT: return (coordMax > 65504.0f ? FLT_MAX : coordMax / 4096.0f);
+      case GLHCK_BYTE: case GLHCK_SHORT: return (coordMax > 1.0f ? FLT_MAX : 0.5f / type->max[2]);
+      default: return FLT_MAX;
+   }
+}
+
+/* \brief pick the smallest vertex type that keeps positions in bounds within global error bound.
+ * texture coordinates must stay within 1/4096 (texel of 4K texture). */
+static unsigned char _glhckGeometryPickVertexType(const glhckVector3f *vmin, const glhckVector3f *vmax, float coordMax)
+{
+   int i;
+   unsigned char type, best = GLHCK_VTX_V3F;
+   float error;
+   const __GLHCKvertexType *vt;
+
+   if ((error = GLHCKM()->globalVertexError) <= 0.0f)
+      return GLHCK_VTX_V3F;
+
+   for (type = 0; type < GLHCKW()->numVertexTypes; ++type) {
+      vt = GLHCKVT(type);
+
+      /* renderer must be able to draw packed and half float attributes */
+      for (i = 0; i != 4; ++i) {
+         if ((vt->dataType[i] == GLHCK_HALF_FLOAT || vt->dataType[i] == GLHCK_INT_2_10_10_10_REV) &&
+               !GLHCKRF()->vertex.hasPackedAttributes)
+            break;
+      }
+
+      if (i != 4 || vt->size >= GLHCKVT(best)->size) continue;
+      if (_glhckGeometryPositionError(vt, vmin, vmax) > error) continue;
+      if (_glhckGeometryCoordError(vt, coordMax) > 1.0f / 4096.0f) continue;
+      best = type;
+   }
+
+   return best;
+}
+
+/* \brief pick vertex type for import vertices against global error bound */
+static unsigned char _glhckGeometryAutoVertexType(const glhckImportVertexData *vertices, int memb)
+{
+   int i;
+   float coordMax = 0.0f;
+   glhckVector3f vmin, vmax;
+
+   if (GLHCKM()->globalVertexError <= 0.0f || memb <= 0)
+      return GLHCK_VTX_V3F;
+
+   _glhckImportVertexDataMaxMin(vertices, memb, &vmin, &vmax);
+   for (i = 0; i < memb; ++i) {
+      if (fabsf(vertices[i].coord.x) > coordMax) coordMax = fabsf(vertices[i].coord.x);
+      if (fabsf(vertices[i].coord.y) > coordMax) coordMax = fabsf(vertices[i].coord.y);
+   }
+
+   return _glhckGeometryPickVertexType(&vmin, &vmax, coordMax);
+}
+
+/* \brief squared distance of decoded vertex position from original position */
+static float _glhckGeometryPositionDistance(const __GLHCKvertexType *type, const void *vertices, unsigned int index,
+      const glhckVector3f *bias, const glhckVector3f *scale, const glhckVector3f *position)
+{
+   kmVec3 v;
+
+   if (_glhckGeometryVertexPosition(type, vertices, index, &v) != RETURN_OK)
+      return 0.0f;
+
+   v.x = v.x * scale->x + bias->x - position->x;
+   v.y = v.y * scale->y + bias->y - position->y;
+   v.z = (type->memb[0] < 3 ? bias->z : v.z * scale->z + bias->z) - position->z;
+   return v.x * v.x + v.y * v.y + v.z * v.z;
+}
+
+/* \brief measure maximum position error of converted vertices against import data */
+static float _glhckGeometryMeasureError(const glhckGeometry *object, const glhckImportVertexData *vertices, int memb)
+{
+   int i;
+   float d, error = 0.0f;
+   const __GLHCKvertexType *type = GLHCKVT(object->vertexType);
+
+   for (i = 0; i < memb; ++i) {
+      d = _glhckGeometryPositionDistance(type, object->vertices, i, &object->bias, &object->scale, &vertices[i].vertex);
+      if (d > error) error = d;
+   }
+
+   return sqrtf(error);
+}
+
 /* \brief insert vertices into object */
 int _glhckGeometryInsertVertices(glhckGeometry *object, int memb, unsigned char type, const glhckImportVertexData *vertices)
 {
@@ -912,6 +1038,10 @@ int _glhckGeometryInsertVertices(glhckGeometry *object, int memb, unsigned char
    CALL(0, "%p, %d, %u, %p", object, memb, type, vertices);
    assert(object);
 
+   /* pick precision against error bound */
+   if (type == GLHCK_VTX_AUTO)
+      type = _glhckGeometryAutoVertexType(vertices, memb);
+
    /* check vertex type */
    type = _glhckGeometryCheckVertexType(type);
 
@@ -929,6 +1059,8 @@ int _glhckGeometryInsertVertices(glhckGeometry *object, int memb, unsigned char
    object->scale.x = object->scale.y = object->scale.z = 1.0f;
    GLHCKVT(type)->api.convert(vertices, memb, data, &object->bias, &object->scale);
    _glhckGeometrySetVertices(object, type, data, memb);
+   object->error = _glhckGeometryMeasureError(object, vertices, memb);
+   DEBUG(GLHCK_DBG_CRAP, "Geometry(%p) vertex type %u, position error %f", object, type, object->error);
 
    RET(0, "%d", RETURN_OK);
    return RETURN_OK;
@@ -978,6 +1110,154 @@ fail:
    return RETURN_FAIL;
 }
 
+/* \brief insert import vertices into object, taking ownership of the buffer
+ * import layout is the V3F layout, so V3F is converted in place and kept,
+ * other types are converted to a new buffer and the import buffer is released.
+ * the buffer is released on failure too. */
+int _glhckGeometryAdoptImportVertices(glhckGeometry *object, int memb, unsigned char type, glhckImportVertexData *vertices)
+{
+   int ret;
+   CALL(0, "%p, %d, %u, %p", object, memb, type, vertices);
+   assert(object && vertices);
+
+   if (type == GLHCK_VTX_AUTO)
+      type = _glhckGeometryAutoVertexType(vertices, memb);
+   type = _glhckGeometryCheckVertexType(type);
+
+   /* insert reports the precision conflict */
+   if (type != GLHCK_VTX_V3F || (object->indexType != GLHCK_IDX_AUTO &&
+       (glhckImportIndexData)memb > GLHCKIT(object->indexType)->max)) {
+      ret = _glhckGeometryInsertVertices(object, memb, type, vertices);
+      _glhckFree(vertices);
+      RET(0, "%d", ret);
+      return ret;
+   }
+
+   memset(&object->bias, 0, sizeof(glhckVector3f));
+   object->scale.x = object->scale.y = object->scale.z = 1.0f;
+   GLHCKVT(type)->api.convert(vertices, memb, vertices, &object->bias, &object->scale);
+   _glhckGeometrySetVertices(object, type, vertices, memb);
+   DEBUG(GLHCK_DBG_CRAP, "Geometry(%p) adopted %d V3F vertices", object, memb);
+
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+}
+
+/* \brief insert import indices into object, taking ownership of the buffer
+ * UINT indices are kept as they are, other types are converted to a new buffer
+ * and the import buffer is released. the buffer is released on failure too. */
+int _glhckGeometryAdoptImportIndices(glhckGeometry *object, int memb, unsigned char type, glhckImportIndexData *indices)
+{
+   int ret;
+   CALL(0, "%p, %d, %u, %p", object, memb, type, indices);
+   assert(object && indices);
+
+   type = _glhckGeometryCheckIndexType(type, indices, memb);
+
+   /* insert reports the precision conflict */
+   if (type != GLHCK_IDX_UINT || (glhckImportIndexData)object->vertexCount > GLHCKIT(type)->max) {
+      ret = _glhckGeometryInsertIndices(object, memb, type, indices);
+      _glhckFree(indices);
+      RET(0, "%d", ret);
+      return ret;
+   }
+
+   _glhckGeometrySetIndices(object, type, indices, memb);
+   DEBUG(GLHCK_DBG_CRAP, "Geometry(%p) adopted %d UINT indices", object, memb);
+
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+}
+
+/* \brief stream vertices from importer straight to the vertex type of object.
+ * func decodes source vertex at index and is called twice for each vertex,
+ * first pass gathers bounds and texture coordinate range for picking the type and quantization,
+ * second pass writes the final vertices. built-in types need no import vertex buffer at all. */
+int _glhckGeometryStreamVertices(glhckGeometry *object, int memb, unsigned char type, __GLHCKgeometryVertexFunc func, void *userData)
+{
+   int i, ret;
+   float d, coordMax = 0.0f, error = 0.0f;
+   void *data = NULL;
+   glhckImportVertexData vertex, *vertices = NULL;
+   glhckVector3f vmin, vmax, bias, scale;
+   const __GLHCKvertexType *vt;
+   CALL(0, "%p, %d, %u, %p, %p", object, memb, type, func, userData);
+   assert(object && func);
+
+   memset(&vmin, 0, sizeof(glhckVector3f));
+   memset(&vmax, 0, sizeof(glhckVector3f));
+   for (i = 0; i < memb; ++i) {
+      func(userData, i, &vertex);
+      if (!i) {
+         memcpy(&vmin, &vertex.vertex, sizeof(glhckVector3f));
+         memcpy(&vmax, &vertex.vertex, sizeof(glhckVector3f));
+      }
+
+      if (vertex.vertex.x < vmin.x) vmin.x = vertex.vertex.x;
+      if (vertex.vertex.y < vmin.y) vmin.y = vertex.vertex.y;
+      if (vertex.vertex.z < vmin.z) vmin.z = vertex.vertex.z;
+      if (vertex.vertex.x > vmax.x) vmax.x = vertex.vertex.x;
+      if (vertex.vertex.y > vmax.y) vmax.y = vertex.vertex.y;
+      if (vertex.vertex.z > vmax.z) vmax.z = vertex.vertex.z;
+      if (fabsf(vertex.coord.x) > coordMax) coordMax = fabsf(vertex.coord.x);
+      if (fabsf(vertex.coord.y) > coordMax) coordMax = fabsf(vertex.coord.y);
+   }
+
+   /* pick precision against error bound */
+   if (type == GLHCK_VTX_AUTO)
+      type = (memb > 0 ? _glhckGeometryPickVertexType(&vmin, &vmax, coordMax) : GLHCK_VTX_V3F);
+
+   type = _glhckGeometryCheckVertexType(type);
+   vt = GLHCKVT(type);
+
+   /* check vertex precision conflicts */
+   if (object->indexType != GLHCK_IDX_AUTO &&
+      (glhckImportIndexData)memb > GLHCKIT(object->indexType)->max)
+      goto bad_precision;
+
+   /* vertex types added by user only know how to convert import data */
+   if (!_glhckGeometryCanWriteVertex(vt)) {
+      if (!(vertices = _glhckMalloc(memb * sizeof(glhckImportVertexData))))
+         goto fail;
+
+      for (i = 0; i < memb; ++i) func(userData, i, &vertices[i]);
+      ret = _glhckGeometryInsertVertices(object, memb, type, vertices);
+      _glhckFree(vertices);
+      RET(0, "%d", ret);
+      return ret;
+   }
+
+   /* zeroed, so padding of vertices compares equal when welding */
+   if (!(data = _glhckCalloc(memb, vt->size)))
+      goto fail;
+
+   _glhckGeometryVertexBiasScale(vt, &vmin, &vmax, &bias, &scale);
+   for (i = 0; i < memb; ++i) {
+      func(userData, i, &vertex);
+      _glhckGeometryWriteVertex(vt, (char*)data + i * vt->size, &vertex, &bias, &scale);
+      d = _glhckGeometryPositionDistance(vt, data, i, &bias, &scale, &vertex.vertex);
+      if (d > error) error = d;
+   }
+
+   _glhckGeometrySetVertices(object, type, data, memb);
+   memcpy(&object->bias, &bias, sizeof(glhckVector3f));
+   memcpy(&object->scale, &scale, sizeof(glhckVector3f));
+   object->error = sqrtf(error);
+   DEBUG(GLHCK_DBG_CRAP, "Geometry(%p) streamed %d vertices to type %u, position error %f", object, memb, type, object->error);
+
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+
+bad_precision:
+   DEBUG(GLHCK_DBG_ERROR, "Internal indices precision is %zu, however there are more vertices\n"
+                          "in geometry(%p) than index can hold.",
+                          GLHCKIT(object->indexType)->max,
+                          object);
+fail:
+   RET(0, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
 /* \brief create new geometry object */
 glhckGeometry* _glhckGeometryNew(void)
 {
@@ -1002,6 +1282,9 @@ glhckGeometry* _glhckGeometryCopy(glhckGeometry *src)
 
    if (src->vertices) object->vertices =_glhckCopy(src->vertices, src->vertexCount * GLHCKVT(object->vertexType)->size);
    if (src->indices) object->indices = _glhckCopy(src->indices, src->indexCount * GLHCKIT(object->indexType)->size);
+   object->vertexRelease = object->indexRelease = NULL;
+   object->vertexReleaseData = object->indexReleaseData = NULL;
+   if (src->meshlets && !(object->meshlets = _glhckCopy(src->meshlets, src->meshletCount * sizeof(glhckMeshlet)))) object->meshletCount = 0;
    return object;
 }
 
@@ -1076,4 +1359,84 @@ fail:
    return RETURN_FAIL;
 }
 
+/* \brief give vertices already in the format of type to geometry, without copying them
+ * release is called with data and userData once geometry no longer uses the data,
+ * NULL release means the data was allocated with glhck's allocator and geometry frees it.
+ * on failure data is not adopted and stays with the caller.
+ *
+ * NOTE: glhck may modify adopted data in place (optimization, meshlets),
+ * bias and scale of geometry are kept as they are, like with glhckGeometryInsertVertices. */
+GLHCKAPI int glhckGeometryAdoptVertices(glhckGeometry *object, unsigned char type, void *data, int memb,
+      glhckGeometryReleaseFunc release, void *userData)
+{
+   CALL(0, "%p, %u, %p, %d, %p, %p", object, type, data, memb, release, userData);
+   assert(object && data && memb > 0);
+
+   if (type == GLHCK_VTX_AUTO || type >= GLHCKW()->numVertexTypes)
+      goto bad_type;
+
+   if (object->indexType != GLHCK_IDX_AUTO &&
+      (glhckImportIndexData)memb > GLHCKIT(object->indexType)->max)
+      goto bad_precision;
+
+   _glhckGeometrySetVertices(object, type, data, memb);
+   object->vertexRelease = release;
+   object->vertexReleaseData = userData;
+
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+
+bad_type:
+   DEBUG(GLHCK_DBG_ERROR, "Adopted vertices need concrete vertex type, got %u", type);
+   goto fail;
+bad_precision:
+   DEBUG(GLHCK_DBG_ERROR, "Internal indices precision is %zu, however there are more vertices\n"
+                          "in geometry(%p) than index can hold.",
+                          GLHCKIT(object->indexType)->max,
+                          object);
+fail:
+   RET(0, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
+/* \brief give indices already in the format of type to geometry, without copying them
+ * release works like with glhckGeometryAdoptVertices. */
+GLHCKAPI int glhckGeometryAdoptIndices(glhckGeometry *object, unsigned char type, void *data, int memb,
+      glhckGeometryReleaseFunc release, void *userData)
+{
+   CALL(0, "%p, %u, %p, %d, %p, %p", object, type, data, memb, release, userData);
+   assert(object && data && memb > 0);
+
+   if (type == GLHCK_IDX_AUTO || type >= GLHCKW()->numIndexTypes)
+      goto bad_type;
+
+#if EMSCRIPTEN
+   /* emscripten works with USHRT indices atm only */
+   if (type != GLHCK_IDX_USHRT)
+      goto bad_type;
+#endif
+
+   if ((glhckImportIndexData)object->vertexCount > GLHCKIT(type)->max)
+      goto bad_precision;
+
+   _glhckGeometrySetIndices(object, type, data, memb);
+   object->indexRelease = release;
+   object->indexReleaseData = userData;
+
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+
+bad_type:
+   DEBUG(GLHCK_DBG_ERROR, "Index type %u can't be adopted", type);
+   goto fail;
+bad_precision:
+   DEBUG(GLHCK_DBG_ERROR, "Internal indices precision is %zu, however there are more vertices\n"
+                          "in geometry(%p) than index can hold.",
+                          GLHCKIT(type)->max,
+                          object);
+fail:
+   RET(0, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
 /* vim: set ts=8 sw=3 tw=0 :*/
@@ -0,0 +1,246 @@
+#include "../internal.h"
+#include <assert.h> /* for assert */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define GLHCK_BOUNDS_SSE2 1
+#endif
+
+/* tracing channel for this file */
+#define GLHCK_CHANNEL GLHCK_CHANNEL_GEOMETRY
+
+/* Bounds of geometry positions.
+ *
+ * Positions are interleaved with other attributes, so each vertex is loaded
+ * whole to a SSE register and all of its components are reduced at once.
+ * Loads read past the position into the next attribute, the extra lanes are ignored.
+ * Very large buffers are split to slices that are reduced on job threads. */
+
+/* vertices in one job slice, smaller buffers are reduced on calling thread */
+#define GLHCK_BOUNDS_SLICE 65536
+
+/* bounds of one slice, 4 lanes so SIMD can store directly */
+typedef struct __GLHCKboundsSlice {
+   float min[4], max[4];
+} __GLHCKboundsSlice;
+
+/* job data for sliced reduction */
+typedef struct __GLHCKboundsJob {
+   const char *data;
+   __GLHCKboundsSlice *slices;
+   size_t stride;
+   unsigned int count, memb;
+   glhckDataType dataType;
+   char wide;
+} __GLHCKboundsJob;
+
+/* \brief bounds of float positions */
+static void _glhckBoundsFloat(const char *data, size_t stride, unsigned int count, unsigned int memb, char wide, __GLHCKboundsSlice *out)
+{
+   unsigned int i, c;
+   const float *v;
+
+#if GLHCK_BOUNDS_SSE2
+   if (wide) {
+      __m128 vmin, vmax, p;
+      vmin = vmax = _mm_loadu_ps((const float*)data);
+      for (i = 1; i < count; ++i) {
+         p = _mm_loadu_ps((const float*)(data + i * stride));
+         vmin = _mm_min_ps(vmin, p);
+         vmax = _mm_max_ps(vmax, p);
+      }
+      _mm_storeu_ps(out->min, vmin);
+      _mm_storeu_ps(out->max, vmax);
+      return;
+   }
+#else
+   (void)wide;
+#endif
+
+   v = (const float*)data;
+   for (c = 0; c != memb; ++c) out->min[c] = out->max[c] = v[c];
+   for (i = 1; i < count; ++i) {
+      v = (const float*)(data + i * stride);
+      for (c = 0; c != memb; ++c) {
+         if (v[c] < out->min[c]) out->min[c] = v[c];
+         if (v[c] > out->max[c]) out->max[c] = v[c];
+      }
+   }
+}
+
+/* \brief bounds of short positions */
+static void _glhckBoundsShort(const char *data, size_t stride, unsigned int count, unsigned int memb, char wide, __GLHCKboundsSlice *out)
+{
+   unsigned int i, c;
+   short vmin[4], vmax[4];
+   const short *v;
+
+#if GLHCK_BOUNDS_SSE2
+   if (wide) {
+      __m128i smin, smax, p;
+      smin = smax = _mm_loadl_epi64((const __m128i*)data);
+      for (i = 1; i < count; ++i) {
+         p = _mm_loadl_epi64((const __m128i*)(data + i * stride));
+         smin = _mm_min_epi16(smin, p);
+         smax = _mm_max_epi16(smax, p);
+      }
+      _mm_storel_epi64((__m128i*)vmin, smin);
+      _mm_storel_epi64((__m128i*)vmax, smax);
+      for (c = 0; c != memb; ++c) out->min[c] = vmin[c], out->max[c] = vmax[c];
+      return;
+   }
+#else
+   (void)wide;
+#endif
+
+   v = (const short*)data;
+   for (c = 0; c != memb; ++c) vmin[c] = vmax[c] = v[c];
+   for (i = 1; i < count; ++i) {
+      v = (const short*)(data + i * stride);
+      for (c = 0; c != memb; ++c) {
+         if (v[c] < vmin[c]) vmin[c] = v[c];
+         if (v[c] > vmax[c]) vmax[c] = v[c];
+      }
+   }
+   for (c = 0; c != memb; ++c) out->min[c] = vmin[c], out->max[c] = vmax[c];
+}
+
+/* \brief bounds of byte positions */
+static void _glhckBoundsByte(const char *data, size_t stride, unsigned int count, unsigned int memb, char wide, __GLHCKboundsSlice *out)
+{
+   unsigned int i, c;
+   signed char vmin[4], vmax[4];
+   const signed char *v;
+
+#if GLHCK_BOUNDS_SSE2
+   if (wide) {
+      /* SSE2 has only unsigned byte min/max, flipping the sign bit keeps the order */
+      const __m128i sign = _mm_set1_epi8((char)0x80);
+      __m128i bmin, bmax, p;
+      int word;
+      memcpy(&word, data, sizeof(int));
+      bmin = bmax = _mm_xor_si128(_mm_cvtsi32_si128(word), sign);
+      for (i = 1; i < count; ++i) {
+         memcpy(&word, data + i * stride, sizeof(int));
+         p = _mm_xor_si128(_mm_cvtsi32_si128(word), sign);
+         bmin = _mm_min_epu8(bmin, p);
+         bmax = _mm_max_epu8(bmax, p);
+      }
+      word = _mm_cvtsi128_si32(_mm_xor_si128(bmin, sign));
+      memcpy(vmin, &word, sizeof(int));
+      word = _mm_cvtsi128_si32(_mm_xor_si128(bmax, sign));
+      memcpy(vmax, &word, sizeof(int));
+      for (c = 0; c != memb; ++c) out->min[c] = vmin[c], out->max[c] = vmax[c];
+      return;
+   }
+#else
+   (void)wide;
+#endif
+
+   v = (const signed char*)data;
+   for (c = 0; c != memb; ++c) vmin[c] = vmax[c] = v[c];
+   for (i = 1; i < count; ++i) {
+      v = (const signed char*)(data + i * stride);
+      for (c = 0; c != memb; ++c) {
+         if (v[c] < vmin[c]) vmin[c] = v[c];
+         if (v[c] > vmax[c]) vmax[c] = v[c];
+      }
+   }
+   for (c = 0; c != memb; ++c) out->min[c] = vmin[c], out->max[c] = vmax[c];
+}
+
+/* \brief reduce positions with kernel for data type */
+static void _glhckBoundsReduce(glhckDataType dataType, const char *data, size_t stride, unsigned int count, unsigned int memb, char wide, __GLHCKboundsSlice *out)
+{
+   switch (dataType) {
+      case GLHCK_FLOAT: _glhckBoundsFloat(data, stride, count, memb, wide, out); break;
+      case GLHCK_SHORT: _glhckBoundsShort(data, stride, count, memb, wide, out); break;
+      case GLHCK_BYTE: _glhckBoundsByte(data, stride, count, memb, wide, out); break;
+      default: assert(0 && "unsupported vertex position type"); break;
+   }
+}
+
+/* \brief reduce one slice on job thread */
+static void _glhckBoundsJob(void *userData, unsigned int index)
+{
+   __GLHCKboundsJob *job = userData;
+   unsigned int first = index * GLHCK_BOUNDS_SLICE;
+   unsigned int count = (job->count - first < GLHCK_BOUNDS_SLICE ? job->count - first : GLHCK_BOUNDS_SLICE);
+   _glhckBoundsReduce(job->dataType, job->data + first * job->stride, job->stride, count, job->memb, job->wide, &job->slices[index]);
+}
+
+/* \brief get min && max of interleaved BYTE, SHORT or FLOAT positions
+ * readable is how many bytes of each vertex can be read from the position onwards,
+ * components past memb are left untouched */
+void _glhckPositionsMinMax(const void *positions, size_t stride, size_t readable, unsigned int count,
+      glhckDataType dataType, unsigned int memb, glhckVector3f *min, glhckVector3f *max)
+{
+   unsigned int i, c, numSlices;
+   size_t width;
+   __GLHCKboundsSlice bounds, *slices;
+   __GLHCKboundsJob job;
+   assert(positions && min && max);
+
+   if (!count)
+      return;
+
+   /* SIMD loads 4 components, which must stay inside the vertex */
+   switch (dataType) {
+      case GLHCK_FLOAT: width = 4 * sizeof(float); break;
+      case GLHCK_SHORT: width = 4 * sizeof(short); break;
+      case GLHCK_BYTE: width = 4; break;
+      default:
+         DEBUG(GLHCK_DBG_ERROR, "Unsupported position data type %u", dataType);
+         return;
+   }
+
+   memset(&job, 0, sizeof(job));
+   job.data = positions;
+   job.stride = stride;
+   job.count = count;
+   job.dataType = dataType;
+   job.memb = (memb < 3 ? memb : 3);
+   job.wide = (width <= readable);
+
+   numSlices = (count + GLHCK_BOUNDS_SLICE - 1) / GLHCK_BOUNDS_SLICE;
+   if (numSlices > 1 && (slices = _glhckMalloc(numSlices * sizeof(__GLHCKboundsSlice)))) {
+      job.slices = slices;
+      _glhckJobParallelFor(numSlices, _glhckBoundsJob, &job);
+
+      memcpy(&bounds, &slices[0], sizeof(__GLHCKboundsSlice));
+      for (i = 1; i != numSlices; ++i) {
+         for (c = 0; c != job.memb; ++c) {
+            if (slices[i].min[c] < bounds.min[c]) bounds.min[c] = slices[i].min[c];
+            if (slices[i].max[c] > bounds.max[c]) bounds.max[c] = slices[i].max[c];
+         }
+      }
+      _glhckFree(slices);
+   } else {
+      _glhckBoundsReduce(job.dataType, job.data, job.stride, job.count, job.memb, job.wide, &bounds);
+   }
+
+   /* lanes past position belong to other attributes */
+   for (c = 0; c != job.memb; ++c) {
+      ((float*)min)[c] = bounds.min[c];
+      ((float*)max)[c] = bounds.max[c];
+   }
+}
+
+/* \brief get min && max of geometry positions, minMax of the built-in vertex types
+ * positions are in geometry space, components the vertex type doesn't have are zero */
+void _glhckGeometryMinMax(glhckGeometry *geometry, glhckVector3f *min, glhckVector3f *max)
+{
+   const __GLHCKvertexType *type;
+   assert(geometry && min && max);
+
+   memset(min, 0, sizeof(glhckVector3f));
+   memset(max, 0, sizeof(glhckVector3f));
+   if (!geometry->vertices || geometry->vertexCount <= 0)
+      return;
+
+   type = GLHCKVT(geometry->vertexType);
+   _glhckPositionsMinMax((const char*)geometry->vertices + type->offset[0], type->size, type->size - type->offset[0],
+         geometry->vertexCount, type->dataType[0], type->memb[0], min, max);
+}
+
+/* vim: set ts=8 sw=3 tw=0 :*/
@@ -0,0 +1,377 @@
+#include "../internal.h"
+#include <math.h>   /* for sqrtf */
+#include <float.h>  /* for FLT_MAX */
+#include <assert.h> /* for assert */
+
+/* tracing channel for this file */
+#define GLHCK_CHANNEL GLHCK_CHANNEL_GEOMETRY
+
+/* Meshlets split triangle geometry to small clusters, which are culled as a unit.
+ *
+ * Clusters are grown greedily over shared vertices, preferring triangles that
+ * face the same way and stay close to the cluster. This keeps clusters tight for
+ * frustum culling and flat enough for normal cone (backface) culling.
+ * Indices are reordered so that every meshlet owns a contiguous range of them,
+ * visible meshlets next to each other can then be drawn with a single range. */
+
+/* normal cones whose triangles diverge more from the axis than this are never backface culled */
+#define GLHCK_MESHLET_CONE_MIN_DOT 0.1f
+
+/* \brief compute unit normal and centroid of every triangle, degenerate triangles get zero normal */
+static void _glhckMeshletTriangles(const glhckImportIndexData *indices, unsigned int numTriangles,
+      const kmVec3 *positions, kmVec3 *normals, kmVec3 *centroids)
+{
+   unsigned int t;
+   float length;
+   kmVec3 e1, e2;
+
+   for (t = 0; t != numTriangles; ++t) {
+      const kmVec3 *p[3] = { &positions[indices[t*3+0]], &positions[indices[t*3+1]], &positions[indices[t*3+2]] };
+      kmVec3Subtract(&e1, p[1], p[0]);
+      kmVec3Subtract(&e2, p[2], p[0]);
+      kmVec3Cross(&normals[t], &e1, &e2);
+      if ((length = kmVec3Length(&normals[t])) > 0.0f) kmVec3Scale(&normals[t], &normals[t], 1.0f / length);
+      centroids[t].x = (p[0]->x + p[1]->x + p[2]->x) / 3.0f;
+      centroids[t].y = (p[0]->y + p[1]->y + p[2]->y) / 3.0f;
+      centroids[t].z = (p[0]->z + p[1]->z + p[2]->z) / 3.0f;
+   }
+}
+
+/* \brief build vertex to triangle adjacency, triangles of vertex v are adjacency[offsets[v]..offsets[v+1]] */
+static void _glhckMeshletAdjacency(const glhckImportIndexData *indices, unsigned int memb, unsigned int vertexCount,
+      unsigned int *offsets, unsigned int *adjacency)
+{
+   unsigned int i;
+
+   memset(offsets, 0, (vertexCount + 1) * sizeof(unsigned int));
+   for (i = 0; i != memb; ++i) ++offsets[indices[i] + 1];
+   for (i = 0; i != vertexCount; ++i) offsets[i + 1] += offsets[i];
+
+   /* fill using the start offsets, then shift them back */
+   for (i = 0; i != memb; ++i) adjacency[offsets[indices[i]]++] = i / 3;
+   for (i = vertexCount; i != 0; --i) offsets[i] = offsets[i - 1];
+   offsets[0] = 0;
+}
+
+/* \brief calculate bounds and normal cone of meshlet from its triangles */
+static void _glhckMeshletBounds(glhckMeshlet *meshlet, const glhckImportIndexData *indices,
+      const unsigned int *triangles, unsigned int count, const kmVec3 *positions, const kmVec3 *normals)
+{
+   unsigned int t, i;
+   float length, dot, minDot;
+   kmVec3 axis, d;
+
+   kmVec3Fill(&meshlet->aabb.min, FLT_MAX, FLT_MAX, FLT_MAX);
+   kmVec3Fill(&meshlet->aabb.max, -FLT_MAX, -FLT_MAX, -FLT_MAX);
+   kmVec3Fill(&axis, 0.0f, 0.0f, 0.0f);
+   for (t = 0; t != count; ++t) {
+      for (i = 0; i != 3; ++i) {
+         const kmVec3 *p = &positions[indices[triangles[t]*3+i]];
+         if (p->x < meshlet->aabb.min.x) meshlet->aabb.min.x = p->x;
+         if (p->y < meshlet->aabb.min.y) meshlet->aabb.min.y = p->y;
+         if (p->z < meshlet->aabb.min.z) meshlet->aabb.min.z = p->z;
+         if (p->x > meshlet->aabb.max.x) meshlet->aabb.max.x = p->x;
+         if (p->y > meshlet->aabb.max.y) meshlet->aabb.max.y = p->y;
+         if (p->z > meshlet->aabb.max.z) meshlet->aabb.max.z = p->z;
+      }
+      kmVec3Add(&axis, &axis, &normals[triangles[t]]);
+   }
+
+   kmAABBCentre(&meshlet->aabb, &meshlet->center);
+   for (t = 0, meshlet->radius = 0.0f; t != count; ++t) {
+      for (i = 0; i != 3; ++i) {
+         kmVec3Subtract(&d, &positions[indices[triangles[t]*3+i]], &meshlet->center);
+         if ((length = kmVec3Length(&d)) > meshlet->radius) meshlet->radius = length;
+      }
+   }
+
+   /* cone cutoff is sine of the cone's half angle */
+   meshlet->coneCutoff = 1.0f;
+   kmVec3Fill(&meshlet->coneAxis, 0.0f, 0.0f, 0.0f);
+   if ((length = kmVec3Length(&axis)) <= 0.0f)
+      return;
+
+   kmVec3Scale(&axis, &axis, 1.0f / length);
+   for (t = 0, minDot = 1.0f; t != count; ++t) {
+      if (kmVec3LengthSq(&normals[triangles[t]]) <= 0.0f) continue; /* degenerate, never rasterized */
+      if ((dot = kmVec3Dot(&normals[triangles[t]], &axis)) < minDot) minDot = dot;
+   }
+
+   kmVec3Assign(&meshlet->coneAxis, &axis);
+   if (minDot > GLHCK_MESHLET_CONE_MIN_DOT)
+      meshlet->coneCutoff = sqrtf(1.0f - minDot * minDot);
+}
+
+/* \brief free meshlets of geometry */
+void _glhckGeometryFreeMeshlets(glhckGeometry *object)
+{
+   IFDO(_glhckFree, object->meshlets);
+   object->meshletCount = 0;
+}
+
+/* \brief collect index ranges of meshlets visible with the current view and projection
+ * model is the matrix geometry space is transformed with (bias and scale included),
+ * cullFace 1 culls meshlets facing away from the viewer, -1 culls meshlets facing towards, 0 neither.
+ * ranges must have room for 2 * meshletCount values (first index, index count),
+ * adjacent visible meshlets are merged, returns number of ranges. */
+unsigned int _glhckGeometryCullMeshlets(const glhckGeometry *object, const kmMat4 *model, int cullFace, unsigned int *ranges)
+{
+   int i;
+   char perspective = 0;
+   unsigned int numRanges = 0;
+   float det, dot;
+   kmMat4 modelView, mvp, inverse;
+   kmVec3 eye, toCenter;
+   glhckFrustum frustum;
+   const glhckMeshlet *meshlet;
+   CALL(2, "%p, %p, %d, %p", object, model, cullFace, ranges);
+   assert(object && model && ranges);
+
+   /* frustum and eye in geometry space, so meshlet bounds don't need transforming */
+   kmMat4Multiply(&modelView, &GLHCKRD()->view.view, model);
+   kmMat4Multiply(&mvp, &GLHCKRD()->view.projection, &modelView);
+   glhckFrustumBuild(&frustum, &mvp);
+
+   if (cullFace && kmMat4Inverse(&inverse, &modelView)) {
+      /* mirroring transformation flips the winding */
+      det = model->mat[0] * (model->mat[5] * model->mat[10] - model->mat[6] * model->mat[9]) -
+            model->mat[4] * (model->mat[1] * model->mat[10] - model->mat[2] * model->mat[9]) +
+            model->mat[8] * (model->mat[1] * model->mat[6] - model->mat[2] * model->mat[5]);
+      if (det < 0.0f) cullFace = -cullFace;
+
+      /* eye position for perspective, view direction for orthographic projection */
+      if ((perspective = (GLHCKRD()->view.projection.mat[15] == 0.0f))) {
+         kmVec3Fill(&eye, inverse.mat[12], inverse.mat[13], inverse.mat[14]);
+      } else {
+         kmVec3Fill(&eye, -inverse.mat[8], -inverse.mat[9], -inverse.mat[10]);
+         kmVec3Normalize(&eye, &eye);
+      }
+   } else {
+      cullFace = 0;
+   }
+
+   for (i = 0; i != object->meshletCount; ++i) {
+      meshlet = &object->meshlets[i];
+
+      if (!glhckFrustumContainsAABB(&frustum, &meshlet->aabb))
+         continue;
+
+      if (cullFace && meshlet->coneCutoff < 1.0f) {
+         if (perspective) {
+            kmVec3Subtract(&toCenter, &meshlet->center, &eye);
+            dot = kmVec3Dot(&toCenter, &meshlet->coneAxis) * cullFace;
+            if (dot >= meshlet->coneCutoff * kmVec3Length(&toCenter) + meshlet->radius)
+               continue;
+         } else if (kmVec3Dot(&eye, &meshlet->coneAxis) * cullFace >= meshlet->coneCutoff) {
+            continue;
+         }
+      }
+
+      if (numRanges && ranges[numRanges*2-2] + ranges[numRanges*2-1] == meshlet->indexOffset) {
+         ranges[numRanges*2-1] += meshlet->indexCount;
+      } else {
+         ranges[numRanges*2+0] = meshlet->indexOffset;
+         ranges[numRanges*2+1] = meshlet->indexCount;
+         ++numRanges;
+      }
+   }
+
+   RET(2, "%u", numRanges);
+   return numRanges;
+}
+
+/***
+ * public api
+ ***/
+
+/* \brief split geometry to meshlets of at most maxTriangles triangles (0 for default)
+ * indices are reordered, so each meshlet is a contiguous range of them.
+ * Only indexed GLHCK_TRIANGLES geometry is supported.
+ *
+ * NOTE: Meshlets are released when vertices or indices are replaced, optimizing keeps them,
+ * if you modify vertex positions in place, build the meshlets again. */
+GLHCKAPI int glhckGeometryBuildMeshlets(glhckGeometry *object, unsigned int maxTriangles)
+{
+   int i;
+   float length, score, bestScore, extent;
+   unsigned int t, v, a, c, m, best, cursor, emitted, start, count, numTriangles, numCandidates, maxMeshlets;
+   unsigned int *offsets = NULL, *adjacency = NULL, *stamp = NULL, *order = NULL, *candidates = NULL;
+   kmVec3 *positions = NULL, *normals = NULL, *centroids = NULL;
+   kmVec3 axis, axisSum, center, centerSum, d;
+   kmAABB aabb;
+   char *used = NULL;
+   glhckImportIndexData *indices = NULL, *reordered = NULL;
+   glhckMeshlet *meshlets = NULL, *tmp;
+   const __GLHCKvertexType *type;
+   CALL(0, "%p, %u", object, maxTriangles);
+   assert(object);
+
+   if (object->type != GLHCK_TRIANGLES || !object->indices || !object->vertices || !object->indexCount || object->indexCount % 3)
+      goto not_supported;
+
+   if (!maxTriangles) maxTriangles = GLHCK_MESHLET_TRIANGLES;
+   numTriangles = object->indexCount / 3;
+
+   /* meshlets are closed early only when at least half full */
+   maxMeshlets = numTriangles / (maxTriangles > 1 ? maxTriangles / 2 : 1) + 1;
+
+   if (!(indices = _glhckGeometryReadIndices(object)))
+      goto fail;
+
+   for (i = 0; i != object->indexCount; ++i)
+      if (indices[i] >= (unsigned int)object->vertexCount) goto not_supported;
+
+   if (!(positions = _glhckMalloc(object->vertexCount * sizeof(kmVec3))))
+      goto fail;
+   if (!(normals = _glhckMalloc(numTriangles * sizeof(kmVec3))))
+      goto fail;
+   if (!(centroids = _glhckMalloc(numTriangles * sizeof(kmVec3))))
+      goto fail;
+   if (!(offsets = _glhckMalloc((object->vertexCount + 1) * sizeof(unsigned int))))
+      goto fail;
+   if (!(adjacency = _glhckMalloc(object->indexCount * sizeof(unsigned int))))
+      goto fail;
+   if (!(stamp = _glhckCalloc(numTriangles, sizeof(unsigned int))))
+      goto fail;
+   if (!(order = _glhckMalloc(numTriangles * sizeof(unsigned int))))
+      goto fail;
+   if (!(candidates = _glhckMalloc(numTriangles * sizeof(unsigned int))))
+      goto fail;
+   if (!(used = _glhckCalloc(numTriangles, 1)))
+      goto fail;
+   if (!(reordered = _glhckMalloc(object->indexCount * sizeof(glhckImportIndexData))))
+      goto fail;
+   if (!(meshlets = _glhckMalloc(maxMeshlets * sizeof(glhckMeshlet))))
+      goto fail;
+
+   type = GLHCKVT(object->vertexType);
+   for (i = 0; i != object->vertexCount; ++i)
+      if (_glhckGeometryVertexPosition(type, object->vertices, i, &positions[i]) != RETURN_OK) goto not_supported;
+
+   _glhckMeshletTriangles(indices, numTriangles, positions, normals, centroids);
+   _glhckMeshletAdjacency(indices, object->indexCount, object->vertexCount, offsets, adjacency);
+
+   for (m = 0, cursor = 0, emitted = 0; emitted != numTriangles; ++m) {
+      kmVec3Fill(&axisSum, 0.0f, 0.0f, 0.0f);
+      kmVec3Fill(&centerSum, 0.0f, 0.0f, 0.0f);
+      kmVec3Fill(&aabb.min, FLT_MAX, FLT_MAX, FLT_MAX);
+      kmVec3Fill(&aabb.max, -FLT_MAX, -FLT_MAX, -FLT_MAX);
+      start = emitted;
+      numCandidates = 0;
+
+      for (count = 0; count != maxTriangles && emitted != numTriangles; ++count) {
+         kmVec3Fill(&axis, 0.0f, 0.0f, 0.0f);
+         kmVec3Fill(&center, 0.0f, 0.0f, 0.0f);
+         extent = FLT_EPSILON;
+         if (count) {
+            if ((length = kmVec3Length(&axisSum)) > 0.0f) kmVec3Scale(&axis, &axisSum, 1.0f / length);
+            kmVec3Scale(&center, &centerSum, 1.0f / count);
+            kmVec3Subtract(&d, &aabb.max, &aabb.min);
+            extent += kmVec3Length(&d) * 0.5f;
+         }
+
+         /* pick the neighbour facing the same way and closest to the meshlet */
+         for (c = 0, best = numCandidates, bestScore = -FLT_MAX; c < numCandidates;) {
+            if (used[(t = candidates[c])]) {
+               candidates[c] = candidates[--numCandidates];
+               continue;
+            }
+
+            kmVec3Subtract(&d, &centroids[t], &center);
+            score = kmVec3Dot(&normals[t], &axis) - kmVec3Length(&d) / extent;
+            if (score > bestScore) bestScore = score, best = c;
+            ++c;
+         }
+
+         if (best < numCandidates) {
+            t = candidates[best];
+            candidates[best] = candidates[--numCandidates];
+         } else {
+            /* no connected triangles left, close the meshlet if it's half full,
+             * otherwise continue from the next triangle in index order */
+            if (count && count >= maxTriangles / 2) break;
+            for (; used[cursor]; ++cursor);
+            t = cursor;
+         }
+
+         used[t] = 1;
+         order[emitted++] = t;
+         kmVec3Add(&axisSum, &axisSum, &normals[t]);
+         kmVec3Add(&centerSum, &centerSum, &centroids[t]);
+
+         for (v = 0; v != 3; ++v) {
+            const kmVec3 *p = &positions[indices[t*3+v]];
+            if (p->x < aabb.min.x) aabb.min.x = p->x;
+            if (p->y < aabb.min.y) aabb.min.y = p->y;
+            if (p->z < aabb.min.z) aabb.min.z = p->z;
+            if (p->x > aabb.max.x) aabb.max.x = p->x;
+            if (p->y > aabb.max.y) aabb.max.y = p->y;
+            if (p->z > aabb.max.z) aabb.max.z = p->z;
+
+            /* queue unused neighbours, stamp keeps them queued once per meshlet */
+            for (a = offsets[indices[t*3+v]]; a != offsets[indices[t*3+v]+1]; ++a) {
+               if (used[adjacency[a]] || stamp[adjacency[a]] == m + 1) continue;
+               stamp[adjacency[a]] = m + 1;
+               candidates[numCandidates++] = adjacency[a];
+            }
+         }
+      }
+
+      assert(m < maxMeshlets);
+      meshlets[m].indexOffset = start * 3;
+      meshlets[m].indexCount = (emitted - start) * 3;
+      _glhckMeshletBounds(&meshlets[m], indices, order + start, emitted - start, positions, normals);
+   }
+
+   for (t = 0; t != numTriangles; ++t) {
+      reordered[t*3+0] = indices[order[t]*3+0];
+      reordered[t*3+1] = indices[order[t]*3+1];
+      reordered[t*3+2] = indices[order[t]*3+2];
+   }
+
+   /* indices have the same range, so they fit to the same type */
+   GLHCKIT(object->indexType)->api.convert(reordered, object->indexCount, object->indices);
+
+   if (m != maxMeshlets && (tmp = _glhckRealloc(meshlets, maxMeshlets, m, sizeof(glhckMeshlet))))
+      meshlets = tmp;
+
+   _glhckGeometryFreeMeshlets(object);
+   object->meshlets = meshlets;
+   object->meshletCount = m;
+
+   DEBUG(GLHCK_DBG_CRAP, "Split geometry(%p) of %u triangles to %u meshlets", object, numTriangles, m);
+
+   NULLDO(_glhckFree, indices);
+   NULLDO(_glhckFree, reordered);
+   NULLDO(_glhckFree, positions);
+   NULLDO(_glhckFree, normals);
+   NULLDO(_glhckFree, centroids);
+   NULLDO(_glhckFree, offsets);
+   NULLDO(_glhckFree, adjacency);
+   NULLDO(_glhckFree, stamp);
+   NULLDO(_glhckFree, order);
+   NULLDO(_glhckFree, candidates);
+   NULLDO(_glhckFree, used);
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+
+not_supported:
+   DEBUG(GLHCK_DBG_WARNING, "Only valid indexed GLHCK_TRIANGLES geometry can be split to meshlets");
+fail:
+   IFDO(_glhckFree, indices);
+   IFDO(_glhckFree, reordered);
+   IFDO(_glhckFree, positions);
+   IFDO(_glhckFree, normals);
+   IFDO(_glhckFree, centroids);
+   IFDO(_glhckFree, offsets);
+   IFDO(_glhckFree, adjacency);
+   IFDO(_glhckFree, stamp);
+   IFDO(_glhckFree, order);
+   IFDO(_glhckFree, candidates);
+   IFDO(_glhckFree, used);
+   IFDO(_glhckFree, meshlets);
+   RET(0, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
+/* vim: set ts=8 sw=3 tw=0 :*/
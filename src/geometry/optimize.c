@@ -0,0 +1,534 @@
+#include "../internal.h"
+#include <stdlib.h> /* for qsort */
+#include <assert.h> /* for assert */
+
+/* tracing channel for this file */
+#define GLHCK_CHANNEL GLHCK_CHANNEL_GEOMETRY
+
+/* Index and vertex order optimization for triangle geometry.
+ *
+ * Vertex cache: Tipsify (Sander, Nehab, Barczak 2007),
+ * linear time and not sensitive to the exact post-transform cache size.
+ *
+ * Overdraw: Tipsify output is split into clusters at cache flushes,
+ * and clusters facing outwards from the mesh are drawn first.
+ *
+ * Vertex fetch: vertices are reordered in the order indices first reference them. */
+
+/* post-transform cache size the optimizer targets */
+#define GLHCK_OPTIMIZE_CACHE_SIZE 16
+
+/* clusters are split, when their running ACMR gets this close to the cluster's ACMR */
+#define GLHCK_OPTIMIZE_OVERDRAW_THRESHOLD 1.05f
+
+/* cluster of triangles for overdraw sorting */
+typedef struct __GLHCKoptimizeCluster {
+   float sort;
+   unsigned int start, count;
+} __GLHCKoptimizeCluster;
+
+/* \brief read geometry's indices as import indices */
+glhckImportIndexData* _glhckGeometryReadIndices(const glhckGeometry *geometry)
+{
+   int i;
+   glhckImportIndexData *indices;
+
+   if (!(indices = _glhckMalloc(geometry->indexCount * sizeof(glhckImportIndexData))))
+      return NULL;
+
+   switch (GLHCKIT(geometry->indexType)->dataType) {
+      case GLHCK_UNSIGNED_BYTE:
+         for (i = 0; i != geometry->indexCount; ++i) indices[i] = ((unsigned char*)geometry->indices)[i];
+         break;
+      case GLHCK_UNSIGNED_SHORT:
+         for (i = 0; i != geometry->indexCount; ++i) indices[i] = ((unsigned short*)geometry->indices)[i];
+         break;
+      case GLHCK_UNSIGNED_INT:
+         for (i = 0; i != geometry->indexCount; ++i) indices[i] = ((unsigned int*)geometry->indices)[i];
+         break;
+      default:
+         _glhckFree(indices);
+         return NULL;
+   }
+
+   return indices;
+}
+
+/* \brief check that indices refer only to existing vertices */
+static int _glhckGeometryValidIndices(const glhckImportIndexData *indices, unsigned int memb, unsigned int vertexCount)
+{
+   unsigned int i;
+   for (i = 0; i != memb; ++i)
+      if (indices[i] >= vertexCount) return RETURN_FALSE;
+   return RETURN_TRUE;
+}
+
+/* \brief count misses of FIFO post-transform cache
+ * stamps must be zeroed array of vertexCount, time starts from cacheSize + 1 */
+static unsigned int _glhckGeometryCacheMisses(const glhckImportIndexData *indices, unsigned int memb,
+      unsigned int *stamps, unsigned int *time, unsigned int cacheSize)
+{
+   unsigned int i, misses;
+   for (i = 0, misses = 0; i != memb; ++i) {
+      if (*time - stamps[indices[i]] > cacheSize) {
+         stamps[indices[i]] = (*time)++;
+         ++misses;
+      }
+   }
+   return misses;
+}
+
+/* \brief get next fanning vertex after dead end, from dead end stack or input order */
+static int _glhckGeometryTipsifyDeadEnd(const glhckImportIndexData *deadEnd, unsigned int *deadEndCount,
+      const unsigned int *live, unsigned int vertexCount, unsigned int *cursor)
+{
+   glhckImportIndexData v;
+
+   while (*deadEndCount) {
+      v = deadEnd[--*deadEndCount];
+      if (live[v]) return v;
+   }
+
+   for (; *cursor != vertexCount; ++*cursor)
+      if (live[*cursor]) return *cursor;
+
+   return -1;
+}
+
+/* \brief reorder triangles for post-transform vertex cache
+ * starts of clusters (in triangles) are written to clusters,
+ * new cluster starts whenever tipsify has to restart from dead end. */
+static int _glhckGeometryTipsify(const glhckImportIndexData *indices, unsigned int memb, unsigned int vertexCount,
+      unsigned int cacheSize, glhckImportIndexData *out, unsigned int *clusters, unsigned int *numClusters)
+{
+   int fan, best, priority, bestPriority;
+   unsigned int i, c, t, v, a, time, outMemb, deadEndCount, numCandidates, cursor;
+   unsigned int *live = NULL, *offsets = NULL, *adjacency = NULL, *stamps = NULL;
+   glhckImportIndexData *deadEnd = NULL, *candidates = NULL;
+   char *emitted = NULL;
+   CALL(2, "%p, %u, %u, %u, %p, %p, %p", indices, memb, vertexCount, cacheSize, out, clusters, numClusters);
+
+   if (!(live = _glhckCalloc(vertexCount, sizeof(unsigned int))) ||
+       !(offsets = _glhckCalloc(vertexCount + 1, sizeof(unsigned int))) ||
+       !(adjacency = _glhckMalloc(memb * sizeof(unsigned int))) ||
+       !(stamps = _glhckCalloc(vertexCount, sizeof(unsigned int))) ||
+       !(deadEnd = _glhckMalloc(memb * sizeof(glhckImportIndexData))) ||
+       !(candidates = _glhckMalloc(memb * sizeof(glhckImportIndexData))) ||
+       !(emitted = _glhckCalloc(memb / 3, sizeof(char))))
+      goto fail;
+
+   /* triangles of each vertex */
+   for (i = 0; i != memb; ++i) live[indices[i]]++;
+   for (v = 0; v != vertexCount; ++v) offsets[v+1] = offsets[v] + live[v];
+   for (i = 0; i != memb; ++i) adjacency[offsets[indices[i]]++] = i / 3;
+   for (v = vertexCount; v != 0; --v) offsets[v] = offsets[v-1];
+   offsets[0] = 0;
+
+   time = cacheSize + 1;
+   cursor = outMemb = deadEndCount = 0;
+   *numClusters = 0;
+   fan = _glhckGeometryTipsifyDeadEnd(deadEnd, &deadEndCount, live, vertexCount, &cursor);
+   while (fan != -1) {
+      /* emit all live triangles of the fanning vertex */
+      for (a = offsets[fan], numCandidates = 0; a != offsets[fan+1]; ++a) {
+         if (emitted[(t = adjacency[a])])
+            continue;
+
+         for (c = 0; c != 3; ++c) {
+            v = indices[t*3+c];
+            out[outMemb++] = v;
+            deadEnd[deadEndCount++] = v;
+            candidates[numCandidates++] = v;
+            live[v]--;
+            if (time - stamps[v] > cacheSize)
+               stamps[v] = time++;
+         }
+         emitted[t] = 1;
+      }
+
+      /* next fanning vertex is the oldest candidate, that stays in cache while fanning */
+      for (i = 0, best = -1, bestPriority = -1; i != numCandidates; ++i) {
+         v = candidates[i];
+         if (!live[v]) continue;
+         priority = (time - stamps[v] + 2 * live[v] <= cacheSize ? (int)(time - stamps[v]) : 0);
+         if (priority > bestPriority) {
+            bestPriority = priority;
+            best = v;
+         }
+      }
+
+      /* dead end, the cache is assumed to be cold here */
+      if (best == -1) {
+         if (outMemb != memb && (!*numClusters || clusters[*numClusters-1] != outMemb / 3))
+            clusters[(*numClusters)++] = outMemb / 3;
+         best = _glhckGeometryTipsifyDeadEnd(deadEnd, &deadEndCount, live, vertexCount, &cursor);
+      }
+
+      fan = best;
+   }
+
+   /* the first cluster starts from the first triangle */
+   if (!*numClusters || clusters[0] != 0) {
+      memmove(clusters + 1, clusters, *numClusters * sizeof(unsigned int));
+      clusters[0] = 0;
+      (*numClusters)++;
+   }
+
+   _glhckFree(live);
+   _glhckFree(offsets);
+   _glhckFree(adjacency);
+   _glhckFree(stamps);
+   _glhckFree(deadEnd);
+   _glhckFree(candidates);
+   _glhckFree(emitted);
+   RET(2, "%d", RETURN_OK);
+   return RETURN_OK;
+
+fail:
+   IFDO(_glhckFree, live);
+   IFDO(_glhckFree, offsets);
+   IFDO(_glhckFree, adjacency);
+   IFDO(_glhckFree, stamps);
+   IFDO(_glhckFree, deadEnd);
+   IFDO(_glhckFree, candidates);
+   IFDO(_glhckFree, emitted);
+   RET(2, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
+/* \brief split clusters further where the cache has warmed up, so there is more to sort for overdraw */
+static unsigned int _glhckGeometrySplitClusters(const glhckImportIndexData *indices, unsigned int memb, unsigned int vertexCount,
+      unsigned int cacheSize, const unsigned int *clusters, unsigned int numClusters, __GLHCKoptimizeCluster *out)
+{
+   unsigned int c, t, start, end, misses, numOut, time;
+   unsigned int *stamps;
+   float threshold;
+
+   if (!(stamps = _glhckCalloc(vertexCount, sizeof(unsigned int))))
+      return 0;
+
+   time = cacheSize + 1;
+   for (c = 0, numOut = 0; c != numClusters; ++c) {
+      start = clusters[c];
+      end = (c + 1 != numClusters ? clusters[c+1] : memb / 3);
+
+      /* ACMR of the whole cluster from cold cache */
+      time += cacheSize + 1;
+      misses = _glhckGeometryCacheMisses(&indices[start*3], (end - start) * 3, stamps, &time, cacheSize);
+      threshold = GLHCK_OPTIMIZE_OVERDRAW_THRESHOLD * (float)misses / (end - start);
+
+      /* cut, when the running ACMR of the cluster is under threshold */
+      time += cacheSize + 1;
+      out[numOut].start = start;
+      for (t = start, misses = 0; t != end; ++t) {
+         misses += _glhckGeometryCacheMisses(&indices[t*3], 3, stamps, &time, cacheSize);
+         if (t + 1 != end && misses <= threshold * (t + 1 - out[numOut].start)) {
+            out[numOut].count = t + 1 - out[numOut].start;
+            out[++numOut].start = t + 1;
+            time += cacheSize + 1;
+            misses = 0;
+         }
+      }
+      out[numOut].count = end - out[numOut].start;
+      ++numOut;
+   }
+
+   _glhckFree(stamps);
+   return numOut;
+}
+
+/* \brief get area weighted centroid and normal of triangle, returns area */
+static float _glhckGeometryTriangle(const glhckGeometry *geometry, const glhckImportIndexData *indices, unsigned int triangle, kmVec3 *centroid, kmVec3 *normal)
+{
+   unsigned int i;
+   float area;
+   kmVec3 p[3], e1, e2;
+   const __GLHCKvertexType *type = GLHCKVT(geometry->vertexType);
+
+   for (i = 0; i != 3; ++i) {
+      _glhckGeometryVertexPosition(type, geometry->vertices, indices[triangle*3+i], &p[i]);
+      p[i].x = p[i].x * geometry->scale.x + geometry->bias.x;
+      p[i].y = p[i].y * geometry->scale.y + geometry->bias.y;
+      p[i].z = p[i].z * geometry->scale.z + geometry->bias.z;
+   }
+
+   kmVec3Subtract(&e1, &p[1], &p[0]);
+   kmVec3Subtract(&e2, &p[2], &p[0]);
+   kmVec3Cross(normal, &e1, &e2);
+   area = kmVec3Length(normal);
+   centroid->x = (p[0].x + p[1].x + p[2].x) * area / 3.0f;
+   centroid->y = (p[0].y + p[1].y + p[2].y) * area / 3.0f;
+   centroid->z = (p[0].z + p[1].z + p[2].z) * area / 3.0f;
+   return area;
+}
+
+/* \brief compare clusters for overdraw sort */
+static int _glhckGeometryClusterCmp(const void *a, const void *b)
+{
+   const __GLHCKoptimizeCluster *ca = a, *cb = b;
+   if (ca->sort != cb->sort) return (ca->sort > cb->sort ? -1 : 1);
+   return (ca->start < cb->start ? -1 : (ca->start > cb->start));
+}
+
+/* \brief sort clusters so that clusters facing outwards are drawn first */
+static int _glhckGeometrySortClusters(const glhckGeometry *geometry, glhckImportIndexData *indices, unsigned int memb,
+      __GLHCKoptimizeCluster *clusters, unsigned int numClusters)
+{
+   unsigned int c, t, i;
+   float area;
+   kmVec3 centroid, normal, meshCentroid, clusterCentroid, clusterNormal;
+   glhckImportIndexData *sorted;
+
+   if (!(sorted = _glhckMalloc(memb * sizeof(glhckImportIndexData))))
+      return RETURN_FAIL;
+
+   /* area weighted centroid of the mesh */
+   kmVec3Fill(&meshCentroid, 0.0f, 0.0f, 0.0f);
+   for (t = 0, area = 0.0f; t != memb / 3; ++t) {
+      area += _glhckGeometryTriangle(geometry, indices, t, &centroid, &normal);
+      kmVec3Add(&meshCentroid, &meshCentroid, &centroid);
+   }
+   if (area > 0.0f) kmVec3Scale(&meshCentroid, &meshCentroid, 1.0f / area);
+
+   /* clusters are sorted by how much they face away from the mesh centroid */
+   for (c = 0; c != numClusters; ++c) {
+      kmVec3Fill(&clusterCentroid, 0.0f, 0.0f, 0.0f);
+      kmVec3Fill(&clusterNormal, 0.0f, 0.0f, 0.0f);
+      for (t = clusters[c].start, area = 0.0f; t != clusters[c].start + clusters[c].count; ++t) {
+         area += _glhckGeometryTriangle(geometry, indices, t, &centroid, &normal);
+         kmVec3Add(&clusterCentroid, &clusterCentroid, &centroid);
+         kmVec3Add(&clusterNormal, &clusterNormal, &normal);
+      }
+
+      if (area > 0.0f) kmVec3Scale(&clusterCentroid, &clusterCentroid, 1.0f / area);
+      if (kmVec3Length(&clusterNormal) > 0.0f) kmVec3Normalize(&clusterNormal, &clusterNormal);
+      kmVec3Subtract(&clusterCentroid, &clusterCentroid, &meshCentroid);
+      clusters[c].sort = kmVec3Dot(&clusterCentroid, &clusterNormal);
+   }
+
+   qsort(clusters, numClusters, sizeof(__GLHCKoptimizeCluster), _glhckGeometryClusterCmp);
+
+   for (c = 0, i = 0; c != numClusters; ++c) {
+      memcpy(&sorted[i], &indices[clusters[c].start*3], clusters[c].count * 3 * sizeof(glhckImportIndexData));
+      i += clusters[c].count * 3;
+   }
+
+   memcpy(indices, sorted, memb * sizeof(glhckImportIndexData));
+   _glhckFree(sorted);
+   return RETURN_OK;
+}
+
+/* \brief reorder vertices in order of first reference by indices, indices are remapped
+ * vertices not referenced by indices are moved at the end */
+static int _glhckGeometryOptimizeFetch(glhckGeometry *geometry, glhckImportIndexData *indices, unsigned int memb)
+{
+   unsigned int i, next, size;
+   unsigned int *remap;
+   char *vertices;
+
+   size = GLHCKVT(geometry->vertexType)->size;
+   if (!(remap = _glhckMalloc(geometry->vertexCount * sizeof(unsigned int))))
+      goto fail;
+   if (!(vertices = _glhckMalloc(geometry->vertexCount * size)))
+      goto fail;
+
+   memset(remap, 0xff, geometry->vertexCount * sizeof(unsigned int));
+   for (i = 0, next = 0; i != memb; ++i) {
+      if (remap[indices[i]] == (unsigned int)-1) remap[indices[i]] = next++;
+      indices[i] = remap[indices[i]];
+   }
+
+   for (i = 0; i != (unsigned int)geometry->vertexCount; ++i) {
+      if (remap[i] == (unsigned int)-1) remap[i] = next++;
+      memcpy(vertices + remap[i] * size, (char*)geometry->vertices + i * size, size);
+   }
+
+   memcpy(geometry->vertices, vertices, geometry->vertexCount * size);
+   _glhckFree(vertices);
+   _glhckFree(remap);
+   return RETURN_OK;
+
+fail:
+   IFDO(_glhckFree, remap);
+   return RETURN_FAIL;
+}
+
+/* \brief reorder triangles of index range for vertex cache and overdraw
+ * vertices are numbered locally for the range, so ranges of big geometry stay cheap.
+ * local maps geometry's vertices to the range, it's all -1 on entry and on successful return. */
+static int _glhckGeometryOptimizeRange(const glhckGeometry *geometry, glhckImportIndexData *indices, unsigned int memb,
+      unsigned int flags, unsigned int *local)
+{
+   unsigned int i, numVertices = 0, *hardClusters = NULL, numHardClusters, numClusters = 0;
+   glhckImportIndexData *global = NULL, *optimized = NULL;
+   __GLHCKoptimizeCluster *clusters = NULL;
+
+   if (!memb)
+      return RETURN_OK;
+
+   if (!(global = _glhckMalloc(memb * sizeof(glhckImportIndexData))) ||
+       !(optimized = _glhckMalloc(memb * sizeof(glhckImportIndexData))) ||
+       !(hardClusters = _glhckMalloc((memb / 3 + 1) * sizeof(unsigned int))))
+      goto fail;
+
+   for (i = 0; i != memb; ++i) {
+      if (local[indices[i]] == (unsigned int)-1) {
+         local[indices[i]] = numVertices;
+         global[numVertices++] = indices[i];
+      }
+      indices[i] = local[indices[i]];
+   }
+
+   if (_glhckGeometryTipsify(indices, memb, numVertices, GLHCK_OPTIMIZE_CACHE_SIZE,
+            optimized, hardClusters, &numHardClusters) != RETURN_OK)
+      goto fail;
+
+   if (flags & GLHCK_OPTIMIZE_OVERDRAW) {
+      if (!(clusters = _glhckMalloc((memb / 3) * sizeof(__GLHCKoptimizeCluster))))
+         goto fail;
+
+      if (!(numClusters = _glhckGeometrySplitClusters(optimized, memb, numVertices,
+                  GLHCK_OPTIMIZE_CACHE_SIZE, hardClusters, numHardClusters, clusters)))
+         goto fail;
+   }
+
+   /* back to geometry's vertices, sorting needs their positions */
+   for (i = 0; i != memb; ++i) optimized[i] = global[optimized[i]];
+
+   if (clusters && _glhckGeometrySortClusters(geometry, optimized, memb, clusters, numClusters) != RETURN_OK)
+      goto fail;
+
+   memcpy(indices, optimized, memb * sizeof(glhckImportIndexData));
+   for (i = 0; i != numVertices; ++i) local[global[i]] = (unsigned int)-1;
+   IFDO(_glhckFree, clusters);
+   _glhckFree(hardClusters);
+   _glhckFree(optimized);
+   _glhckFree(global);
+   return RETURN_OK;
+
+fail:
+   /* indices may be left local, but the caller throws them away */
+   IFDO(_glhckFree, global);
+   IFDO(_glhckFree, optimized);
+   IFDO(_glhckFree, hardClusters);
+   IFDO(_glhckFree, clusters);
+   return RETURN_FAIL;
+}
+
+/***
+ * public api
+ ***/
+
+/* \brief get post-transform cache statistics of geometry for FIFO cache of cacheSize
+ * acmr is average cache misses per triangle (0.5 - 3.0, lower is better),
+ * atvr is cache misses per referenced vertex (1.0 is optimal). */
+GLHCKAPI int glhckGeometryCacheStatistics(const glhckGeometry *object, unsigned int cacheSize, float *acmr, float *atvr)
+{
+   int i;
+   unsigned int misses, unique, triangles, time;
+   unsigned int *stamps = NULL;
+   glhckImportIndexData *indices = NULL;
+   CALL(2, "%p, %u, %p, %p", object, cacheSize, acmr, atvr);
+   assert(object);
+
+   if (acmr) *acmr = 0.0f;
+   if (atvr) *atvr = 0.0f;
+
+   if (!object->indices || object->indexCount < 3)
+      goto fail;
+
+   if (!(indices = _glhckGeometryReadIndices(object)))
+      goto fail;
+
+   if (!_glhckGeometryValidIndices(indices, object->indexCount, object->vertexCount))
+      goto fail;
+
+   if (!(stamps = _glhckCalloc(object->vertexCount, sizeof(unsigned int))))
+      goto fail;
+
+   time = cacheSize + 1;
+   misses = _glhckGeometryCacheMisses(indices, object->indexCount, stamps, &time, cacheSize);
+   for (i = 0, unique = 0; i != object->vertexCount; ++i) if (stamps[i]) ++unique;
+   triangles = (object->type == GLHCK_TRIANGLE_STRIP ? object->indexCount - 2 : object->indexCount / 3);
+
+   if (acmr) *acmr = (float)misses / triangles;
+   if (atvr) *atvr = (unique ? (float)misses / unique : 0.0f);
+
+   _glhckFree(indices);
+   _glhckFree(stamps);
+   RET(2, "%d", RETURN_OK);
+   return RETURN_OK;
+
+fail:
+   IFDO(_glhckFree, indices);
+   IFDO(_glhckFree, stamps);
+   RET(2, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
+/* \brief optimize indexed triangle geometry for post-transform cache, overdraw and vertex fetch
+ * vertex fetch optimization reorders vertices, so don't use it on geometry that has skin bones
+ * or other data referring to vertices by index.
+ * Triangles of built meshlets are reordered only inside their meshlet, so meshlets stay valid. */
+GLHCKAPI int glhckGeometryOptimize(glhckGeometry *object, unsigned int flags)
+{
+   int i;
+   unsigned int *local = NULL;
+   float acmr[2], atvr[2];
+   glhckImportIndexData *indices = NULL;
+   CALL(0, "%p, %u", object, flags);
+   assert(object);
+
+   if (object->type != GLHCK_TRIANGLES || !object->indices || !object->vertices || object->indexCount % 3)
+      goto not_supported;
+
+   if (!(indices = _glhckGeometryReadIndices(object)))
+      goto fail;
+
+   if (!_glhckGeometryValidIndices(indices, object->indexCount, object->vertexCount))
+      goto not_supported;
+
+   glhckGeometryCacheStatistics(object, GLHCK_OPTIMIZE_CACHE_SIZE, &acmr[0], &atvr[0]);
+
+   if (flags & (GLHCK_OPTIMIZE_VERTEX_CACHE | GLHCK_OPTIMIZE_OVERDRAW)) {
+      if (!(local = _glhckMalloc(object->vertexCount * sizeof(unsigned int))))
+         goto fail;
+
+      /* meshlets keep their triangles, so they are optimized one by one */
+      memset(local, 0xff, object->vertexCount * sizeof(unsigned int));
+      if (object->meshlets) {
+         for (i = 0; i != object->meshletCount; ++i) {
+            if (_glhckGeometryOptimizeRange(object, &indices[object->meshlets[i].indexOffset],
+                     object->meshlets[i].indexCount, flags, local) != RETURN_OK)
+               goto fail;
+         }
+      } else if (_glhckGeometryOptimizeRange(object, indices, object->indexCount, flags, local) != RETURN_OK) {
+         goto fail;
+      }
+
+      NULLDO(_glhckFree, local);
+   }
+
+   if ((flags & GLHCK_OPTIMIZE_VERTEX_FETCH) && _glhckGeometryOptimizeFetch(object, indices, object->indexCount) != RETURN_OK)
+      goto fail;
+
+   /* indices have the same range, so they fit to the same type */
+   GLHCKIT(object->indexType)->api.convert(indices, object->indexCount, object->indices);
+   NULLDO(_glhckFree, indices);
+
+   glhckGeometryCacheStatistics(object, GLHCK_OPTIMIZE_CACHE_SIZE, &acmr[1], &atvr[1]);
+   DEBUG(GLHCK_DBG_CRAP, "Optimized geometry(%p): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+         object, acmr[0], acmr[1], atvr[0], atvr[1]);
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+
+not_supported:
+   DEBUG(GLHCK_DBG_WARNING, "Only valid indexed GLHCK_TRIANGLES geometry can be optimized");
+fail:
+   IFDO(_glhckFree, indices);
+   IFDO(_glhckFree, local);
+   RET(0, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
+/* vim: set ts=8 sw=3 tw=0 :*/
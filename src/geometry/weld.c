@@ -0,0 +1,207 @@
+#include "../internal.h"
+#include <math.h>   /* for floorf */
+#include <assert.h> /* for assert */
+
+/* tracing channel for this file */
+#define GLHCK_CHANNEL GLHCK_CHANNEL_GEOMETRY
+
+/* Vertex welding merges vertices with identical position, normal, coord and color.
+ * With epsilon, attributes are snapped to epsilon grid before comparison,
+ * the first vertex of each group is kept as it was. */
+
+/* comparison key of vertex */
+typedef struct __GLHCKweldKey {
+   float attributes[8];
+   glhckColorb color;
+} __GLHCKweldKey;
+
+/* \brief snap float to epsilon grid */
+static float _glhckWeldSnap(float value, float epsilon)
+{
+   if (epsilon > 0.0f) value = floorf(value / epsilon + 0.5f) * epsilon;
+   return (value == 0.0f ? 0.0f : value); /* -0.0 and 0.0 are same */
+}
+
+/* \brief build comparison key for vertex */
+static void _glhckWeldKey(const glhckImportVertexData *vertex, float epsilon, __GLHCKweldKey *key)
+{
+   key->attributes[0] = _glhckWeldSnap(vertex->vertex.x, epsilon);
+   key->attributes[1] = _glhckWeldSnap(vertex->vertex.y, epsilon);
+   key->attributes[2] = _glhckWeldSnap(vertex->vertex.z, epsilon);
+   key->attributes[3] = _glhckWeldSnap(vertex->normal.x, epsilon);
+   key->attributes[4] = _glhckWeldSnap(vertex->normal.y, epsilon);
+   key->attributes[5] = _glhckWeldSnap(vertex->normal.z, epsilon);
+   key->attributes[6] = _glhckWeldSnap(vertex->coord.x, epsilon);
+   key->attributes[7] = _glhckWeldSnap(vertex->coord.y, epsilon);
+   memcpy(&key->color, &vertex->color, sizeof(glhckColorb));
+}
+
+/* \brief hash vertex key (FNV-1a) */
+static unsigned int _glhckWeldHash(const __GLHCKweldKey *key)
+{
+   unsigned int i, hash = 2166136261u;
+   const unsigned char *data = (const unsigned char*)key;
+   for (i = 0; i != sizeof(__GLHCKweldKey); ++i) hash = (hash ^ data[i]) * 16777619u;
+   return hash;
+}
+
+/* \brief weld identical vertices and generate indices for them
+ * indices may be NULL for non indexed vertices, then indexCount must be memb.
+ * outVertices and outIndices are allocated, outIndices has indexCount indices. */
+int _glhckGeometryWeld(const glhckImportVertexData *vertices, unsigned int memb,
+      const glhckImportIndexData *indices, unsigned int indexCount, float epsilon,
+      glhckImportVertexData **outVertices, unsigned int *outMemb, glhckImportIndexData **outIndices)
+{
+   unsigned int i, slot, size, numUnique;
+   unsigned int *slots = NULL, *remap = NULL;
+   __GLHCKweldKey *keys = NULL;
+   glhckImportVertexData *unique = NULL, *tmp;
+   glhckImportIndexData *newIndices = NULL;
+   CALL(0, "%p, %u, %p, %u, %f, %p, %p, %p", vertices, memb, indices, indexCount, epsilon, outVertices, outMemb, outIndices);
+   assert(vertices && outVertices && outMemb && outIndices);
+   assert(indices || indexCount == memb);
+
+   *outVertices = NULL;
+   *outIndices = NULL;
+   *outMemb = 0;
+
+   if (!memb || !indexCount)
+      goto fail;
+
+   /* open addressing table at most half full */
+   for (size = 16; size < memb * 2; size *= 2);
+
+   if (!(slots = _glhckCalloc(size, sizeof(unsigned int))))
+      goto fail;
+   if (!(remap = _glhckMalloc(memb * sizeof(unsigned int))))
+      goto fail;
+   if (!(keys = _glhckMalloc(memb * sizeof(__GLHCKweldKey))))
+      goto fail;
+   if (!(unique = _glhckMalloc(memb * sizeof(glhckImportVertexData))))
+      goto fail;
+   if (!(newIndices = _glhckMalloc(indexCount * sizeof(glhckImportIndexData))))
+      goto fail;
+
+   for (i = 0, numUnique = 0; i != memb; ++i) {
+      _glhckWeldKey(&vertices[i], epsilon, &keys[numUnique]);
+      for (slot = _glhckWeldHash(&keys[numUnique]) & (size - 1); slots[slot]; slot = (slot + 1) & (size - 1))
+         if (!memcmp(&keys[slots[slot]-1], &keys[numUnique], sizeof(__GLHCKweldKey))) break;
+
+      if (!slots[slot]) {
+         memcpy(&unique[numUnique], &vertices[i], sizeof(glhckImportVertexData));
+         slots[slot] = ++numUnique;
+      }
+
+      remap[i] = slots[slot] - 1;
+   }
+
+   for (i = 0; i != indexCount; ++i) {
+      if (indices && indices[i] >= memb) goto invalid_index;
+      newIndices[i] = remap[(indices ? indices[i] : i)];
+   }
+
+   if (numUnique != memb && (tmp = _glhckRealloc(unique, memb, numUnique, sizeof(glhckImportVertexData))))
+      unique = tmp;
+
+   DEBUG(GLHCK_DBG_CRAP, "Welded %u vertices to %u", memb, numUnique);
+
+   NULLDO(_glhckFree, slots);
+   NULLDO(_glhckFree, remap);
+   NULLDO(_glhckFree, keys);
+   *outVertices = unique;
+   *outIndices = newIndices;
+   *outMemb = numUnique;
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+
+invalid_index:
+   DEBUG(GLHCK_DBG_ERROR, "Index %u is out of range of %u vertices", indices[i], memb);
+fail:
+   IFDO(_glhckFree, slots);
+   IFDO(_glhckFree, remap);
+   IFDO(_glhckFree, keys);
+   IFDO(_glhckFree, unique);
+   IFDO(_glhckFree, newIndices);
+   RET(0, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
+/* \brief hash raw vertex (FNV-1a) */
+static unsigned int _glhckWeldHashBytes(const unsigned char *data, size_t size)
+{
+   size_t i;
+   unsigned int hash = 2166136261u;
+   for (i = 0; i != size; ++i) hash = (hash ^ data[i]) * 16777619u;
+   return hash;
+}
+
+/* \brief weld bitwise identical vertices of geometry in place, for any vertex type.
+ * this is used after converting to the final vertex type, so vertices that quantize
+ * to same values are merged too. padding of vertices must be zeroed.
+ * indices refer to geometry vertices and are remapped in place. */
+int _glhckGeometryWeldVertices(glhckGeometry *geometry, glhckImportIndexData *indices, unsigned int indexCount)
+{
+   unsigned int i, slot, size, memb, numUnique;
+   unsigned int *slots = NULL, *remap = NULL;
+   size_t vsize;
+   unsigned char *data;
+   void *tmp;
+   CALL(0, "%p, %p, %u", geometry, indices, indexCount);
+   assert(geometry && (indices || !indexCount));
+
+   if (!geometry->vertices || geometry->vertexCount <= 0)
+      goto fail;
+
+   memb = geometry->vertexCount;
+   vsize = GLHCKVT(geometry->vertexType)->size;
+   data = geometry->vertices;
+
+   /* open addressing table at most half full */
+   for (size = 16; size < memb * 2; size *= 2);
+
+   if (!(slots = _glhckCalloc(size, sizeof(unsigned int))))
+      goto fail;
+   if (!(remap = _glhckMalloc(memb * sizeof(unsigned int))))
+      goto fail;
+
+   for (i = 0; i != indexCount; ++i)
+      if (indices[i] >= memb) goto invalid_index;
+
+   /* unique vertices are compacted to front, slots refer to compacted vertices */
+   for (i = 0, numUnique = 0; i != memb; ++i) {
+      for (slot = _glhckWeldHashBytes(data + i * vsize, vsize) & (size - 1); slots[slot]; slot = (slot + 1) & (size - 1))
+         if (!memcmp(data + (slots[slot] - 1) * vsize, data + i * vsize, vsize)) break;
+
+      if (!slots[slot]) {
+         if (numUnique != i) memcpy(data + numUnique * vsize, data + i * vsize, vsize);
+         slots[slot] = ++numUnique;
+      }
+
+      remap[i] = slots[slot] - 1;
+   }
+
+   for (i = 0; i != indexCount; ++i) indices[i] = remap[indices[i]];
+
+   /* buffers with release callback are not ours to reallocate */
+   if (numUnique != memb && !geometry->vertexRelease &&
+       (tmp = _glhckRealloc(geometry->vertices, memb, numUnique, vsize)))
+      geometry->vertices = tmp;
+
+   geometry->vertexCount = numUnique;
+   DEBUG(GLHCK_DBG_CRAP, "Welded %u vertices to %u", memb, numUnique);
+
+   NULLDO(_glhckFree, slots);
+   NULLDO(_glhckFree, remap);
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+
+invalid_index:
+   DEBUG(GLHCK_DBG_ERROR, "Index %u is out of range of %u vertices", indices[i], memb);
+fail:
+   IFDO(_glhckFree, slots);
+   IFDO(_glhckFree, remap);
+   RET(0, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
+/* vim: set ts=8 sw=3 tw=0 :*/
@@ -222,6 +222,9 @@ GLHCKAPI void glhckContextTerminate(void)
    if (!glhckInitialized()) return;
    TRACE(0);
 
+   /* stop job threads */
+   _glhckJobTerminate();
+
    /* destroy queues */
    _glhckFree(GLHCKRD()->objects.queue);
    _glhckFree(GLHCKRD()->textures.queue);
@@ -382,6 +385,24 @@ GLHCKAPI void glhckGetGlobalPrecision(unsigned char *itype, unsigned char *vtype
    if (vtype) *vtype = GLHCKM()->globalVertexType;
 }
 
+/* \brief set maximum position error allowed for GLHCK_VTX_AUTO precision.
+ * error is in geometry units, 0 disables the selection and AUTO stays at float precision. */
+GLHCKAPI void glhckSetGlobalPrecisionError(float error)
+{
+   GLHCK_INITIALIZED();
+   CALL(0, "%f", error);
+   GLHCKM()->globalVertexError = (error > 0.0f ? error : 0.0f);
+}
+
+/* \brief get maximum position error allowed for GLHCK_VTX_AUTO precision */
+GLHCKAPI float glhckGetGlobalPrecisionError(void)
+{
+   GLHCK_INITIALIZED();
+   TRACE(0);
+   RET(0, "%f", GLHCKM()->globalVertexError);
+   return GLHCKM()->globalVertexError;
+}
+
 #define _massacre(list, func) {                       \
    void *c;                                           \
    while ((c = GLHCKW()->list)) { while (func(c)); }  \
@@ -161,6 +161,9 @@ GLHCKAPI const glhckImportModelParameters* glhckImportDefaultModelParameters(voi
    static glhckImportModelParameters defaultParameters = {
       .animated   = 0,
       .flatten    = 0,
+      .optimize   = 0,
+      .weld       = 1,
+      .meshlets   = 1,
    };
    return &defaultParameters;
 }
@@ -459,6 +462,182 @@ void _glhckInvertPixels(unsigned char *pixels, unsigned int w, unsigned int h, u
    }
 }
 
+/* \brief give import buffers to geometry of object, buffers are adopted or released also on failure */
+static int _glhckImportAdoptBuffers(glhckObject *object, unsigned char itype, unsigned char vtype,
+      glhckImportIndexData *indices, unsigned int indexCount, glhckImportVertexData *vertices, unsigned int vertexCount)
+{
+   int ret;
+
+   if (!object->geometry && !(object->geometry = _glhckGeometryNew()))
+      goto fail;
+
+   if (indices) {
+      ret = _glhckGeometryAdoptImportIndices(object->geometry, indexCount, itype, indices);
+      indices = NULL;
+      if (ret != RETURN_OK) goto fail;
+   }
+
+   if (vertices) {
+      ret = _glhckGeometryAdoptImportVertices(object->geometry, vertexCount, vtype, vertices);
+      vertices = NULL;
+      if (ret != RETURN_OK) goto fail;
+   }
+
+   glhckObjectUpdate(object);
+   return RETURN_OK;
+
+fail:
+   IFDO(_glhckFree, indices);
+   IFDO(_glhckFree, vertices);
+   return RETURN_FAIL;
+}
+
+/* \brief weld import buffers if requested by parameters, RETURN_OK when welded buffers were allocated.
+ * animated models are not welded, since skin weights refer to vertices by index */
+static int _glhckImportWeld(const glhckImportModelParameters *params,
+      const glhckImportIndexData *indices, unsigned int *indexCount, const glhckImportVertexData *vertices, unsigned int *vertexCount,
+      glhckImportIndexData **outIndices, glhckImportVertexData **outVertices)
+{
+   unsigned int numWelded;
+
+   if (!params->weld || params->animated || !vertices || !*vertexCount ||
+       _glhckGeometryWeld(vertices, *vertexCount, indices, (indices ? *indexCount : *vertexCount), 0.0f,
+          outVertices, &numWelded, outIndices) != RETURN_OK)
+      return RETURN_FAIL;
+
+   *indexCount = (indices ? *indexCount : *vertexCount);
+   *vertexCount = numWelded;
+   return RETURN_OK;
+}
+
+/* \brief insert imported geometry to object, welding identical vertices if requested by parameters
+ * indices may be NULL for non indexed geometry. buffers are copied, welded buffers are adopted. */
+int _glhckImportInsertGeometry(glhckObject *object, const glhckImportModelParameters *params, unsigned char itype, unsigned char vtype,
+      const glhckImportIndexData *indices, unsigned int indexCount, const glhckImportVertexData *vertices, unsigned int vertexCount)
+{
+   glhckImportVertexData *welded = NULL;
+   glhckImportIndexData *weldedIndices = NULL;
+   CALL(0, "%p, %p, %u, %u, %p, %u, %p, %u", object, params, itype, vtype, indices, indexCount, vertices, vertexCount);
+   assert(object && params);
+
+   if (_glhckImportWeld(params, indices, &indexCount, vertices, &vertexCount, &weldedIndices, &welded) == RETURN_OK) {
+      if (_glhckImportAdoptBuffers(object, itype, vtype, weldedIndices, indexCount, welded, vertexCount) != RETURN_OK)
+         goto fail;
+
+      RET(0, "%d", RETURN_OK);
+      return RETURN_OK;
+   }
+
+   if (indices && glhckObjectInsertIndices(object, itype, indices, indexCount) != RETURN_OK)
+      goto fail;
+
+   if (vertices && glhckObjectInsertVertices(object, vtype, vertices, vertexCount) != RETURN_OK)
+      goto fail;
+
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+
+fail:
+   RET(0, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
+/* \brief insert imported geometry to object, taking ownership of the buffers
+ * buffers must come from glhck's allocator, geometry adopts them when their layout fits,
+ * otherwise they are released as soon as they are converted or welded (also on failure).
+ * this keeps only one copy of big models in memory while importing. */
+int _glhckImportAdoptGeometry(glhckObject *object, const glhckImportModelParameters *params, unsigned char itype, unsigned char vtype,
+      glhckImportIndexData *indices, unsigned int indexCount, glhckImportVertexData *vertices, unsigned int vertexCount)
+{
+   glhckImportVertexData *welded = NULL;
+   glhckImportIndexData *weldedIndices = NULL;
+   CALL(0, "%p, %p, %u, %u, %p, %u, %p, %u", object, params, itype, vtype, indices, indexCount, vertices, vertexCount);
+   assert(object && params);
+
+   if (_glhckImportWeld(params, indices, &indexCount, vertices, &vertexCount, &weldedIndices, &welded) == RETURN_OK) {
+      IFDO(_glhckFree, indices);
+      IFDO(_glhckFree, vertices);
+      indices = weldedIndices;
+      vertices = welded;
+   }
+
+   if (_glhckImportAdoptBuffers(object, itype, vtype, indices, indexCount, vertices, vertexCount) != RETURN_OK)
+      goto fail;
+
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+
+fail:
+   RET(0, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
+/* \brief stream imported geometry to object, vertices are decoded by func straight to the final vertex type.
+ * geometry takes ownership of indices (also on failure), indices may be NULL for non indexed geometry.
+ * welding is done on the final vertex type, so import vertex buffer is never needed. */
+int _glhckImportStreamGeometry(glhckObject *object, const glhckImportModelParameters *params, unsigned char itype, unsigned char vtype,
+      glhckImportIndexData *indices, unsigned int indexCount, unsigned int vertexCount, __GLHCKgeometryVertexFunc func, void *userData)
+{
+   unsigned int i;
+   int ret;
+   CALL(0, "%p, %p, %u, %u, %p, %u, %u, %p, %p", object, params, itype, vtype, indices, indexCount, vertexCount, func, userData);
+   assert(object && params && func);
+
+   if (!object->geometry && !(object->geometry = _glhckGeometryNew()))
+      goto fail;
+
+   if (_glhckGeometryStreamVertices(object->geometry, vertexCount, vtype, func, userData) != RETURN_OK)
+      goto fail;
+
+   /* animated models are not welded, since skin weights refer to vertices by index */
+   if (params->weld && !params->animated && vertexCount) {
+      if (!indices) {
+         if (!(indices = _glhckMalloc(vertexCount * sizeof(glhckImportIndexData))))
+            goto fail;
+
+         for (i = 0; i != vertexCount; ++i) indices[i] = i;
+         indexCount = vertexCount;
+      }
+
+      _glhckGeometryWeldVertices(object->geometry, indices, indexCount);
+   }
+
+   if (indices) {
+      ret = _glhckGeometryAdoptImportIndices(object->geometry, indexCount, itype, indices);
+      indices = NULL;
+      if (ret != RETURN_OK) goto fail;
+   }
+
+   glhckObjectUpdate(object);
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+
+fail:
+   IFDO(_glhckFree, indices);
+   RET(0, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
+/* \brief optimize imported geometry of object, if requested by parameters
+ * animated models keep their vertex order, since skin weights refer to vertices by index.
+ * big static geometry is split to meshlets before optimization, which then reorders inside each meshlet,
+ * skinned geometry moves out of their bounds */
+void _glhckImportOptimizeGeometry(glhckObject *object, const glhckImportModelParameters *params)
+{
+   CALL(0, "%p, %p", object, params);
+   assert(object && params);
+
+   if (!object->geometry || object->geometry->type != GLHCK_TRIANGLES)
+      return;
+
+   if (params->meshlets && !params->animated && object->geometry->indices &&
+       object->geometry->indexCount / 3 >= 4 * GLHCK_MESHLET_TRIANGLES)
+      glhckGeometryBuildMeshlets(object->geometry, 0);
+
+   if (params->optimize)
+      glhckGeometryOptimize(object->geometry, (params->animated ? GLHCK_OPTIMIZE_INDICES : GLHCK_OPTIMIZE_ALL));
+}
+
 #define ACTC_CHECK_SYNTAX  "%d: "__STRING(func)" returned unexpected "__STRING(c)"\n"
 #define ACTC_CALL_SYNTAX   "%d: "__STRING(func)" failed with %04X\n"
 
@@ -111,6 +111,21 @@ char* _glhckImportTexturePath(const char *texture_path, const char *asset_path);
 /* \brief invert pixel data */
 void _glhckInvertPixels(unsigned char *pixels, unsigned int w, unsigned int h, unsigned int components);
 
+/* \brief insert imported geometry, welding vertices if requested by parameters */
+int _glhckImportInsertGeometry(glhckObject *object, const glhckImportModelParameters *params, unsigned char itype, unsigned char vtype,
+      const glhckImportIndexData *indices, unsigned int indexCount, const glhckImportVertexData *vertices, unsigned int vertexCount);
+
+/* \brief insert imported geometry, geometry takes ownership of the buffers */
+int _glhckImportAdoptGeometry(glhckObject *object, const glhckImportModelParameters *params, unsigned char itype, unsigned char vtype,
+      glhckImportIndexData *indices, unsigned int indexCount, glhckImportVertexData *vertices, unsigned int vertexCount);
+
+/* \brief stream imported geometry straight to final vertex type, geometry takes ownership of indices */
+int _glhckImportStreamGeometry(glhckObject *object, const glhckImportModelParameters *params, unsigned char itype, unsigned char vtype,
+      glhckImportIndexData *indices, unsigned int indexCount, unsigned int vertexCount, __GLHCKgeometryVertexFunc func, void *userData);
+
+/* \brief optimize imported geometry, if requested by parameters */
+void _glhckImportOptimizeGeometry(glhckObject *object, const glhckImportModelParameters *params);
+
 /* \brief returns tristripped indecies from triangle indecies */
 glhckImportIndexData* _glhckTriStrip(const glhckImportIndexData *indices, unsigned int memb, unsigned int *outMemb);
 
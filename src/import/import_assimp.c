@@ -318,13 +318,45 @@ fail:
    return RETURN_FAIL;
 }
 
+/* \brief decode assimp mesh vertex to import format */
+static void meshVertex(void *userData, unsigned int index, glhckImportVertexData *out)
+{
+   const struct aiMesh *mesh = userData;
+   memset(out, 0, sizeof(glhckImportVertexData));
+
+   if (mesh->mVertices) {
+      out->vertex.x = mesh->mVertices[index].x;
+      out->vertex.y = mesh->mVertices[index].y;
+      out->vertex.z = mesh->mVertices[index].z;
+   }
+
+   if (mesh->mNormals) {
+      out->normal.x = mesh->mNormals[index].x;
+      out->normal.y = mesh->mNormals[index].y;
+      out->normal.z = mesh->mNormals[index].z;
+   }
+
+   if (mesh->mTextureCoords[0]) {
+      out->coord.x = mesh->mTextureCoords[0][index].x;
+      out->coord.y = mesh->mTextureCoords[0][index].y;
+
+      /* fix coords */
+      if (out->coord.x < 0.0f)
+         out->coord.x += 1;
+      if (out->coord.y < 0.0f)
+         out->coord.y += 1;
+   }
+}
+
+/* \brief build model from joined vertex data, or stream vertices straight from single mesh when vertexData is NULL */
 static int buildModel(glhckObject *object, unsigned int numIndices, unsigned int numVertices,
-      const glhckImportIndexData *indices, const glhckImportVertexData *vertexData,
-      glhckGeometryIndexType itype, glhckGeometryVertexType vtype)
+      const glhckImportIndexData *indices, const glhckImportVertexData *vertexData, const struct aiMesh *mesh,
+      glhckGeometryIndexType itype, glhckGeometryVertexType vtype, const glhckImportModelParameters *params)
 {
    unsigned int geometryType = GLHCK_TRIANGLE_STRIP;
    unsigned int numStrippedIndices = 0;
    glhckImportIndexData *stripIndices = NULL;
+   assert(vertexData || mesh);
 
    if (!numVertices)
       return RETURN_OK;
@@ -337,10 +369,22 @@ static int buildModel(glhckObject *object, unsigned int numIndices, unsigned int
    }
 
    /* set geometry */
-   glhckObjectInsertIndices(object, itype, (stripIndices?stripIndices:indices), numStrippedIndices);
-   glhckObjectInsertVertices(object, vtype, vertexData, numVertices);
+   if (!vertexData) {
+      /* geometry takes ownership of the indices it's given */
+      if (!stripIndices && !(stripIndices = _glhckCopy(indices, numIndices * sizeof(glhckImportIndexData))))
+         return RETURN_FAIL;
+
+      _glhckImportStreamGeometry(object, params, itype, vtype,
+            stripIndices, numStrippedIndices, numVertices, meshVertex, (void*)mesh);
+      stripIndices = NULL;
+   } else {
+      _glhckImportInsertGeometry(object, params, itype, vtype,
+            (stripIndices?stripIndices:indices), numStrippedIndices, vertexData, numVertices);
+   }
+
    object->geometry->type = geometryType;
    IFDO(_glhckFree, stripIndices);
+   _glhckImportOptimizeGeometry(object, params);
    return RETURN_OK;
 }
 
@@ -359,29 +403,12 @@ static void joinMesh(const struct aiMesh *mesh, unsigned int indexOffset,
 
       for (i = 0; i != face->mNumIndices; ++i) {
          index = face->mIndices[i];
+         indices[skip+i] = indexOffset + index;
 
-         if (mesh->mVertices) {
-            vertexData[index].vertex.x = mesh->mVertices[index].x;
-            vertexData[index].vertex.y = mesh->mVertices[index].y;
-            vertexData[index].vertex.z = mesh->mVertices[index].z;
-         }
-
-         if (mesh->mNormals) {
-            vertexData[index].normal.x = mesh->mNormals[index].x;
-            vertexData[index].normal.y = mesh->mNormals[index].y;
-            vertexData[index].normal.z = mesh->mNormals[index].z;
-         }
-
-         if (mesh->mTextureCoords[0]) {
-            vertexData[index].coord.x = mesh->mTextureCoords[0][index].x;
-            vertexData[index].coord.y = mesh->mTextureCoords[0][index].y;
+         /* only indices are needed when vertices are streamed */
+         if (!vertexData) continue;
 
-            /* fix coords */
-            if (vertexData[index].coord.x < 0.0f)
-               vertexData[index].coord.x += 1;
-            if (vertexData[index].coord.y < 0.0f)
-               vertexData[index].coord.y += 1;
-         }
+         meshVertex((void*)mesh, index, &vertexData[index]);
 
          /* offset texture coords to fit atlas texture */
          if (atlas && texture) {
@@ -392,8 +419,6 @@ static void joinMesh(const struct aiMesh *mesh, unsigned int indexOffset,
             vertexData[index].coord.x = coord.x;
             vertexData[index].coord.y = coord.y;
          }
-
-         indices[skip+i] = indexOffset + index;
       } skip += face->mNumIndices;
    }
 }
@@ -534,7 +559,7 @@ static int processModel(const char *file, glhckObject *object,
 
       /* finally build the model */
       if (buildModel(current, numIndices,  numVertices,
-               indices, vertexData, itype, vtype)  == RETURN_OK) {
+               indices, vertexData, NULL, itype, vtype, params)  == RETURN_OK) {
          _glhckObjectFile(current, nd->mName.data);
          if (material) glhckObjectMaterial(current, material);
          if (!(current = glhckObjectNew())) goto fail;
@@ -576,20 +601,16 @@ static int processModel(const char *file, glhckObject *object,
          if (hasTexture && !(material = glhckMaterialNew(texture)))
             goto assimp_no_memory;
 
-         /* allocate vertices */
-         if (!(vertexData = _glhckCalloc(numVertices, sizeof(glhckImportVertexData))))
-            goto assimp_no_memory;
-
-         /* allocate indices */
+         /* allocate indices, vertices are streamed from mesh */
          if (!(indices = _glhckMalloc(numIndices * sizeof(glhckImportIndexData))))
             goto assimp_no_memory;
 
-         /* fill arrays */
-         joinMesh(mesh, 0, indices, vertexData, NULL, NULL);
+         /* fill indices */
+         joinMesh(mesh, 0, indices, NULL, NULL, NULL);
 
          /* build model */
          if (buildModel(current, numIndices,  numVertices,
-                  indices, vertexData, itype, vtype) == RETURN_OK) {
+                  indices, NULL, mesh, itype, vtype, params) == RETURN_OK) {
 
             /* FIXME: UGLY */
             char pointer[16];
@@ -604,7 +625,6 @@ static int processModel(const char *file, glhckObject *object,
          }
 
          /* free stuff */
-         NULLDO(_glhckFree, vertexData);
          NULLDO(_glhckFree, indices);
          IFDO(glhckTextureFree, texture);
          IFDO(glhckMaterialFree, material);
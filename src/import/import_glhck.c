@@ -327,11 +327,6 @@ static int _glhckReadOBD(const char *file, uint8_t *version, FILE *f, glhckObjec
    /* flip endian, if needed */
    if (!chckBufferIsNativeEndian(buf)) chckBufferSwap(indices, sizeof(uint32_t), indexCount);
 
-   if (indices) {
-      glhckObjectInsertIndices(object, itype, indices, indexCount);
-      NULLDO(_glhckFree, indices);
-   }
-
    if (vertexCount && !(vertexData = _glhckCalloc(vertexCount, sizeof(glhckImportVertexData))))
       goto fail;
 
@@ -360,13 +355,16 @@ static int _glhckReadOBD(const char *file, uint8_t *version, FILE *f, glhckObjec
       }
    }
 
-   if (vertexData) {
-      glhckObjectInsertVertices(object, vtype, vertexData, vertexCount);
-      NULLDO(_glhckFree, vertexData);
+   if (indices || vertexData) {
+      /* geometry takes the decode buffers */
+      _glhckImportAdoptGeometry(object, params, itype, vtype, indices, indexCount, vertexData, vertexCount);
+      indices = NULL;
+      vertexData = NULL;
    }
 
    /* we just assume TRIANGLES for now 0.1 doesn't support anything else */
    if (object->geometry) object->geometry->type = GLHCK_TRIANGLES;
+   _glhckImportOptimizeGeometry(object, params);
 
    if (materialCount && !(materials = _glhckCalloc(materialCount, sizeof(glhckMaterial*))))
       goto fail;
@@ -37,6 +37,57 @@ fail:
    return RETURN_FAIL;
 }
 
+/* source of streamed vertices */
+typedef struct _glhckMMDVertexSource {
+   const mmd_data *mmd;
+   glhckAtlas *atlas;
+   glhckTexture **textureList;
+   const unsigned int *materials; /* material of each vertex, num_materials if unused */
+} _glhckMMDVertexSource;
+
+/* \brief decode MMD vertex to import format */
+static void _glhckMMDVertex(void *userData, unsigned int ix, glhckImportVertexData *out)
+{
+   const _glhckMMDVertexSource *source = userData;
+   const mmd_data *mmd = source->mmd;
+   unsigned int material = source->materials[ix];
+   memset(out, 0, sizeof(glhckImportVertexData));
+
+   /* unused vertex */
+   if (material >= mmd->num_materials)
+      return;
+
+   /* vertices */
+   out->vertex.x = mmd->vertices[ix*3+0];
+   out->vertex.y = mmd->vertices[ix*3+1];
+   out->vertex.z = mmd->vertices[ix*3+2];
+
+   /* normals */
+   out->normal.x = mmd->normals[ix*3+0];
+   out->normal.y = mmd->normals[ix*3+1];
+   out->normal.z = mmd->normals[ix*3+2];
+
+   /* texture coords */
+   out->coord.x = mmd->coords[ix*2+0];
+   out->coord.y = mmd->coords[ix*2+1] * -1;
+
+   /* fix coords */
+   if (out->coord.x < 0.0f)
+      out->coord.x += 1.0f;
+   if (out->coord.y < 0.0f)
+      out->coord.y += 1.0f;
+
+   /* if there is packed texture */
+   if (source->atlas && source->textureList[material]) {
+      kmVec2 coord;
+      coord.x = out->coord.x;
+      coord.y = out->coord.y;
+      glhckAtlasTransformCoordinates(source->atlas, source->textureList[material], &coord, &coord);
+      out->coord.x = coord.x;
+      out->coord.y = coord.y;
+   }
+}
+
 /* \brief import MikuMikuDance PMD file */
 int _glhckImportPMD(_glhckObject *object, const char *file, const glhckImportModelParameters *params,
       unsigned char itype, unsigned char vtype)
@@ -47,7 +98,8 @@ int _glhckImportPMD(_glhckObject *object, const char *file, const glhckImportMod
    glhckAtlas *atlas = NULL;
    glhckMaterial *material = NULL;
    glhckTexture *texture = NULL, **textureList = NULL;
-   glhckImportVertexData *vertexData = NULL;
+   _glhckMMDVertexSource source;
+   unsigned int *materials = NULL;
    glhckImportIndexData *indices = NULL, *stripIndices = NULL;
    unsigned int geometryType = GLHCK_TRIANGLE_STRIP;
    unsigned int i, i2, ix, start, numFaces, numIndices = 0;
@@ -79,9 +131,12 @@ int _glhckImportPMD(_glhckObject *object, const char *file, const glhckImportMod
    }
    if (mmd->header.comment) printf("%s\n\n", mmd->header.comment);
 
-   if (!(vertexData = _glhckCalloc(mmd->num_vertices, sizeof(glhckImportVertexData))))
+   /* vertices are streamed straight to geometry, only their materials are gathered here */
+   if (!(materials = _glhckMalloc(mmd->num_vertices * sizeof(unsigned int))))
       goto mmd_no_memory;
 
+   for (i = 0; i < mmd->num_vertices; ++i) materials[i] = mmd->num_materials;
+
    if (!(indices = _glhckMalloc(mmd->num_indices * sizeof(unsigned int))))
       goto mmd_no_memory;
 
@@ -124,36 +179,7 @@ int _glhckImportPMD(_glhckObject *object, const char *file, const glhckImportMod
       for (i2 = start; i2 < start + numFaces; ++i2) {
          ix = mmd->indices[i2];
 
-         /* vertices */
-         vertexData[ix].vertex.x = mmd->vertices[ix*3+0];
-         vertexData[ix].vertex.y = mmd->vertices[ix*3+1];
-         vertexData[ix].vertex.z = mmd->vertices[ix*3+2];
-
-         /* normals */
-         vertexData[ix].normal.x = mmd->normals[ix*3+0];
-         vertexData[ix].normal.y = mmd->normals[ix*3+1];
-         vertexData[ix].normal.z = mmd->normals[ix*3+2];
-
-         /* texture coords */
-         vertexData[ix].coord.x = mmd->coords[ix*2+0];
-         vertexData[ix].coord.y = mmd->coords[ix*2+1] * -1;
-
-         /* fix coords */
-         if (vertexData[ix].coord.x < 0.0f)
-            vertexData[ix].coord.x += 1.0f;
-         if (vertexData[ix].coord.y < 0.0f)
-            vertexData[ix].coord.y += 1.0f;
-
-         /* if there is packed texture */
-         if (atlas && textureList[i]) {
-            kmVec2 coord;
-            coord.x = vertexData[ix].coord.x;
-            coord.y = vertexData[ix].coord.y;
-            glhckAtlasTransformCoordinates(atlas, textureList[i], &coord, &coord);
-            vertexData[ix].coord.x = coord.x;
-            vertexData[ix].coord.y = coord.y;
-         }
-
+         materials[ix] = i;
          indices[i2] = ix;
       }
    }
@@ -164,8 +190,6 @@ int _glhckImportPMD(_glhckObject *object, const char *file, const glhckImportMod
 
       glhckObjectMaterial(object, material);
       NULLDO(glhckMaterialFree, material);
-      NULLDO(glhckAtlasFree, atlas);
-      NULLDO(_glhckFree, textureList);
    }
 
    /* triangle strip geometry */
@@ -174,16 +198,24 @@ int _glhckImportPMD(_glhckObject *object, const char *file, const glhckImportMod
       geometryType   = GLHCK_TRIANGLES;
       numIndices    = mmd->num_indices;
       stripIndices  = indices;
+      indices       = NULL;
    } else NULLDO(_glhckFree, indices);
 
-   /* set geometry */
-   glhckObjectInsertIndices(object, itype, stripIndices, numIndices);
-   glhckObjectInsertVertices(object, vtype, vertexData, mmd->num_vertices);
+   /* set geometry, vertices are decoded while converting to vertex type */
+   source.mmd = mmd;
+   source.atlas = atlas;
+   source.textureList = textureList;
+   source.materials = materials;
+   _glhckImportStreamGeometry(object, params, itype, vtype,
+         stripIndices, numIndices, mmd->num_vertices, _glhckMMDVertex, &source);
+   stripIndices = NULL;
    object->geometry->type = geometryType;
+   _glhckImportOptimizeGeometry(object, params);
 
    /* finish */
-   NULLDO(_glhckFree, vertexData);
-   NULLDO(_glhckFree, stripIndices);
+   IFDO(glhckAtlasFree, atlas);
+   IFDO(_glhckFree, textureList);
+   NULLDO(_glhckFree, materials);
    NULLDO(mmd_free, mmd);
 
    RET(0, "%d", RETURN_OK);
@@ -202,7 +234,7 @@ fail:
    IFDO(glhckAtlasFree, atlas);
    IFDO(mmd_free, mmd);
    IFDO(_glhckFree, textureList);
-   IFDO(_glhckFree, vertexData);
+   IFDO(_glhckFree, materials);
    IFDO(_glhckFree, indices);
    IFDO(_glhckFree, stripIndices);
    RET(0, "%d", RETURN_FAIL);
@@ -58,19 +58,53 @@ fail:
    return RETURN_FAIL;
 }
 
+/* source of streamed vertices */
+typedef struct _glhckOCTMVertexSource {
+   const CTMfloat *vertices, *normals, *coords, *colors;
+} _glhckOCTMVertexSource;
+
+/* \brief decode OpenCTM vertex to import format, OpenCTM is z up */
+static void _glhckOCTMVertex(void *userData, unsigned int ix, glhckImportVertexData *out)
+{
+   const _glhckOCTMVertexSource *source = userData;
+   memset(out, 0, sizeof(glhckImportVertexData));
+
+   out->vertex.x = source->vertices[ix*3+0];
+   out->vertex.z = source->vertices[ix*3+1] * -1;
+   out->vertex.y = source->vertices[ix*3+2];
+
+   if (source->normals) {
+      out->normal.x = source->normals[ix*3+0];
+      out->normal.z = source->normals[ix*3+1] * -1;
+      out->normal.y = source->normals[ix*3+2];
+   }
+
+   if (source->coords) {
+      out->coord.x = source->coords[ix*2+0];
+      out->coord.y = source->coords[ix*2+1];
+   }
+
+   if (source->colors) {
+      out->color.r = source->colors[ix*4+0]*255.0f;
+      out->color.g = source->colors[ix*4+1]*255.0f;
+      out->color.b = source->colors[ix*4+2]*255.0f;
+      out->color.a = source->colors[ix*4+3]*255.0f;
+   }
+}
+
 /* \brief import OpenCTM file */
 int _glhckImportOpenCTM(glhckObject *object, const char *file, const glhckImportModelParameters *params,
       unsigned char itype, unsigned char vtype)
 {
    FILE *f;
-   unsigned int i, ix, *stripIndices = NULL, numIndices = 0;
+   unsigned int i, *stripIndices = NULL, numIndices = 0;
    CTMcontext context = NULL;
    CTMuint num_vertices, numTriangles, numUvs, numAttribs;
    const CTMuint *indices;
    const CTMfloat *vertices = NULL, *normals = NULL, *coords = NULL, *colors = NULL;
    const char *attribName, *comment, *textureFilename;
    char *texturePath;
-   glhckImportVertexData *vertexData = NULL;
+   _glhckOCTMVertexSource source;
    glhckMaterial *material;
    glhckTexture *texture;
    unsigned int geometryType = GLHCK_TRIANGLE_STRIP;
@@ -132,54 +166,30 @@ int _glhckImportOpenCTM(glhckObject *object, const char *file, const glhckImport
    comment = CTM_CALL(context, ctmGetString(context, CTM_FILE_COMMENT));
    if (comment) DEBUG(GLHCK_DBG_CRAP, "%s", comment);
 
-   /* process vertex data to import format */
-   if (!(vertexData = _glhckCalloc(num_vertices, sizeof(glhckImportVertexData))))
-      goto fail;
-
-   for (i = 0; i < numTriangles; ++i) {
-      ix = indices[i];
-
-      vertexData[ix].vertex.x = vertices[ix*3+0];
-      vertexData[ix].vertex.z = vertices[ix*3+1] * -1;
-      vertexData[ix].vertex.y = vertices[ix*3+2];
-
-      if (normals) {
-         vertexData[ix].normal.x = normals[ix*3+0];
-         vertexData[ix].normal.z = normals[ix*3+1] * -1;
-         vertexData[ix].normal.y = normals[ix*3+2];
-      }
-
-      if (coords) {
-         vertexData[ix].coord.x = coords[ix*2+0];
-         vertexData[ix].coord.y = coords[ix*2+1];
-      }
-
-      if (colors) {
-         vertexData[ix].color.r = colors[ix*4+0]*255.0f;
-         vertexData[ix].color.g = colors[ix*4+1]*255.0f;
-         vertexData[ix].color.b = colors[ix*4+2]*255.0f;
-         vertexData[ix].color.a = colors[ix*4+3]*255.0f;
-      }
-   }
-
    /* triangle strip geometry */
    if (!(stripIndices = _glhckTriStrip(indices, numTriangles, &numIndices))) {
-      /* failed, use non stripped geometry */
+      /* failed, use non stripped geometry, geometry needs its own copy of indices */
       geometryType = GLHCK_TRIANGLES;
       numIndices  = numTriangles;
+      if (!(stripIndices = _glhckCopy(indices, numTriangles * sizeof(glhckImportIndexData))))
+         goto fail;
    }
 
    /* this object has colors */
    if (colors) object->flags |= GLHCK_OBJECT_VERTEX_COLOR;
 
-   /* set geometry */
-   glhckObjectInsertIndices(object, itype, stripIndices?stripIndices:indices, numIndices);
-   glhckObjectInsertVertices(object, vtype, vertexData, num_vertices);
+   /* set geometry, vertices are decoded while converting to vertex type */
+   source.vertices = vertices;
+   source.normals = normals;
+   source.coords = coords;
+   source.colors = colors;
+   _glhckImportStreamGeometry(object, params, itype, vtype,
+         stripIndices, numIndices, num_vertices, _glhckOCTMVertex, &source);
+   stripIndices = NULL;
    object->geometry->type = geometryType;
+   _glhckImportOptimizeGeometry(object, params);
 
    /* finish */
-   IFDO(_glhckFree, stripIndices);
-   NULLDO(_glhckFree, vertexData);
    NULLDO(ctmFreeContext, context);
 
    RET(0, "%d", RETURN_OK);
@@ -190,7 +200,6 @@ read_fail:
    goto fail;
 fail:
    IFDO(_glhckFree, stripIndices);
-   IFDO(_glhckFree, vertexData);
    IFDO(fclose, f);
    IFDO(ctmFreeContext, context);
    RET(0, "%d", RETURN_FAIL);
@@ -55,7 +55,7 @@
 #  define GLHCK_IMPORT_DYNAMIC 0
 #endif
 #ifndef GLHCK_TEXT_FLOAT_PRECISION
-#  define GLHCK_TEXT_FLOAT_PRECISION 1
+#  define GLHCK_TEXT_FLOAT_PRECISION 0
 #endif
 #ifndef GLHCK_DISABLE_TRACE
 #  define GLHCK_DISABLE_TRACE 0
@@ -63,6 +63,12 @@
 #ifndef USE_DOUBLE_PRECISION
 #  define USE_DOUBLE_PRECISION 0
 #endif
+#ifndef GLHCK_HAS_PTHREADS
+#  define GLHCK_HAS_PTHREADS 0
+#endif
+#ifndef GLHCK_MAX_HW_SKIN_BONES
+#  define GLHCK_MAX_HW_SKIN_BONES 128 /* must fit to unsigned char */
+#endif
 
 /* renderer checks */
 
@@ -100,6 +106,7 @@
 #define GLHCK_CHANNEL_HWBUFFER      "HWBUFFER"
 #define GLHCK_CHANNEL_SHADER        "SHADER"
 #define GLHCK_CHANNEL_COLLISION     "COLLISION"
+#define GLHCK_CHANNEL_JOB           "JOB"
 #define GLHCK_CHANNEL_ALLOC         "ALLOC"
 #define GLHCK_CHANNEL_RENDER        "RENDER"
 #define GLHCK_CHANNEL_TRACE         "TRACE"
@@ -142,6 +149,8 @@ typedef enum _glhckShaderAttrib {
    GLHCK_ATTRIB_NORMAL,
    GLHCK_ATTRIB_TEXTURE,
    GLHCK_ATTRIB_COLOR,
+   GLHCK_ATTRIB_BONE_INDEX,
+   GLHCK_ATTRIB_BONE_WEIGHT,
    GLHCK_ATTRIB_LAST
 } _glhckShaderAttrib;
 
@@ -275,12 +284,34 @@ typedef struct _glhckTexture {
    glhckTextureTarget target;
 } _glhckTexture;
 
+/* texture packer placement methods */
+typedef enum _glhckTexturePackerMethod {
+   GLHCK_PACKER_MAXRECTS, /* free rectangles, best short side fit */
+   GLHCK_PACKER_SKYLINE, /* skyline, bottom left */
+} _glhckTexturePackerMethod;
+
+/* order textures are placed in by _glhckTexturePackerPack */
+typedef enum _glhckTexturePackerSort {
+   GLHCK_PACKER_SORT_NONE,
+   GLHCK_PACKER_SORT_AREA,
+   GLHCK_PACKER_SORT_MAX_SIDE,
+   GLHCK_PACKER_SORT_PERIMETER,
+   GLHCK_PACKER_SORT_HEIGHT,
+} _glhckTexturePackerSort;
+
 /* texture packer container */
 typedef struct _glhckTexturePacker {
-   struct tpNode *free_list;
    struct tpTexture *textures;
+   struct tpRect *free_rects; /* maximal free rectangles of maxrects bin */
+   struct tpSkyline *skyline; /* skyline of skyline bin */
+   int free_count, free_allocated;
+   int skyline_count, skyline_allocated;
+   int bin_width, bin_height;
    int longest_edge, total_area;
-   unsigned short debug_count, texture_index, texture_count;
+   unsigned short texture_index, texture_count;
+   _glhckTexturePackerMethod method;
+   _glhckTexturePackerSort sort;
+   char rotate;
 } _glhckTexturePacker;
 
 /* representation of packed area */
@@ -338,11 +369,64 @@ typedef struct __GLHCKgeometrySkinning {
    void *zero; /* zeroed vertex data for initial state */
 } __GLHCKgeometrySkinning;
 
+/* flattened bone hierarchy of skinned object
+ * bones are stored in parent before child order */
+typedef struct __GLHCKboneHierarchy {
+   struct _glhckBone **bones;
+   int *parents; /* index to parent bone in bones, -1 for root */
+   unsigned int numBones;
+   unsigned int revision; /* world bone revision this was built from */
+} __GLHCKboneHierarchy;
+
+/* per vertex bone influences for hardware skinning
+ * weights are normalized, so their sum is 255 */
+#define GLHCK_SKIN_INFLUENCES 4
+typedef struct __GLHCKskinVertex {
+   unsigned char bones[GLHCK_SKIN_INFLUENCES];
+   unsigned char weights[GLHCK_SKIN_INFLUENCES];
+} __GLHCKskinVertex;
+
+/* slot of bone name hash table */
+typedef struct __GLHCKboneTableSlot {
+   unsigned int hash;
+   unsigned int index; /* index + 1 to the named array, 0 for empty slot */
+} __GLHCKboneTableSlot;
+
+/* hash table for looking up bones by name */
+typedef struct __GLHCKboneTable {
+   struct __GLHCKboneTableSlot *slots;
+   unsigned int size; /* power of two */
+   unsigned int revision;
+} __GLHCKboneTable;
+
+/* returns name of item at index in the array hashed by bone table */
+typedef const char* (*__GLHCKboneTableNameFunc)(const void *array, unsigned int index);
+
+/* bone influence of vertex for CPU skinning */
+typedef struct __GLHCKskinInfluence {
+   unsigned int bone;
+   float weight;
+} __GLHCKskinInfluence;
+
+/* skinning state of object */
+typedef struct __GLHCKobjectSkinning {
+   struct __GLHCKskinVertex *vertices; /* bone influences per vertex for renderer */
+   struct __GLHCKskinInfluence *influences; /* bone influences of vertices for CPU */
+   unsigned int *influenceOffsets; /* first influence of each vertex, vertexCount + 1 */
+   kmMat4 *palette; /* skinning matrices */
+   kmAABB *boneBounds; /* bind pose bounding box of vertices weighted by each skin bone */
+   char unweighted; /* are there vertices without weights? (they collapse to origin) */
+   char renderer; /* is the object skinned by renderer? */
+} __GLHCKobjectSkinning;
+
 /* object container */
 typedef void (*__GLHCKobjectDraw) (const struct _glhckObject *object);
 typedef struct _glhckObject {
-   void *bind, *zero; /* temporary for skinning, will be removed */
+   void *bind; /* rest pose vertices, only kept while skinned on CPU */
    struct __GLHCKobjectView view;
+   struct __GLHCKboneHierarchy hierarchy;
+   struct __GLHCKobjectSkinning skinning;
+   struct __GLHCKboneTable boneTable, skinBoneTable;
    struct _glhckMaterial *material;
    struct _glhckObject *parent;
    struct _glhckObject **childs;
@@ -380,28 +464,73 @@ typedef struct _glhckSkinBone {
    unsigned int numWeights;
 } _glhckSkinBone;
 
+/* largest value of packed animation key */
+#define GLHCK_PACKED_MAX 65535.0f
+
+/* packed animation key
+ * time and values are quantized to range of the channel,
+ * rotations are stored as smallest three components */
+typedef struct __GLHCKanimationPackedKey {
+   unsigned short time;
+   unsigned short value[3];
+} __GLHCKanimationPackedKey;
+
+/* packed animation channel */
+typedef struct __GLHCKanimationPackedChannel {
+   struct __GLHCKanimationPackedKey *keys;
+   kmVec3 min, range; /* dequantization range of vectors */
+   float minTime, timeRange;
+   unsigned int numKeys;
+} __GLHCKanimationPackedChannel;
+
+/* compressed keys of animation node */
+typedef struct __GLHCKanimationPacked {
+   struct __GLHCKanimationPackedChannel translations;
+   struct __GLHCKanimationPackedChannel rotations;
+   struct __GLHCKanimationPackedChannel scalings;
+} __GLHCKanimationPacked;
+
 /* animation node container
  * contains keys for each bone (translation, rotation, scaling) */
 typedef struct _glhckAnimationNode {
    struct glhckAnimationQuaternionKey *rotations;
    struct glhckAnimationVectorKey *translations;
    struct glhckAnimationVectorKey *scalings;
+   struct __GLHCKanimationPacked *packed; /* compressed keys, NULL if not compressed */
    char *boneName;
    REFERENCE_COUNTED(_glhckAnimationNode);
+   unsigned int revision; /* bumped when keys or bone name change */
    unsigned int numTranslations;
    unsigned int numRotations;
    unsigned int numScalings;
 } _glhckAnimationNode;
 
+/* how many evaluated poses animation caches */
+#ifndef GLHCK_ANIMATION_POSE_CACHE
+#  define GLHCK_ANIMATION_POSE_CACHE 4
+#endif
+
+/* evaluated pose of animation
+ * shared by animators that play the animation at same time */
+typedef struct __GLHCKanimationPose {
+   kmMat4 *matrices; /* local transformation for each node */
+   float time;
+   unsigned int lastUse;
+} __GLHCKanimationPose;
+
 /* animation container
  * stores information for single animation */
 typedef struct _glhckAnimation {
    struct _glhckAnimationNode **nodes;
    char *name;
+   struct __GLHCKanimationPose poses[GLHCK_ANIMATION_POSE_CACHE];
    REFERENCE_COUNTED(_glhckAnimation);
    float ticksPerSecond;
    float duration;
    unsigned int numNodes;
+   unsigned int poseTick;
+   unsigned int revision; /* bumped when nodes or their keys change */
+   unsigned int nodeRevision, worldRevision; /* detect changes of nodes, which may be shared */
 } _glhckAnimation;
 
 /* stores history of glhckAnimatioNode */
@@ -412,14 +541,35 @@ typedef struct _glhckAnimatorState {
    unsigned int scalingFrame;
 } _glhckAnimatorState;
 
+/* how many node -> bone mappings animator caches */
+#ifndef GLHCK_ANIMATOR_BINDING_CACHE
+#  define GLHCK_ANIMATOR_BINDING_CACHE 4
+#endif
+
+/* cached node -> bone mapping of animation
+ * animator owns one skeleton, so its bindings are per (animation, skeleton) pair */
+typedef struct __GLHCKanimatorBinding {
+   struct _glhckAnimation *animation;
+   struct _glhckBone **bones; /* bone for each animation node */
+   unsigned int boneNameRevision, animationRevision;
+} __GLHCKanimatorBinding;
+
 /* animator object
  * animates glhckObject, using glhckBones and glhckAnimation */
 typedef struct _glhckAnimator {
    struct _glhckAnimation *animation;
    struct _glhckAnimatorState *previousNodes;
    struct _glhckBone **bones;
+   struct __GLHCKboneTable boneTable;
+   struct __GLHCKanimatorBinding bindings[GLHCK_ANIMATOR_BINDING_CACHE];
+   unsigned int nextBinding;
    REFERENCE_COUNTED(_glhckAnimator);
    float lastTime;
+   float timeStep; /* time quantization for shared poses, 0 if not shared */
+   float lodNear, lodFar; /* distances of update rate lod */
+   unsigned int lodMaxInterval; /* update interval at far distance, 0 if no lod */
+   unsigned int updateInterval; /* update every n:th tick */
+   unsigned int updateTick, updatePhase; /* staggers the updates */
    unsigned int numBones;
    char dirty;
 } _glhckAnimator;
@@ -445,16 +595,27 @@ typedef struct __GLHCKtextTexture {
    struct __GLHCKtextTextureRow *rows;
    struct __GLHCKtextTexture *next;
    struct _glhckTexture *texture;
+   unsigned char *pixels; /* CPU copy of glyph page, uploaded in bands of rows */
    float internalWidth, internalHeight;
    int rowsCount, allocatedCount;
+   int dirtyY1, dirtyY2; /* rows with glyphs not uploaded yet */
+   char distanceField; /* page holds signed distance field glyphs */
 } __GLHCKtextTexture;
 
+/* quads addressable with 16-bit text indices */
+#define GLHCK_TEXT_QUAD_BATCH (65536/4)
+
 /* text container */
 typedef struct _glhckText {
    struct _glhckShader *shader;
-   struct __GLHCKtextFont *fontCache;
+   struct __GLHCKtextFont **fonts; /* indexed by font id - 1, freed fonts leave NULL slot */
    struct __GLHCKtextTexture *textureCache;
+   struct __GLHCKtextPendingGlyph *pending; /* glyphs waiting for rasterization */
+   struct __GLHCKtextLayoutCache *layoutCache; /* laid out strings */
    REFERENCE_COUNTED(_glhckText);
+   unsigned short *indices; /* shared indices of text quads */
+   unsigned int pendingCount, pendingAllocated;
+   unsigned int fontCount, indexQuads;
    unsigned int textureRange;
    int cacheWidth, cacheHeight;
    struct glhckColorb color;
@@ -585,6 +746,9 @@ typedef void (*__GLHCKrenderAPIobjectRender) (const _glhckObject *object);
 typedef void (*__GLHCKrenderAPItextRender) (const _glhckText *text);
 typedef void (*__GLHCKrenderAPIfrustumRender) (glhckFrustum *frustum);
 
+/* dynamic geometry streaming */
+typedef void (*__GLHCKrenderAPIstreamStatistics) (glhckRenderStreamStatistics *statistics);
+
 /* screen control */
 typedef void (*__GLHCKrenderAPIbufferGetPixels) (int x, int y, int width, int height, glhckTextureFormat format, glhckDataType type, void *data);
 
@@ -660,6 +824,8 @@ typedef struct __GLHCKrenderAPI {
    GLHCK_INCLUDE_INTERNAL_RENDER_API_FUNCTION(textRender);
    GLHCK_INCLUDE_INTERNAL_RENDER_API_FUNCTION(frustumRender);
 
+   GLHCK_INCLUDE_INTERNAL_RENDER_API_FUNCTION(streamStatistics);
+
    GLHCK_INCLUDE_INTERNAL_RENDER_API_FUNCTION(bufferGetPixels);
 
    GLHCK_INCLUDE_INTERNAL_RENDER_API_FUNCTION(textureGenerate);
@@ -818,6 +984,10 @@ typedef struct __GLHCKworld {
    struct _glhckShader           *shader;
    struct __GLHCKvertexType      *vertexType;
    struct __GLHCKindexType       *indexType;
+   unsigned int boneRevision; /* bumped when bone hierarchy changes */
+   unsigned int animationRevision; /* bumped when animation keys or nodes change */
+   unsigned int boneNameRevision; /* bumped when bone is renamed */
+   unsigned int animatorPhase; /* update phase for next animator */
    unsigned char numVertexTypes, numIndexTypes;
 } __GLHCKworld;
 
@@ -847,6 +1017,7 @@ typedef struct __GLHCKalloc {
 /* misc context options */
 typedef struct __GLHCKmisc {
    unsigned char globalIndexType, globalVertexType;
+   float globalVertexError;
    char coloredLog;
 } __GLHCKmisc;
 
@@ -856,6 +1027,7 @@ typedef struct __GLHCKcontext {
    struct __GLHCKworld world;
    struct __GLHCKtrace trace;
    struct __GLHCKmisc misc;
+   struct __GLHCKjobs *jobs; /* job threads, NULL when jobs run inline */
 #ifndef NDEBUG
    struct __GLHCKalloc *alloc;
 #endif
@@ -936,6 +1108,13 @@ void _glhckTrackTerminate(void);
 #define _glhckTrackSteal(x) ;
 #endif
 
+/* job functions */
+typedef void (*__GLHCKjobFunc)(void *userData, unsigned int index);
+void _glhckJobParallelFor(unsigned int count, __GLHCKjobFunc func, void *userData);
+void _glhckJobLock(void);
+void _glhckJobUnlock(void);
+void _glhckJobTerminate(void);
+
 /* util functions */
 void _glhckRed(void);
 void _glhckGreen(void);
@@ -957,6 +1136,10 @@ void _glhckTexturePackerCount(_glhckTexturePacker *tp, short textureCount);
 short _glhckTexturePackerAdd(_glhckTexturePacker *tp, int width, int height);
 int _glhckTexturePackerPack(_glhckTexturePacker *tp, int *width, int *height, const int forcePowerOfTwo, const int onePixelBorder);
 int _glhckTexturePackerGetLocation(const _glhckTexturePacker *tp, int index, int *x, int *y, int *width, int *height);
+void _glhckTexturePackerHeuristics(_glhckTexturePacker *tp, _glhckTexturePackerMethod method, _glhckTexturePackerSort sort, int rotate);
+int _glhckTexturePackerBin(_glhckTexturePacker *tp, int width, int height);
+short _glhckTexturePackerInsert(_glhckTexturePacker *tp, int width, int height);
+float _glhckTexturePackerOccupancy(const _glhckTexturePacker *tp);
 _glhckTexturePacker* _glhckTexturePackerNew(void);
 void _glhckTexturePackerFree(_glhckTexturePacker *tp);
 
@@ -970,8 +1153,23 @@ void _glhckObjectFile(_glhckObject *object, const char *file);
 void _glhckObjectInsertToQueue(_glhckObject *object);
 void _glhckObjectUpdateBoxes(glhckObject *object);
 
+/* bones */
+const char* _glhckBoneTableBoneName(const void *array, unsigned int index);
+int _glhckBoneTableBuild(__GLHCKboneTable *table, const void *array, unsigned int memb, __GLHCKboneTableNameFunc nameFunc);
+int _glhckBoneTableFind(const __GLHCKboneTable *table, const void *array, __GLHCKboneTableNameFunc nameFunc, const char *name);
+void _glhckBoneTableRelease(__GLHCKboneTable *table);
+
 /* skin bones */
 void _glhckSkinBoneTransformObject(glhckObject *object, int updateBones);
+void _glhckSkinBoneReleaseHierarchy(glhckObject *object);
+void _glhckSkinBoneBuildPalette(const glhckObject *object, kmMat4 *palette);
+
+/* animations */
+void _glhckAnimationPackedVectorKey(const __GLHCKanimationPackedChannel *channel, unsigned int index, glhckAnimationVectorKey *out);
+void _glhckAnimationPackedQuaternionKey(const __GLHCKanimationPackedChannel *channel, unsigned int index, glhckAnimationQuaternionKey *out);
+unsigned int _glhckAnimationRevision(glhckAnimation *object);
+kmMat4* _glhckAnimationGetPose(glhckAnimation *object, float time);
+kmMat4* _glhckAnimationNewPose(glhckAnimation *object, float time);
 
 /* camera */
 void _glhckCameraWorldUpdate(int width, int height);
@@ -999,6 +1197,12 @@ void _glhckTrace(int level, const char *channel, const char *function, const cha
 void _glhckPassDebug(const char *file, int line, const char *func, glhckDebugLevel level, const char *channel, const char *fmt, ...);
 #endif
 
+/* default maximum triangles in meshlet */
+#define GLHCK_MESHLET_TRIANGLES 64
+
+/* decodes source vertex at index for streaming import */
+typedef void (*__GLHCKgeometryVertexFunc)(void *userData, unsigned int index, glhckImportVertexData *out);
+
 /* internal geometry vertexdata */
 int _glhckGeometryInit(void);
 void _glhckGeometryTerminate(void);
@@ -1007,6 +1211,21 @@ glhckGeometry *_glhckGeometryCopy(glhckGeometry *src);
 void _glhckGeometryFree(glhckGeometry *geometry);
 int _glhckGeometryInsertVertices(glhckGeometry *geometry, int memb, unsigned char type, const glhckImportVertexData *vertices);
 int _glhckGeometryInsertIndices(glhckGeometry *geometry, int memb, unsigned char type, const glhckImportIndexData *indices);
+int _glhckGeometryAdoptImportVertices(glhckGeometry *geometry, int memb, unsigned char type, glhckImportVertexData *vertices);
+int _glhckGeometryAdoptImportIndices(glhckGeometry *geometry, int memb, unsigned char type, glhckImportIndexData *indices);
+int _glhckGeometryStreamVertices(glhckGeometry *geometry, int memb, unsigned char type, __GLHCKgeometryVertexFunc func, void *userData);
+void _glhckPositionsMinMax(const void *positions, size_t stride, size_t readable, unsigned int count,
+      glhckDataType dataType, unsigned int memb, glhckVector3f *min, glhckVector3f *max);
+void _glhckGeometryMinMax(glhckGeometry *geometry, glhckVector3f *min, glhckVector3f *max);
+int _glhckGeometryVertexPosition(const __GLHCKvertexType *type, const void *vertices, unsigned int index, kmVec3 *out);
+void _glhckGeometryWriteVertexPosition(const __GLHCKvertexType *type, void *vertices, unsigned int index, const kmVec3 *position);
+int _glhckGeometryWeld(const glhckImportVertexData *vertices, unsigned int memb,
+      const glhckImportIndexData *indices, unsigned int indexCount, float epsilon,
+      glhckImportVertexData **outVertices, unsigned int *outMemb, glhckImportIndexData **outIndices);
+int _glhckGeometryWeldVertices(glhckGeometry *geometry, glhckImportIndexData *indices, unsigned int indexCount);
+glhckImportIndexData* _glhckGeometryReadIndices(const glhckGeometry *geometry);
+void _glhckGeometryFreeMeshlets(glhckGeometry *geometry);
+unsigned int _glhckGeometryCullMeshlets(const glhckGeometry *geometry, const kmMat4 *model, int cullFace, unsigned int *ranges);
 
 /***
  * Kazmath extension
@@ -0,0 +1,339 @@
+#include "internal.h"
+
+#if GLHCK_HAS_PTHREADS
+#  include <pthread.h> /* for pthread */
+#endif
+
+/* tracing channel for this file */
+#define GLHCK_CHANNEL GLHCK_CHANNEL_JOB
+
+/* Jobs are index ranges of a parallel for.
+ * Every worker (and the calling thread) starts with its own slice of the range,
+ * and steals half of the remaining slice from other workers, when it runs out.
+ *
+ * Workers share the glhck context of the thread that created them,
+ * so they must only run work that doesn't touch OpenGL. */
+
+#if GLHCK_HAS_PTHREADS
+
+/* slice of job range owned by worker */
+typedef struct __GLHCKjobRange {
+   pthread_mutex_t lock;
+   unsigned int begin, end;
+} __GLHCKjobRange;
+
+/* argument for worker thread */
+typedef struct __GLHCKjobWorker {
+   struct __GLHCKjobs *jobs;
+   unsigned int index;
+} __GLHCKjobWorker;
+
+/* job system state of context */
+typedef struct __GLHCKjobs {
+   struct __GLHCKcontext *context;
+   struct __GLHCKjobRange *ranges; /* one for each worker + calling thread */
+   struct __GLHCKjobWorker *workers;
+   pthread_t *threads;
+   pthread_mutex_t lock, trackLock;
+   pthread_cond_t start, done;
+   __GLHCKjobFunc func;
+   void *userData;
+   unsigned int numThreads, generation, pending;
+   char quit, running;
+} __GLHCKjobs;
+
+/* \brief take one index from own range, or steal half from others */
+static int _glhckJobTake(__GLHCKjobs *jobs, unsigned int self, unsigned int *index)
+{
+   unsigned int i, victim, remaining, split, end;
+   __GLHCKjobRange *own = &jobs->ranges[self], *range;
+
+   pthread_mutex_lock(&own->lock);
+   if (own->begin < own->end) {
+      *index = own->begin++;
+      pthread_mutex_unlock(&own->lock);
+      return RETURN_TRUE;
+   }
+   pthread_mutex_unlock(&own->lock);
+
+   /* steal from the next workers in order, so thieves spread out */
+   for (i = 1; i <= jobs->numThreads; ++i) {
+      victim = (self + i) % (jobs->numThreads + 1);
+      range = &jobs->ranges[victim];
+
+      pthread_mutex_lock(&range->lock);
+      if (range->begin >= range->end) {
+         pthread_mutex_unlock(&range->lock);
+         continue;
+      }
+
+      remaining = range->end - range->begin;
+      split = range->end - (remaining + 1) / 2;
+      end = range->end;
+      range->end = split;
+      pthread_mutex_unlock(&range->lock);
+
+      /* rest of the stolen half becomes our range,
+       * locks are never nested, so thieves can't deadlock */
+      pthread_mutex_lock(&own->lock);
+      own->begin = split + 1;
+      own->end = end;
+      pthread_mutex_unlock(&own->lock);
+
+      *index = split;
+      return RETURN_TRUE;
+   }
+
+   return RETURN_FALSE;
+}
+
+/* \brief run jobs until there is nothing to take */
+static void _glhckJobWork(__GLHCKjobs *jobs, unsigned int self)
+{
+   unsigned int index;
+   while (_glhckJobTake(jobs, self, &index))
+      jobs->func(jobs->userData, index);
+}
+
+/* \brief worker thread loop */
+static void* _glhckJobThread(void *arg)
+{
+   __GLHCKjobWorker *worker = arg;
+   __GLHCKjobs *jobs = worker->jobs;
+   unsigned int generation = 0;
+
+   /* share the context, so internal state is reachable from jobs */
+   glhckContextSet(jobs->context);
+
+   pthread_mutex_lock(&jobs->lock);
+   for (;;) {
+      while (!jobs->quit && jobs->generation == generation)
+         pthread_cond_wait(&jobs->start, &jobs->lock);
+
+      if (jobs->quit) break;
+      generation = jobs->generation;
+      pthread_mutex_unlock(&jobs->lock);
+
+      _glhckJobWork(jobs, worker->index);
+
+      pthread_mutex_lock(&jobs->lock);
+      if (--jobs->pending == 0)
+         pthread_cond_signal(&jobs->done);
+   }
+   pthread_mutex_unlock(&jobs->lock);
+   return NULL;
+}
+
+/* \brief stop and free worker threads of current context */
+static void _glhckJobStop(void)
+{
+   unsigned int i;
+   __GLHCKjobs *jobs;
+
+   if (!(jobs = glhckContextGet()->jobs))
+      return;
+
+   pthread_mutex_lock(&jobs->lock);
+   jobs->quit = 1;
+   pthread_cond_broadcast(&jobs->start);
+   pthread_mutex_unlock(&jobs->lock);
+
+   for (i = 0; i != jobs->numThreads; ++i)
+      pthread_join(jobs->threads[i], NULL);
+
+   for (i = 0; i != jobs->numThreads + 1; ++i)
+      pthread_mutex_destroy(&jobs->ranges[i].lock);
+
+   pthread_cond_destroy(&jobs->start);
+   pthread_cond_destroy(&jobs->done);
+   pthread_mutex_destroy(&jobs->lock);
+   pthread_mutex_destroy(&jobs->trackLock);
+
+   _glhckFree(jobs->threads);
+   _glhckFree(jobs->workers);
+   _glhckFree(jobs->ranges);
+   _glhckFree(jobs);
+   glhckContextGet()->jobs = NULL;
+}
+
+/* \brief start worker threads for current context */
+static int _glhckJobStart(unsigned int threads)
+{
+   unsigned int i, started = 0;
+   __GLHCKjobs *jobs;
+
+   if (!(jobs = _glhckCalloc(1, sizeof(__GLHCKjobs))))
+      goto fail;
+   if (!(jobs->ranges = _glhckCalloc(threads + 1, sizeof(__GLHCKjobRange))))
+      goto fail;
+   if (!(jobs->workers = _glhckCalloc(threads, sizeof(__GLHCKjobWorker))))
+      goto fail;
+   if (!(jobs->threads = _glhckCalloc(threads, sizeof(pthread_t))))
+      goto fail;
+
+   jobs->context = glhckContextGet();
+   pthread_mutex_init(&jobs->lock, NULL);
+   pthread_mutex_init(&jobs->trackLock, NULL);
+   pthread_cond_init(&jobs->start, NULL);
+   pthread_cond_init(&jobs->done, NULL);
+   for (i = 0; i != threads + 1; ++i)
+      pthread_mutex_init(&jobs->ranges[i].lock, NULL);
+
+   /* numThreads counts only started threads, so stop works on partial start */
+   glhckContextGet()->jobs = jobs;
+   for (started = 0; started != threads; ++started) {
+      jobs->workers[started].jobs = jobs;
+      jobs->workers[started].index = started;
+      if (pthread_create(&jobs->threads[started], NULL, _glhckJobThread, &jobs->workers[started]) != 0)
+         break;
+      jobs->numThreads = started + 1;
+   }
+
+   if (started != threads) {
+      DEBUG(GLHCK_DBG_ERROR, "Failed to start job thread %u", started);
+      _glhckJobStop();
+      return RETURN_FAIL;
+   }
+
+   return RETURN_OK;
+
+fail:
+   if (jobs) {
+      IFDO(_glhckFree, jobs->threads);
+      IFDO(_glhckFree, jobs->workers);
+      IFDO(_glhckFree, jobs->ranges);
+      _glhckFree(jobs);
+   }
+   return RETURN_FAIL;
+}
+
+#endif /* GLHCK_HAS_PTHREADS */
+
+/* \brief run func for every index in [0, count) on the job threads
+ * calling thread takes part in the work, and returns when all jobs are done.
+ * runs inline, when there are no threads, or when called from a job. */
+void _glhckJobParallelFor(unsigned int count, __GLHCKjobFunc func, void *userData)
+{
+   unsigned int i;
+   CALL(2, "%u, %p, %p", count, func, userData);
+   assert(func);
+
+#if GLHCK_HAS_PTHREADS
+   __GLHCKjobs *jobs = glhckContextGet()->jobs;
+   unsigned int slice, workers;
+
+   if (jobs && !jobs->running && count > 1) {
+      jobs->running = 1;
+      jobs->func = func;
+      jobs->userData = userData;
+
+      /* even slices for every worker + calling thread */
+      workers = jobs->numThreads + 1;
+      slice = count / workers;
+      for (i = 0; i != workers; ++i) {
+         jobs->ranges[i].begin = i * slice;
+         jobs->ranges[i].end = (i + 1 == workers ? count : (i + 1) * slice);
+      }
+
+      pthread_mutex_lock(&jobs->lock);
+      jobs->pending = jobs->numThreads;
+      jobs->generation++;
+      pthread_cond_broadcast(&jobs->start);
+      pthread_mutex_unlock(&jobs->lock);
+
+      _glhckJobWork(jobs, jobs->numThreads);
+
+      pthread_mutex_lock(&jobs->lock);
+      while (jobs->pending)
+         pthread_cond_wait(&jobs->done, &jobs->lock);
+      pthread_mutex_unlock(&jobs->lock);
+
+      jobs->running = 0;
+      return;
+   }
+#endif
+
+   for (i = 0; i != count; ++i)
+      func(userData, i);
+}
+
+/* \brief lock internal state that isn't thread safe (allocation tracking)
+ * does nothing when jobs aren't running */
+void _glhckJobLock(void)
+{
+#if GLHCK_HAS_PTHREADS
+   __GLHCKjobs *jobs;
+   if (glhckContextGet() && (jobs = glhckContextGet()->jobs) && jobs->running)
+      pthread_mutex_lock(&jobs->trackLock);
+#endif
+}
+
+/* \brief unlock internal state locked with _glhckJobLock */
+void _glhckJobUnlock(void)
+{
+#if GLHCK_HAS_PTHREADS
+   __GLHCKjobs *jobs;
+   if (glhckContextGet() && (jobs = glhckContextGet()->jobs) && jobs->running)
+      pthread_mutex_unlock(&jobs->trackLock);
+#endif
+}
+
+/* \brief terminate job threads of context */
+void _glhckJobTerminate(void)
+{
+#if GLHCK_HAS_PTHREADS
+   _glhckJobStop();
+#endif
+}
+
+/***
+ * public api
+ ***/
+
+/* \brief set number of job threads for current context
+ * 0 runs all the jobs inline on the calling thread (default)
+ * the calling thread takes part in the work,
+ * so threads is usually number of cores - 1. */
+GLHCKAPI int glhckJobThreads(unsigned int threads)
+{
+   GLHCK_INITIALIZED();
+   CALL(0, "%u", threads);
+
+#if GLHCK_HAS_PTHREADS
+   if (glhckContextGet()->jobs && glhckContextGet()->jobs->numThreads == threads)
+      goto success;
+
+   _glhckJobStop();
+   if (threads && _glhckJobStart(threads) != RETURN_OK)
+      goto fail;
+
+success:
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+
+fail:
+   RET(0, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+#else
+   if (threads) DEBUG(GLHCK_DBG_ERROR, "Built without thread support, jobs are run inline");
+   RET(0, "%d", (threads?RETURN_FAIL:RETURN_OK));
+   return (threads?RETURN_FAIL:RETURN_OK);
+#endif
+}
+
+/* \brief get number of job threads for current context */
+GLHCKAPI unsigned int glhckJobGetThreads(void)
+{
+   GLHCK_INITIALIZED();
+   TRACE(1);
+#if GLHCK_HAS_PTHREADS
+   if (glhckContextGet()->jobs) {
+      RET(1, "%u", glhckContextGet()->jobs->numThreads);
+      return glhckContextGet()->jobs->numThreads;
+   }
+#endif
+   RET(1, "%u", 0);
+   return 0;
+}
+
+/* vim: set ts=8 sw=3 tw=0 :*/
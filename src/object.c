@@ -1079,6 +1079,8 @@ GLHCKAPI int glhckObjectInsertBones(glhckObject *object, glhckBone **bones, unsi
 
    object->bones = bonesCopy;
    object->numBones = (bonesCopy?memb:0);
+   _glhckSkinBoneReleaseHierarchy(object);
+   _glhckBoneTableRelease(&object->boneTable);
 
    /* reference new bones */
    for (i = 0; object->bones && i != object->numBones; ++i)
@@ -1104,9 +1106,27 @@ GLHCKAPI glhckBone** glhckObjectBones(glhckObject *object, unsigned int *memb)
 /* \brief get bone by name */
 GLHCKAPI glhckBone* glhckObjectGetBone(glhckObject *object, const char *name)
 {
-   unsigned int i;
-   for (i = 0; i != object->numBones && strcmp(glhckBoneGetName(object->bones[i]), name); ++i);
-   return (i<object->numBones?object->bones[i]:NULL);
+   int i;
+   CALL(2, "%p, %s", object, name);
+   assert(object && name);
+
+   if (!object->bones)
+      goto fail;
+
+   /* (re)build the name table lazily */
+   if ((!object->boneTable.slots || object->boneTable.revision != GLHCKW()->boneNameRevision) &&
+       _glhckBoneTableBuild(&object->boneTable, object->bones, object->numBones, _glhckBoneTableBoneName) != RETURN_OK)
+      goto fail;
+
+   if ((i = _glhckBoneTableFind(&object->boneTable, object->bones, _glhckBoneTableBoneName, name)) < 0)
+      goto fail;
+
+   RET(2, "%p", object->bones[i]);
+   return object->bones[i];
+
+fail:
+   RET(2, "%p", NULL);
+   return NULL;
 }
 
 /* \brief insert skin bones to object */
@@ -1130,25 +1150,25 @@ GLHCKAPI int glhckObjectInsertSkinBones(glhckObject *object, glhckSkinBone **ski
 
    object->skinBones = skinBonesCopy;
    object->numSkinBones = (skinBonesCopy?memb:0);
+   _glhckSkinBoneReleaseHierarchy(object);
+   _glhckBoneTableRelease(&object->skinBoneTable);
+   IFDO(_glhckFree, object->skinning.palette);
+   object->skinning.renderer = 0;
 
    /* reference new skin bones */
    if (object->skinBones) {
       for (i = 0; i != object->numSkinBones; ++i)
          glhckSkinBoneRef(object->skinBones[i]);
 
-      __GLHCKvertexType *type = GLHCKVT(object->geometry->vertexType);
-      if (!object->bind && !(object->bind = _glhckCopy(object->geometry->vertices, object->geometry->vertexCount * type->size)))
-         goto fail;
-      if (!object->zero && !(object->zero = _glhckCopy(object->geometry->vertices, object->geometry->vertexCount * type->size)))
-         goto fail;
-
-      int v;
-      for (v = 0; v < object->geometry->vertexCount; ++v)
-         memset(object->zero + type->size * v + type->offset[0], 0, type->msize[0] * type->memb[0]);
-      _glhckSkinBoneTransformObject(object, 1);
-   } else {
-      IFDO(_glhckFree, object->bind);
-      IFDO(_glhckFree, object->zero);
+      /* rest pose is snapshotted, when skinned on CPU */
+      if (object->geometry) _glhckSkinBoneTransformObject(object, 1);
+   } else if (object->bind) {
+      /* restore rest pose */
+      if (object->geometry) {
+         __GLHCKvertexType *type = GLHCKVT(object->geometry->vertexType);
+         memcpy(object->geometry->vertices, object->bind, object->geometry->vertexCount * type->size);
+      }
+      NULLDO(_glhckFree, object->bind);
    }
 
    RET(0, "%d", RETURN_OK);
@@ -1169,15 +1189,37 @@ GLHCKAPI glhckSkinBone** glhckObjectSkinBones(glhckObject *object, unsigned int
    return object->skinBones;
 }
 
+/* \brief name function for bone table of skin bones */
+static const char* _glhckObjectSkinBoneName(const void *array, unsigned int index)
+{
+   const glhckSkinBone *skinBone = ((glhckSkinBone**)array)[index];
+   return (skinBone->bone?skinBone->bone->name:NULL);
+}
+
 /* \brief get skin bone by name */
 GLHCKAPI glhckSkinBone* glhckObjectGetSkinBone(glhckObject *object, const char *name)
 {
-   unsigned int i;
-   for (i = 0; i != object->numSkinBones; ++i) {
-      if (object->skinBones[i]->bone && !strcmp(glhckBoneGetName(object->skinBones[i]->bone), name))
-         break;
-   }
-   return (i<object->numSkinBones?object->skinBones[i]:NULL);
+   int i;
+   CALL(2, "%p, %s", object, name);
+   assert(object && name);
+
+   if (!object->skinBones)
+      goto fail;
+
+   /* (re)build the name table lazily */
+   if ((!object->skinBoneTable.slots || object->skinBoneTable.revision != GLHCKW()->boneNameRevision) &&
+       _glhckBoneTableBuild(&object->skinBoneTable, object->skinBones, object->numSkinBones, _glhckObjectSkinBoneName) != RETURN_OK)
+      goto fail;
+
+   if ((i = _glhckBoneTableFind(&object->skinBoneTable, object->skinBones, _glhckObjectSkinBoneName, name)) < 0)
+      goto fail;
+
+   RET(2, "%p", object->skinBones[i]);
+   return object->skinBones[i];
+
+fail:
+   RET(2, "%p", NULL);
+   return NULL;
 }
 
 /* \brief insert animations to object */
@@ -1309,6 +1351,38 @@ fail:
    return RETURN_FAIL;
 }
 
+/* \brief insert vertices to object, merging identical vertices and generating indices for them
+ * vertices are compared with epsilon (0 for exact match), smallest index type is picked with GLHCK_IDX_AUTO */
+GLHCKAPI int glhckObjectInsertWeldedVertices(glhckObject *object, unsigned char itype, unsigned char vtype,
+      const glhckImportVertexData *vertices, int memb, float epsilon)
+{
+   unsigned int numWelded;
+   glhckImportVertexData *welded = NULL;
+   glhckImportIndexData *indices = NULL;
+   CALL(0, "%p, %u, %u, %p, %d, %f", object, itype, vtype, vertices, memb, epsilon);
+   assert(object && vertices && memb > 0);
+
+   if (_glhckGeometryWeld(vertices, memb, NULL, memb, epsilon, &welded, &numWelded, &indices) != RETURN_OK)
+      goto fail;
+
+   if (glhckObjectInsertIndices(object, itype, indices, memb) != RETURN_OK)
+      goto fail;
+
+   if (glhckObjectInsertVertices(object, vtype, welded, numWelded) != RETURN_OK)
+      goto fail;
+
+   NULLDO(_glhckFree, welded);
+   NULLDO(_glhckFree, indices);
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+
+fail:
+   IFDO(_glhckFree, welded);
+   IFDO(_glhckFree, indices);
+   RET(0, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
 /* \brief update/recalculate object's internal state */
 GLHCKAPI void glhckObjectUpdate(glhckObject *object)
 {
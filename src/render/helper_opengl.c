@@ -229,6 +229,12 @@ GLenum glhckDataTypeToGL[] = {
    GL_UNSIGNED_INT_8_8_8_8_REV, /* GLHCK_UNSIGNED_INT_8_8_8_8_REV */
    GL_UNSIGNED_INT_10_10_10_2, /* GLHCK_UNSIGNED_INT_10_10_10_2 */
    GL_UNSIGNED_INT_2_10_10_10_REV, /* GLHCK_UNSIGNED_INT_2_10_10_10_REV */
+   GL_INT_2_10_10_10_REV, /* GLHCK_INT_2_10_10_10_REV */
+#if GLHCK_USE_GLES2 || EMSCRIPTEN
+   GL_HALF_FLOAT_OES, /* GLHCK_HALF_FLOAT */
+#else
+   GL_HALF_FLOAT, /* GLHCK_HALF_FLOAT */
+#endif
 };
 
 GLenum glhckBlendingModeToGL[] = {
@@ -939,7 +945,7 @@ GLuint glhProgramAttachUniformBuffer(GLuint program, const GLchar *uboName, GLui
    GLuint ubo;
    CALL(0, "%u, %s, %u", program, uboName, location);
 
-   if ((ubo = glGetUniformBlockIndex(program, uboName))) {
+   if ((ubo = glGetUniformBlockIndex(program, uboName)) != GL_INVALID_INDEX) {
       GL_CALL(glUniformBlockBinding(program, ubo, location));
    }
 
@@ -1373,6 +1379,271 @@ void glhGeometryRender(const glhckGeometry *geometry, glhckGeometryType type)
    else glhDrawArrays(geometry, type);
 }
 
+/* \brief release meshlet range scratch */
+void glhMeshletRangesRelease(glhMeshletRanges *scratch)
+{
+   IFDO(_glhckFree, scratch->ranges);
+   IFDO(_glhckFree, scratch->counts);
+   IFDO(_glhckFree, scratch->offsets);
+   scratch->allocated = 0;
+}
+
+/* \brief make room for ranges of count meshlets */
+static int glhMeshletRangesReserve(glhMeshletRanges *scratch, unsigned int count)
+{
+   if (scratch->allocated >= count)
+      return RETURN_OK;
+
+   glhMeshletRangesRelease(scratch);
+   if (!(scratch->ranges = _glhckMalloc(count * 2 * sizeof(unsigned int))) ||
+       !(scratch->counts = _glhckMalloc(count * sizeof(GLsizei))) ||
+       !(scratch->offsets = _glhckMalloc(count * sizeof(GLvoid*)))) {
+      glhMeshletRangesRelease(scratch);
+      return RETURN_FAIL;
+   }
+
+   scratch->allocated = count;
+   return RETURN_OK;
+}
+
+/* \brief draw geometry of object, skipping meshlets that are outside the view or culled by facing
+ * cullFace is passed to _glhckGeometryCullMeshlets, geometry without meshlets is drawn whole */
+void glhGeometryRenderMeshlets(const glhckObject *object, glhckGeometryType type, int cullFace, glhMeshletRanges *scratch)
+{
+   unsigned int i, numRanges;
+   GLenum mode, dataType;
+   const glhckGeometry *geometry = object->geometry;
+   const __GLHCKindexType *itype;
+
+   /* skinned vertices move away from the meshlet bounds */
+   if (!geometry->meshlets || !geometry->indices || type != GLHCK_TRIANGLES || object->numSkinBones ||
+       glhMeshletRangesReserve(scratch, geometry->meshletCount) != RETURN_OK) {
+      glhGeometryRender(geometry, type);
+      return;
+   }
+
+   if (!(numRanges = _glhckGeometryCullMeshlets(geometry, &object->view.matrix, cullFace, scratch->ranges)))
+      return;
+
+   itype = GLHCKIT(geometry->indexType);
+   for (i = 0; i != numRanges; ++i) {
+      scratch->counts[i] = scratch->ranges[i*2+1];
+      scratch->offsets[i] = (const GLubyte*)geometry->indices + scratch->ranges[i*2] * itype->size;
+   }
+
+   mode = glhckGeometryTypeToGL[type];
+   dataType = glhckDataTypeToGL[itype->dataType];
+
+#if GLH_MULTI_DRAW
+   if (GLEW_VERSION_1_4) {
+      GL_CALL(glMultiDrawElements(mode, scratch->counts, dataType, scratch->offsets, numRanges));
+      return;
+   }
+#endif
+
+   for (i = 0; i != numRanges; ++i) {
+      GL_CALL(glDrawElements(mode, scratch->counts[i], dataType, scratch->offsets[i]));
+   }
+}
+
+/*
+ * dynamic geometry streaming
+ */
+
+/* alignment of data in stream, enough for any vertex attribute */
+#define GLH_STREAM_ALIGN 16
+
+/* \brief bind stream buffer */
+static void glhStreamBind(glhStream *stream)
+{
+   GL_CALL(glBindBuffer(glhckHwBufferTargetToGL[stream->target], stream->object));
+   GLHCKRD()->hwBuffer[stream->target] = NULL; /* glhck's buffer is no longer bound */
+   stream->bound = 1;
+}
+
+/* \brief unbind stream buffer, so client side arrays can be used again */
+void glhStreamUnbind(glhStream *stream)
+{
+   if (!stream->bound) return;
+   if (!GLHCKRD()->hwBuffer[stream->target]) {
+      GL_CALL(glBindBuffer(glhckHwBufferTargetToGL[stream->target], 0));
+   }
+   stream->bound = 0;
+}
+
+#if GLH_STREAM_PERSISTENT
+/* \brief fence the segment we are leaving, and wait for the GPU to finish with the one we enter */
+static void glhStreamEnterSegment(glhStream *stream, unsigned int segment)
+{
+   if (segment == stream->segment)
+      return;
+
+   stream->fence[stream->segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+   if (stream->fence[segment]) {
+      while (glClientWaitSync(stream->fence[segment], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+      GL_CALL(glDeleteSync(stream->fence[segment]));
+      stream->fence[segment] = NULL;
+   }
+
+   stream->segment = segment;
+}
+#endif
+
+/* \brief create stream ring buffer */
+int glhStreamInit(glhStream *stream, glhckHwBufferTarget target, GLsizeiptr size)
+{
+   CALL(0, "%p, %d, %td", stream, target, size);
+   assert(stream && size > 0);
+
+   memset(stream, 0, sizeof(glhStream));
+   stream->target = target;
+   stream->statistics.size = size;
+
+   GL_CALL(glGenBuffers(1, &stream->object));
+   if (!stream->object)
+      goto fail;
+
+   glhStreamBind(stream);
+
+#if GLH_STREAM_PERSISTENT
+   if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) {
+      const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+      GL_CALL(glBufferStorage(glhckHwBufferTargetToGL[target], size, NULL, flags));
+      stream->persistent = glMapBufferRange(glhckHwBufferTargetToGL[target], 0, size, flags);
+
+      /* storage is immutable, so start over with new buffer */
+      if (!stream->persistent) {
+         glhStreamUnbind(stream);
+         GL_CALL(glDeleteBuffers(1, &stream->object));
+         GL_CALL(glGenBuffers(1, &stream->object));
+         if (!stream->object) goto fail;
+         glhStreamBind(stream);
+      }
+   }
+
+   if (!stream->persistent)
+#endif
+   {
+      GL_CALL(glBufferData(glhckHwBufferTargetToGL[target], size, NULL, GL_STREAM_DRAW));
+   }
+
+   glhStreamUnbind(stream);
+   DEBUG(GLHCK_DBG_CRAP, "Stream(%u) of %td bytes", stream->object, size);
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+
+fail:
+   memset(stream, 0, sizeof(glhStream));
+   RET(0, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
+/* \brief release stream ring buffer */
+void glhStreamRelease(glhStream *stream)
+{
+#if GLH_STREAM_PERSISTENT
+   unsigned int i;
+#endif
+   CALL(0, "%p", stream);
+   assert(stream);
+
+   if (!stream->object)
+      return;
+
+#if GLH_STREAM_PERSISTENT
+   for (i = 0; i != GLH_STREAM_SEGMENTS; ++i) {
+      if (!stream->fence[i]) continue;
+      GL_CALL(glDeleteSync(stream->fence[i]));
+   }
+
+   if (stream->persistent) {
+      glhStreamBind(stream);
+      GL_CALL(glUnmapBuffer(glhckHwBufferTargetToGL[stream->target]));
+   }
+#endif
+
+   glhStreamUnbind(stream);
+   GL_CALL(glDeleteBuffers(1, &stream->object));
+   memset(stream, 0, sizeof(glhStream));
+}
+
+/* \brief write data to stream, data is sub-allocated from the ring buffer.
+ * returns offset of data in stream buffer, or -1 when it can't be streamed.
+ * stream buffer is left bound, so attribute pointers can be set with the offset. */
+GLintptr glhStreamData(glhStream *stream, GLsizeiptr size, const GLvoid *data)
+{
+   GLintptr offset;
+   GLsizeiptr segment;
+   GLenum target;
+   CALL(2, "%p, %td, %p", stream, size, data);
+   assert(stream && data);
+
+   if (!stream->object || size <= 0)
+      goto fail;
+
+   /* single draw may take at most one segment of the ring */
+   segment = stream->statistics.size / GLH_STREAM_SEGMENTS;
+   if (size > segment)
+      goto fail;
+
+   target = glhckHwBufferTargetToGL[stream->target];
+   offset = (stream->offset + GLH_STREAM_ALIGN - 1) & ~(GLintptr)(GLH_STREAM_ALIGN - 1);
+
+#if GLH_STREAM_PERSISTENT
+   /* fenced segments may not be straddled */
+   if (stream->persistent && offset / segment != (offset + size - 1) / segment)
+      offset = (offset / segment + 1) * segment;
+#endif
+
+   glhStreamBind(stream);
+
+   /* wrap around, orphan the old storage so we don't wait for the GPU */
+   if (offset + size > (GLsizeiptr)stream->statistics.size) {
+      offset = 0;
+      stream->statistics.wraps++;
+#if GLH_STREAM_PERSISTENT
+      if (!stream->persistent)
+#endif
+      {
+         GL_CALL(glBufferData(target, stream->statistics.size, NULL, GL_STREAM_DRAW));
+      }
+   }
+
+#if GLH_STREAM_PERSISTENT
+   if (stream->persistent) {
+      glhStreamEnterSegment(stream, offset / segment);
+      memcpy(stream->persistent + offset, data, size);
+   } else
+#endif
+   {
+#if GLH_STREAM_MAP_RANGE
+      void *ptr = NULL;
+      if (GLEW_VERSION_3_0 || GLEW_ARB_map_buffer_range) {
+         ptr = glMapBufferRange(target, offset, size,
+               GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+      }
+
+      if (ptr) {
+         memcpy(ptr, data, size);
+         GL_CALL(glUnmapBuffer(target));
+      } else
+#endif
+      {
+         GL_CALL(glBufferSubData(target, offset, size, data));
+      }
+   }
+
+   stream->offset = offset + size;
+   stream->statistics.streamed += size;
+   RET(2, "%td", offset);
+   return offset;
+
+fail:
+   RET(2, "%d", -1);
+   return -1;
+}
+
 /*
  * misc
  */
@@ -32,6 +32,10 @@
 #  define GLchar char
 #endif
 
+#ifndef GL_HALF_FLOAT_OES
+#  define GL_HALF_FLOAT_OES 0x8D61
+#endif
+
 /* check gl errors on debug build */
 #ifdef NDEBUG
 #  define GL_CALL(x) x
@@ -48,6 +52,48 @@ void GL_ERROR(unsigned int line, const char *func, const char *glfunc);
 GLenum GL_CHECK_ERROR(const char *func, const char *glfunc, GLenum error);
 #endif
 
+/* desktop GL can write the stream without synchronization,
+ * or keep it persistently mapped (GL 4.4 / ARB_buffer_storage) */
+#if !EMSCRIPTEN && !GLHCK_USE_GLES1 && !GLHCK_USE_GLES2
+#  ifdef GL_MAP_UNSYNCHRONIZED_BIT
+#     define GLH_STREAM_MAP_RANGE 1
+#  endif
+#  ifdef GL_MAP_PERSISTENT_BIT
+#     define GLH_STREAM_PERSISTENT 1
+#  endif
+#endif
+
+/* several index ranges can be drawn with one call */
+#if !EMSCRIPTEN && !GLHCK_USE_GLES1 && !GLHCK_USE_GLES2
+#  define GLH_MULTI_DRAW 1
+#endif
+
+/* persistently mapped stream is fenced in segments,
+ * so CPU only waits for the GPU on the segment it's about to overwrite */
+#define GLH_STREAM_SEGMENTS 4
+
+/* ring buffer for streaming per-frame geometry */
+typedef struct glhStream {
+   glhckRenderStreamStatistics statistics;
+#if GLH_STREAM_PERSISTENT
+   GLsync fence[GLH_STREAM_SEGMENTS];
+   GLubyte *persistent;
+   unsigned int segment;
+#endif
+   GLsizeiptr offset;
+   GLuint object;
+   glhckHwBufferTarget target;
+   char bound;
+} glhStream;
+
+/* scratch for drawing visible meshlets */
+typedef struct glhMeshletRanges {
+   unsigned int *ranges;
+   GLsizei *counts;
+   const GLvoid **offsets;
+   unsigned int allocated;
+} glhMeshletRanges;
+
 /*** mapping tables ***/
 extern GLenum glhckCullFaceTypeToGL[];
 extern GLenum glhckFaceOrientationToGL[];
@@ -122,6 +168,14 @@ _glhckShaderAttribute* glhProgramAttributeList(GLuint obj);
 _glhckShaderUniform* glhProgramUniformList(GLuint obj);
 void glhProgramUniform(GLuint obj, _glhckShaderUniform *uniform, GLsizei count, const GLvoid *value);
 void glhGeometryRender(const glhckGeometry *geometry, glhckGeometryType type);
+void glhGeometryRenderMeshlets(const glhckObject *object, glhckGeometryType type, int cullFace, glhMeshletRanges *scratch);
+void glhMeshletRangesRelease(glhMeshletRanges *scratch);
+
+/*** dynamic geometry streaming ***/
+int glhStreamInit(glhStream *stream, glhckHwBufferTarget target, GLsizeiptr size);
+void glhStreamRelease(glhStream *stream);
+GLintptr glhStreamData(glhStream *stream, GLsizeiptr size, const GLvoid *data);
+void glhStreamUnbind(glhStream *stream);
 
 /*** misc ***/
 void glhSetupDebugOutput(void);
@@ -11,6 +11,11 @@
 #define GL_DEBUG 1
 #define GLHCK_ATTRIB_COUNT GLHCK_ATTRIB_LAST
 
+#ifndef __STRING
+#  define __STRING(x) #x
+#endif
+#define GLHCK_XSTRING(x) __STRING(x)
+
 /* include shared OpenGL functions */
 #include "helper_opengl.h"
 
@@ -45,6 +50,33 @@ static const char *_glhckBaseShader =
 "  gl_Position = GlhckProjection * GlhckFVertexView;"
 "}\n"
 
+"-- GLhck.Skinning.Vertex\n"
+"const mat4 ScaleMatrix ="
+"mat4(0.5, 0.0, 0.0, 0.0,"
+"     0.0, 0.5, 0.0, 0.0,"
+"     0.0, 0.0, 0.5, 0.0,"
+"     0.5, 0.5, 0.5, 1.0);"
+""
+"vec2 vec2RotateBy(vec2 invec, float degrees, vec2 center) {"
+"  float radians = degrees * 0.017453;"
+"  float cs = cos(radians), sn = sin(radians);"
+"  vec2 tmp = invec - center;"
+"  float x = tmp.x * cs - tmp.y * sn;"
+"  float y = tmp.x * sn + tmp.y * cs;"
+"  return vec2(x, y) + center;"
+"}\n"
+""
+"void main() {"
+"  mat4 Skin = glhckSkinMatrix();"
+"  vec2 rotated = vec2RotateBy(GlhckUV0, GlhckMaterial.TextureRotation, vec2(0.5, 0.5));"
+"  GlhckFVertexWorld = GlhckModel * (Skin * vec4(GlhckVertex, 1.0));"
+"  GlhckFVertexView = GlhckView * GlhckFVertexWorld;"
+"  GlhckFNormalWorld = normalize(mat3(GlhckModel) * (mat3(Skin) * GlhckNormal));"
+"  GlhckFUV0 = GlhckMaterial.TextureOffset + (rotated * GlhckMaterial.TextureScale);"
+"  GlhckFSC0 = ScaleMatrix * GlhckLight.Projection * GlhckLight.View * GlhckFVertexWorld;"
+"  gl_Position = GlhckProjection * GlhckFVertexView;"
+"}\n"
+
 "-- GLhck.Text.Vertex\n"
 "void main() {"
 "  GlhckFUV0 = GlhckUV0 * GlhckMaterial.TextureScale;"
@@ -77,6 +109,13 @@ static const char *_glhckBaseShader =
 "void main() {"
 "  vec4 Diffuse = texture2D(GlhckTexture0, GlhckFUV0);"
 "  GlhckFragColor = GlhckMaterial.Diffuse/255.0 * Diffuse.aaaa;"
+"}\n"
+
+"-- GLhck.Text.DistanceField.Fragment\n"
+"void main() {"
+"  float Distance = texture2D(GlhckTexture0, GlhckFUV0).a;"
+"  float Width = max(0.7071 * fwidth(Distance), 0.0001);"
+"  GlhckFragColor = GlhckMaterial.Diffuse/255.0 * smoothstep(0.5 - Width, 0.5 + Width, Distance);"
 "}\n";
 
 static const glhckColorb overdrawColor = {25,25,25,255};
@@ -93,6 +132,7 @@ enum {
    GL_STATE_DRAW_WIREFRAME = 1<<7,
    GL_STATE_LIGHTING       = 1<<8,
    GL_STATE_OVERDRAW       = 1<<9,
+   GL_STATE_SKINNING       = 1<<10,
 };
 
 /* internal shaders */
@@ -101,7 +141,12 @@ enum {
    GL_SHADER_COLOR,
    GL_SHADER_BASE_LIGHTING,
    GL_SHADER_COLOR_LIGHTING,
+   GL_SHADER_BASE_SKINNING,
+   GL_SHADER_COLOR_SKINNING,
+   GL_SHADER_BASE_LIGHTING_SKINNING,
+   GL_SHADER_COLOR_LIGHTING_SKINNING,
    GL_SHADER_TEXT,
+   GL_SHADER_TEXT_DISTANCE_FIELD,
    GL_SHADER_LAST
 };
 
@@ -118,6 +163,9 @@ typedef struct __OpenGLrender {
    struct __OpenGLstate state;
    glhckShader *shader[GL_SHADER_LAST];
    glhckHwBuffer *sharedUBO;
+   glhckHwBuffer *skinUBO;
+   glhStream stream;
+   glhMeshletRanges meshletRanges;
 } __OpenGLrender;
 
 /* typecast the glhck's render pointer where we allocate our context */
@@ -215,6 +263,8 @@ static GLuint rProgramLink(GLuint vertexShader, GLuint fragmentShader)
    GL_CALL(glBindAttribLocation(obj, GLHCK_ATTRIB_NORMAL,  "GlhckNormal"));
    GL_CALL(glBindAttribLocation(obj, GLHCK_ATTRIB_COLOR,   "GlhckColor"));
    GL_CALL(glBindAttribLocation(obj, GLHCK_ATTRIB_TEXTURE, "GlhckUV0"));
+   GL_CALL(glBindAttribLocation(obj, GLHCK_ATTRIB_BONE_INDEX, "GlhckBoneIndex"));
+   GL_CALL(glBindAttribLocation(obj, GLHCK_ATTRIB_BONE_WEIGHT, "GlhckBoneWeight"));
 
    /* link the shaders to program */
    GL_CALL(glAttachShader(obj, vertexShader));
@@ -224,6 +274,9 @@ static GLuint rProgramLink(GLuint vertexShader, GLuint fragmentShader)
    /* attach glhck UBO to every shader */
    glhProgramAttachUniformBuffer(obj, "GlhckUBO", 0);
 
+   /* attach skinning UBO to shaders that skin */
+   glhProgramAttachUniformBuffer(obj, "GlhckSkinUBO", 1);
+
    /* dump the log incase of error */
    GL_CALL(glGetProgramiv(obj, GL_INFO_LOG_LENGTH, &logSize));
    if (logSize > 1) {
@@ -313,6 +366,13 @@ static void rObjectState(const glhckObject *object)
    GLPOINTER()->state.attrib[GLHCK_ATTRIB_COLOR] =
       ((object->flags & GLHCK_OBJECT_VERTEX_COLOR) && type->memb[3]);
 
+   /* skinned on GPU? */
+   GLPOINTER()->state.attrib[GLHCK_ATTRIB_BONE_INDEX] =
+      GLPOINTER()->state.attrib[GLHCK_ATTRIB_BONE_WEIGHT] =
+      (object->skinning.renderer && object->skinning.vertices);
+   GLPOINTER()->state.flags |=
+      (GLPOINTER()->state.attrib[GLHCK_ATTRIB_BONE_INDEX])?GL_STATE_SKINNING:0;
+
    /* depth? */
    GLPOINTER()->state.flags |=
       (object->flags & GLHCK_OBJECT_DEPTH)?GL_STATE_DEPTH:0;
@@ -409,18 +469,46 @@ static void rPassState(void)
    GLPOINTER()->state.attrib[GLHCK_ATTRIB_TEXTURE] = (GLPOINTER()->state.flags & GL_STATE_TEXTURE);
 }
 
-/* \brief pass interleaved vertex data to OpenGL nicely. */
-static void rGeometryPointer(const glhckGeometry *geometry)
+/* \brief pass interleaved vertex data to OpenGL nicely.
+ * vertices skinned on CPU change every frame, so they are streamed. */
+static void rGeometryPointer(const glhckObject *object)
 {
+   const glhckGeometry *geometry = object->geometry;
    __GLHCKvertexType *type = GLHCKVT(geometry->vertexType);
+   const GLubyte *vertices = geometry->vertices;
+   GLintptr offset;
+
+   if (object->bind && (offset = glhStreamData(&GLPOINTER()->stream,
+               geometry->vertexCount * type->size, geometry->vertices)) >= 0)
+      vertices = (const GLubyte*)NULL + offset;
+
    GL_CALL(glVertexAttribPointer(GLHCK_ATTRIB_VERTEX, type->memb[0],
-            glhckDataTypeToGL[type->dataType[0]], type->normalized[0], type->size, geometry->vertices + type->offset[0]));
+            glhckDataTypeToGL[type->dataType[0]], type->normalized[0], type->size, vertices + type->offset[0]));
    GL_CALL(glVertexAttribPointer(GLHCK_ATTRIB_NORMAL, type->memb[1],
-            glhckDataTypeToGL[type->dataType[1]], type->normalized[1], type->size, geometry->vertices + type->offset[1]));
+            glhckDataTypeToGL[type->dataType[1]], type->normalized[1], type->size, vertices + type->offset[1]));
    GL_CALL(glVertexAttribPointer(GLHCK_ATTRIB_TEXTURE, type->memb[2],
-            glhckDataTypeToGL[type->dataType[2]], type->normalized[2], type->size, geometry->vertices + type->offset[2]));
+            glhckDataTypeToGL[type->dataType[2]], type->normalized[2], type->size, vertices + type->offset[2]));
    GL_CALL(glVertexAttribPointer(GLHCK_ATTRIB_COLOR, type->memb[3],
-            glhckDataTypeToGL[type->dataType[3]], type->normalized[3], type->size, geometry->vertices + type->offset[3]));
+            glhckDataTypeToGL[type->dataType[3]], type->normalized[3], type->size, vertices + type->offset[3]));
+
+   /* pointers keep the stream, the rest are client side arrays */
+   glhStreamUnbind(&GLPOINTER()->stream);
+}
+
+/* \brief pass bone influences of skinned object to OpenGL */
+static void rSkinningPointer(const glhckObject *object)
+{
+   GL_CALL(glVertexAttribPointer(GLHCK_ATTRIB_BONE_INDEX, GLHCK_SKIN_INFLUENCES,
+            GL_UNSIGNED_BYTE, GL_FALSE, sizeof(__GLHCKskinVertex), &object->skinning.vertices[0].bones));
+   GL_CALL(glVertexAttribPointer(GLHCK_ATTRIB_BONE_WEIGHT, GLHCK_SKIN_INFLUENCES,
+            GL_UNSIGNED_BYTE, GL_TRUE, sizeof(__GLHCKskinVertex), &object->skinning.vertices[0].weights));
+}
+
+/* \brief get statistics of dynamic geometry streaming */
+static void rStreamStatistics(glhckRenderStreamStatistics *statistics)
+{
+   CALL(1, "%p", statistics);
+   memcpy(statistics, &GLPOINTER()->stream.statistics, sizeof(glhckRenderStreamStatistics));
 }
 
 /* \brief render frustum */
@@ -717,19 +805,32 @@ static void rObjectStart(const glhckObject *object)
    } else if (object->material && object->material->shader) {
       glhckShaderBind(object->material->shader);
    } else {
+      GLuint shader;
       if (GL_HAS_STATE(GL_STATE_TEXTURE)) {
          if (GL_HAS_STATE(GL_STATE_LIGHTING)) {
-            glhckShaderBind(GLPOINTER()->shader[GL_SHADER_BASE_LIGHTING]);
+            shader = GL_SHADER_BASE_LIGHTING;
          } else {
-            glhckShaderBind(GLPOINTER()->shader[GL_SHADER_BASE]);
+            shader = GL_SHADER_BASE;
          }
       } else {
          if (GL_HAS_STATE(GL_STATE_LIGHTING)) {
-            glhckShaderBind(GLPOINTER()->shader[GL_SHADER_COLOR_LIGHTING]);
+            shader = GL_SHADER_COLOR_LIGHTING;
          } else {
-            glhckShaderBind(GLPOINTER()->shader[GL_SHADER_COLOR]);
+            shader = GL_SHADER_COLOR;
          }
       }
+
+      /* skinning variants are in same order */
+      if (GL_HAS_STATE(GL_STATE_SKINNING))
+         shader += GL_SHADER_BASE_SKINNING - GL_SHADER_BASE;
+
+      glhckShaderBind(GLPOINTER()->shader[shader]);
+   }
+
+   /* upload skinning matrices */
+   if (GL_HAS_STATE(GL_STATE_SKINNING)) {
+      glhckHwBufferFill(GLPOINTER()->skinUBO, 0,
+            object->numSkinBones * sizeof(kmMat4), object->skinning.palette);
    }
 
    glhckColorb diffuse = {255,255,255,255};
@@ -777,14 +878,19 @@ static void rObjectStart(const glhckObject *object)
 static void rObjectEnd(const glhckObject *object)
 {
    glhckGeometryType type = object->geometry->type;
+   int cullFace = 0;
 
    /* switch to wireframe if requested */
    if (GL_HAS_STATE(GL_STATE_DRAW_WIREFRAME)) {
       type = (object->geometry->type==GLHCK_TRIANGLES ? GLHCK_LINES:GLHCK_LINE_STRIP);
    }
 
-   /* draw geometry */
-   glhGeometryRender(object->geometry, type);
+   /* draw geometry, meshlets facing to the culled side are skipped too */
+   if (GL_HAS_STATE(GL_STATE_CULL)) {
+      cullFace = (GLPOINTER()->state.frontFace == GLHCK_CCW ? 1 : -1);
+      if (GLPOINTER()->state.cullFace == GLHCK_FRONT) cullFace = -cullFace;
+   }
+   glhGeometryRenderMeshlets(object, type, cullFace, &GLPOINTER()->meshletRanges);
 
    /* draw axis-aligned bounding box, if requested */
    if (GL_HAS_STATE(GL_STATE_DRAW_AABB))
@@ -814,7 +920,8 @@ static void rObjectRender(const glhckObject *object)
    CALL(2, "%p", object);
    assert(object->geometry->vertexCount != 0 && object->geometry->vertices);
    rObjectStart(object);
-   rGeometryPointer(object->geometry);
+   rGeometryPointer(object);
+   if (GL_HAS_STATE(GL_STATE_SKINNING)) rSkinningPointer(object);
    rObjectEnd(object);
 }
 
@@ -822,6 +929,9 @@ static void rObjectRender(const glhckObject *object)
 static void rTextRender(const glhckText *text)
 {
    __GLHCKtextTexture *texture;
+   glhckShader *shader;
+   int first, count;
+   char diffuseSet = 0;
    CALL(2, "%p", text);
 
    if (!GL_HAS_STATE(GL_STATE_OVERDRAW)) {
@@ -868,36 +978,61 @@ static void rTextRender(const glhckText *text)
       GL_CALL(glDisableVertexAttribArray(GLHCK_ATTRIB_COLOR));
    }
 
+   if (GLPOINTER()->state.attrib[GLHCK_ATTRIB_BONE_INDEX]) {
+      GLPOINTER()->state.attrib[GLHCK_ATTRIB_BONE_INDEX] = 0;
+      GLPOINTER()->state.attrib[GLHCK_ATTRIB_BONE_WEIGHT] = 0;
+      GL_CALL(glDisableVertexAttribArray(GLHCK_ATTRIB_BONE_INDEX));
+      GL_CALL(glDisableVertexAttribArray(GLHCK_ATTRIB_BONE_WEIGHT));
+   }
+
    if (GL_HAS_STATE(GL_STATE_DEPTH)) {
       GL_CALL(glDisable(GL_DEPTH_TEST));
    }
 
-   if (text->shader) glhckShaderBind(text->shader);
-   else glhckShaderBind(GLPOINTER()->shader[GL_SHADER_TEXT]);
-
    glhckColorb diffuse = text->color;
    if (GL_HAS_STATE(GL_STATE_OVERDRAW)) memcpy(&diffuse, &overdrawColor, sizeof(glhckColorb));
-   glhckShaderUniform(GLHCKRD()->shader, "GlhckMaterial.Diffuse", 1,
-         &((GLfloat[]){diffuse.r, diffuse.g, diffuse.b, diffuse.a}));
 
    for (texture = text->textureCache; texture; texture = texture->next) {
       if (!texture->geometry.vertexCount)
          continue;
 
+      /* distance field pages need their own shader */
+      if (text->shader) shader = text->shader;
+      else shader = GLPOINTER()->shader[(texture->distanceField?GL_SHADER_TEXT_DISTANCE_FIELD:GL_SHADER_TEXT)];
+
+      if (shader != GLHCKRD()->shader || !diffuseSet) {
+         glhckShaderBind(shader);
+         glhckShaderUniform(GLHCKRD()->shader, "GlhckMaterial.Diffuse", 1,
+               &((GLfloat[]){diffuse.r, diffuse.g, diffuse.b, diffuse.a}));
+         diffuseSet = 1;
+      }
+
       if (GL_HAS_STATE(GL_STATE_TEXTURE)) glhckTextureBind(texture->texture);
       glhckShaderUniform(GLHCKRD()->shader, "GlhckMaterial.TextureScale", 1, &texture->texture->internalScale);
 
-      GL_CALL(glVertexAttribPointer(GLHCK_ATTRIB_VERTEX, 2, (GLHCK_TEXT_FLOAT_PRECISION?GL_FLOAT:GL_SHORT), 0,
-               (GLHCK_TEXT_FLOAT_PRECISION?sizeof(glhckVertexData2f):sizeof(glhckVertexData2s)),
-               &texture->geometry.vertexData[0].vertex));
+      /* text is rebuilt every frame, stream it
+       * quads share 16-bit indices, pages with more quads than they address are drawn in batches */
+      for (first = 0; first < texture->geometry.vertexCount; first += count) {
+         count = texture->geometry.vertexCount - first;
+         if (count > (int)text->indexQuads*4) count = text->indexQuads*4;
+         if (!count) break;
+
+         const GLubyte *vertices = (const GLubyte*)&texture->geometry.vertexData[first];
+         GLintptr offset = glhStreamData(&GLPOINTER()->stream, count * sizeof(texture->geometry.vertexData[0]), vertices);
+         if (offset >= 0) vertices = (const GLubyte*)NULL + offset;
 
-      GL_CALL(glVertexAttribPointer(GLHCK_ATTRIB_TEXTURE, 2, (GLHCK_TEXT_FLOAT_PRECISION?GL_FLOAT:GL_SHORT),
-               (GLHCK_TEXT_FLOAT_PRECISION?0:1),
-               (GLHCK_TEXT_FLOAT_PRECISION?sizeof(glhckVertexData2f):sizeof(glhckVertexData2s)),
-               &texture->geometry.vertexData[0].coord));
+         GL_CALL(glVertexAttribPointer(GLHCK_ATTRIB_VERTEX, 2, (GLHCK_TEXT_FLOAT_PRECISION?GL_FLOAT:GL_SHORT), 0,
+                  (GLHCK_TEXT_FLOAT_PRECISION?sizeof(glhckVertexData2f):sizeof(glhckVertexData2s)),
+                  vertices + (GLHCK_TEXT_FLOAT_PRECISION?offsetof(glhckVertexData2f, vertex):offsetof(glhckVertexData2s, vertex))));
 
-      GL_CALL(glDrawArrays(GLHCK_TRISTRIP?GL_TRIANGLE_STRIP:GL_TRIANGLES,
-               0, texture->geometry.vertexCount));
+         GL_CALL(glVertexAttribPointer(GLHCK_ATTRIB_TEXTURE, 2, (GLHCK_TEXT_FLOAT_PRECISION?GL_FLOAT:GL_SHORT),
+                  (GLHCK_TEXT_FLOAT_PRECISION?0:1),
+                  (GLHCK_TEXT_FLOAT_PRECISION?sizeof(glhckVertexData2f):sizeof(glhckVertexData2s)),
+                  vertices + (GLHCK_TEXT_FLOAT_PRECISION?offsetof(glhckVertexData2f, coord):offsetof(glhckVertexData2s, coord))));
+
+         glhStreamUnbind(&GLPOINTER()->stream);
+         GL_CALL(glDrawElements(GL_TRIANGLES, count/4*6, GL_UNSIGNED_SHORT, text->indices));
+      }
    }
 
    if (GLPOINTER()->state.frontFace != GLHCK_CCW) {
@@ -1016,6 +1151,21 @@ static int renderInit(void)
          "  return Color;"
          "}");
 
+   /* skinning functions
+    * include this in custom vertex shaders, to support objects skinned on GPU */
+   glswAddDirectiveToken("Skinning",
+         "in vec4 GlhckBoneIndex;"
+         "in vec4 GlhckBoneWeight;"
+         "uniform GlhckSkinUBO {"
+         "  mat4 GlhckBones[" GLHCK_XSTRING(GLHCK_MAX_HW_SKIN_BONES) "];"
+         "};"
+         "mat4 glhckSkinMatrix() {"
+         "  return GlhckBones[int(GlhckBoneIndex.x)] * GlhckBoneWeight.x +"
+         "         GlhckBones[int(GlhckBoneIndex.y)] * GlhckBoneWeight.y +"
+         "         GlhckBones[int(GlhckBoneIndex.z)] * GlhckBoneWeight.z +"
+         "         GlhckBones[int(GlhckBoneIndex.w)] * GlhckBoneWeight.w;"
+         "}");
+
    /* unpacking functions */
    glswAddDirectiveToken("Unpacking",
          "float glhckUnpack(vec4 color) {"
@@ -1077,7 +1227,12 @@ static int renderInit(void)
    GLPOINTER()->shader[GL_SHADER_COLOR] = glhckShaderNew(NULL, ".GLhck.Color.Fragment", _glhckBaseShader);
    GLPOINTER()->shader[GL_SHADER_BASE_LIGHTING] = glhckShaderNew(NULL, ".GLhck.Base.Lighting.Fragment", _glhckBaseShader);
    GLPOINTER()->shader[GL_SHADER_COLOR_LIGHTING] = glhckShaderNew(NULL, ".GLhck.Color.Lighting.Fragment", _glhckBaseShader);
+   GLPOINTER()->shader[GL_SHADER_BASE_SKINNING] = glhckShaderNew(".GLhck.Skinning.Vertex", NULL, _glhckBaseShader);
+   GLPOINTER()->shader[GL_SHADER_COLOR_SKINNING] = glhckShaderNew(".GLhck.Skinning.Vertex", ".GLhck.Color.Fragment", _glhckBaseShader);
+   GLPOINTER()->shader[GL_SHADER_BASE_LIGHTING_SKINNING] = glhckShaderNew(".GLhck.Skinning.Vertex", ".GLhck.Base.Lighting.Fragment", _glhckBaseShader);
+   GLPOINTER()->shader[GL_SHADER_COLOR_LIGHTING_SKINNING] = glhckShaderNew(".GLhck.Skinning.Vertex", ".GLhck.Color.Lighting.Fragment", _glhckBaseShader);
    GLPOINTER()->shader[GL_SHADER_TEXT] = glhckShaderNew(".GLhck.Text.Vertex", ".GLhck.Text.Fragment", _glhckBaseShader);
+   GLPOINTER()->shader[GL_SHADER_TEXT_DISTANCE_FIELD] = glhckShaderNew(".GLhck.Text.Vertex", ".GLhck.Text.DistanceField.Fragment", _glhckBaseShader);
 
    /* create UBO from shader */
    glhckHwBufferCreateUniformBufferFromShader(GLPOINTER()->sharedUBO,
@@ -1092,6 +1247,25 @@ static int renderInit(void)
    DEBUG(GLHCK_DBG_CRAP, "GLHCK UBO SIZE: %d", GLPOINTER()->sharedUBO->size);
    glhckHwBufferBindRange(GLPOINTER()->sharedUBO, 0, 0, GLPOINTER()->sharedUBO->size);
 
+   /* create skinning matrix palette
+    * std140 layout of mat4 array is tightly packed */
+   if (!(GLPOINTER()->skinUBO = glhckHwBufferNew()))
+      goto fail;
+
+   glhckHwBufferCreate(GLPOINTER()->skinUBO, GLHCK_UNIFORM_BUFFER,
+         GLHCK_MAX_HW_SKIN_BONES * sizeof(kmMat4), NULL, GLHCK_BUFFER_STREAM_DRAW);
+   glhckHwBufferBindRange(GLPOINTER()->skinUBO, 1, 0, GLHCK_MAX_HW_SKIN_BONES * sizeof(kmMat4));
+
+   /* we can skin on GPU now */
+   GLHCKRF()->skinning.maxBones = GLHCK_MAX_HW_SKIN_BONES;
+
+   /* half float and packed attributes need GL 3 */
+   GLHCKRF()->vertex.hasPackedAttributes = (GLHCKRF()->version.major >= 3);
+
+   /* ring buffer for per-frame geometry, client side arrays are used without it */
+   if (glhStreamInit(&GLPOINTER()->stream, GLHCK_ARRAY_BUFFER, GLHCK_RENDER_STREAM_SIZE) != RETURN_OK)
+      DEBUG(GLHCK_DBG_WARNING, "Failed to create stream buffer, dynamic geometry won't be streamed.");
+
    RET(0, "%d", RETURN_OK);
    return RETURN_OK;
 
@@ -1116,6 +1290,17 @@ static void renderTerminate(void)
    /* free hw buffers */
    if (GLHCKW()->hwbuffer) {
       NULLDO(glhckHwBufferFree, GLPOINTER()->sharedUBO);
+      NULLDO(glhckHwBufferFree, GLPOINTER()->skinUBO);
+   }
+
+   /* objects need to skin on CPU again, and use plain attributes */
+   GLHCKRF()->skinning.maxBones = 0;
+   GLHCKRF()->vertex.hasPackedAttributes = 0;
+
+   /* free stream buffer and meshlet scratch */
+   if (GLHCKR()->renderPointer) {
+      glhStreamRelease(&GLPOINTER()->stream);
+      glhMeshletRangesRelease(&GLPOINTER()->meshletRanges);
    }
 
    /* shutdown shader wrangler */
@@ -1201,6 +1386,7 @@ void _glhckRenderOpenGL(void)
    GLHCK_RENDER_FUNC(objectRender, rObjectRender);
    GLHCK_RENDER_FUNC(textRender, rTextRender);
    GLHCK_RENDER_FUNC(frustumRender, rFrustumRender);
+   GLHCK_RENDER_FUNC(streamStatistics, rStreamStatistics);
 
    /* screen */
    GLHCK_RENDER_FUNC(bufferGetPixels, glhBufferGetPixels);
@@ -50,6 +50,8 @@ typedef struct __OpenGLstate {
 
 typedef struct __OpenGLrender {
    struct __OpenGLstate state;
+   glhStream stream;
+   glhMeshletRanges meshletRanges;
 } __OpenGLrender;
 
 /* typecast the glhck's render pointer where we allocate our context */
@@ -260,14 +262,44 @@ static void rPassState(void)
    GLPOINTER()->state.attrib[GLHCK_ATTRIB_TEXTURE] = (GLPOINTER()->state.flags & GL_STATE_TEXTURE);
 }
 
+/* \brief fixed pipeline vertex pointers take no half float or packed attributes */
+static int rVertexTypeSupported(const __GLHCKvertexType *type)
+{
+   int i;
+   for (i = 0; i != 4; ++i) {
+      if (type->dataType[i] == GLHCK_HALF_FLOAT ||
+          type->dataType[i] == GLHCK_INT_2_10_10_10_REV ||
+          type->dataType[i] == GLHCK_UNSIGNED_INT_2_10_10_10_REV)
+         return 0;
+   }
+   return 1;
+}
+
 /* \brief pass interleaved vertex data to OpenGL nicely. */
-static void rGeometryPointer(const glhckGeometry *geometry)
+static void rGeometryPointer(const glhckObject *object)
 {
+   const glhckGeometry *geometry = object->geometry;
    __GLHCKvertexType *type = GLHCKVT(geometry->vertexType);
-   GL_CALL(glVertexPointer(type->memb[0], glhckDataTypeToGL[type->dataType[0]], type->size, geometry->vertices + type->offset[0]));
-   GL_CALL(glNormalPointer(glhckDataTypeToGL[type->dataType[1]], type->size, geometry->vertices + type->offset[1]));
-   GL_CALL(glTexCoordPointer(type->memb[2], glhckDataTypeToGL[type->dataType[2]], type->size, geometry->vertices + type->offset[2]));
-   GL_CALL(glColorPointer(type->memb[3], glhckDataTypeToGL[type->dataType[3]], type->size, geometry->vertices + type->offset[3]));
+   const GLubyte *vertices = geometry->vertices;
+   GLintptr offset;
+
+   /* vertices skinned on CPU change every frame, stream them */
+   if (object->bind && (offset = glhStreamData(&GLPOINTER()->stream,
+               geometry->vertexCount * type->size, geometry->vertices)) >= 0)
+      vertices = (const GLubyte*)NULL + offset;
+
+   GL_CALL(glVertexPointer(type->memb[0], glhckDataTypeToGL[type->dataType[0]], type->size, vertices + type->offset[0]));
+   GL_CALL(glNormalPointer(glhckDataTypeToGL[type->dataType[1]], type->size, vertices + type->offset[1]));
+   GL_CALL(glTexCoordPointer(type->memb[2], glhckDataTypeToGL[type->dataType[2]], type->size, vertices + type->offset[2]));
+   GL_CALL(glColorPointer(type->memb[3], glhckDataTypeToGL[type->dataType[3]], type->size, vertices + type->offset[3]));
+   glhStreamUnbind(&GLPOINTER()->stream);
+}
+
+/* \brief get statistics of dynamic geometry streaming */
+static void rStreamStatistics(glhckRenderStreamStatistics *statistics)
+{
+   CALL(1, "%p", statistics);
+   memcpy(statistics, &GLPOINTER()->stream.statistics, sizeof(glhckRenderStreamStatistics));
 }
 
 /* \brief render frustum */
@@ -629,14 +661,19 @@ static void rObjectStart(const glhckObject *object) {
 /* \brief end object render */
 static void rObjectEnd(const glhckObject *object) {
    glhckGeometryType type = object->geometry->type;
+   int cullFace = 0;
 
    /* switch to wireframe if requested */
    if (GL_HAS_STATE(GL_STATE_DRAW_WIREFRAME)) {
       type = (object->geometry->type==GLHCK_TRIANGLES ? GLHCK_LINES:GLHCK_LINE_STRIP);
    }
 
-   /* render geometry */
-   glhGeometryRender(object->geometry, type);
+   /* render geometry, meshlets facing to the culled side are skipped too */
+   if (GL_HAS_STATE(GL_STATE_CULL)) {
+      cullFace = (GLPOINTER()->state.frontFace == GLHCK_CCW ? 1 : -1);
+      if (GLPOINTER()->state.cullFace == GLHCK_FRONT) cullFace = -cullFace;
+   }
+   glhGeometryRenderMeshlets(object, type, cullFace, &GLPOINTER()->meshletRanges);
 
    /* render axis-aligned bounding box, if requested */
    if (GL_HAS_STATE(GL_STATE_DRAW_AABB))
@@ -659,8 +696,15 @@ static void rObjectRender(const glhckObject *object)
 {
    CALL(2, "%p", object);
    assert(object->geometry->vertexCount && object->geometry->vertices);
+
+   if (!rVertexTypeSupported(GLHCKVT(object->geometry->vertexType))) {
+      DEBUG(GLHCK_DBG_WARNING, "Vertex type %u of object %p can't be drawn with fixed pipeline",
+            object->geometry->vertexType, object);
+      return;
+   }
+
    rObjectStart(object);
-   rGeometryPointer(object->geometry);
+   rGeometryPointer(object);
    rObjectEnd(object);
 }
 
@@ -668,6 +712,7 @@ static void rObjectRender(const glhckObject *object)
 static void rTextRender(const glhckText *text)
 {
    __GLHCKtextTexture *texture;
+   int first, count;
    CALL(2, "%p", text);
 
    /* set states */
@@ -747,15 +792,39 @@ static void rTextRender(const glhckText *text)
 
       if (GL_HAS_STATE(GL_STATE_TEXTURE)) glhckTextureBind(texture->texture);
       GL_CALL(glLoadIdentity());
-      GL_CALL(glScalef(texture->texture->internalScale.x, texture->texture->internalScale.y, 1.0f));
-      GL_CALL(glVertexPointer(2, (GLHCK_TEXT_FLOAT_PRECISION?GL_FLOAT:GL_SHORT),
-            (GLHCK_TEXT_FLOAT_PRECISION?sizeof(glhckVertexData2f):sizeof(glhckVertexData2s)),
-            &texture->geometry.vertexData[0].vertex));
-      GL_CALL(glTexCoordPointer(2, (GLHCK_TEXT_FLOAT_PRECISION?GL_FLOAT:GL_SHORT),
-            (GLHCK_TEXT_FLOAT_PRECISION?sizeof(glhckVertexData2f):sizeof(glhckVertexData2s)),
-            &texture->geometry.vertexData[0].coord));
-      GL_CALL(glDrawArrays(GLHCK_TRISTRIP?GL_TRIANGLE_STRIP:GL_TRIANGLES,
-               0, texture->geometry.vertexCount));
+      GL_CALL(glScalef((GLfloat)texture->texture->internalScale.x/text->textureRange,
+               (GLfloat)texture->texture->internalScale.y/text->textureRange, 1.0f));
+
+      /* no shaders, cut distance field glyphs at outline */
+      if (texture->distanceField) {
+         GL_CALL(glEnable(GL_ALPHA_TEST));
+         GL_CALL(glAlphaFunc(GL_GEQUAL, 0.5f));
+      }
+
+      /* text is rebuilt every frame, stream it
+       * quads share 16-bit indices, pages with more quads than they address are drawn in batches */
+      for (first = 0; first < texture->geometry.vertexCount; first += count) {
+         count = texture->geometry.vertexCount - first;
+         if (count > (int)text->indexQuads*4) count = text->indexQuads*4;
+         if (!count) break;
+
+         const GLubyte *vertices = (const GLubyte*)&texture->geometry.vertexData[first];
+         GLintptr offset = glhStreamData(&GLPOINTER()->stream, count * sizeof(texture->geometry.vertexData[0]), vertices);
+         if (offset >= 0) vertices = (const GLubyte*)NULL + offset;
+
+         GL_CALL(glVertexPointer(2, (GLHCK_TEXT_FLOAT_PRECISION?GL_FLOAT:GL_SHORT),
+               (GLHCK_TEXT_FLOAT_PRECISION?sizeof(glhckVertexData2f):sizeof(glhckVertexData2s)),
+               vertices + (GLHCK_TEXT_FLOAT_PRECISION?offsetof(glhckVertexData2f, vertex):offsetof(glhckVertexData2s, vertex))));
+         GL_CALL(glTexCoordPointer(2, (GLHCK_TEXT_FLOAT_PRECISION?GL_FLOAT:GL_SHORT),
+               (GLHCK_TEXT_FLOAT_PRECISION?sizeof(glhckVertexData2f):sizeof(glhckVertexData2s)),
+               vertices + (GLHCK_TEXT_FLOAT_PRECISION?offsetof(glhckVertexData2f, coord):offsetof(glhckVertexData2s, coord))));
+         glhStreamUnbind(&GLPOINTER()->stream);
+         GL_CALL(glDrawElements(GL_TRIANGLES, count/4*6, GL_UNSIGNED_SHORT, text->indices));
+      }
+
+      if (texture->distanceField) {
+         GL_CALL(glDisable(GL_ALPHA_TEST));
+      }
    }
 
    if (GLPOINTER()->state.frontFace != GLHCK_CCW) {
@@ -792,6 +861,13 @@ static int renderInit(void)
    /* save from some headache */
    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT,1));
 
+   /* ring buffer for per-frame geometry, needs vertex buffer objects */
+#if !GLHCK_USE_GLES1
+   if (GLEW_VERSION_1_5 &&
+         glhStreamInit(&GLPOINTER()->stream, GLHCK_ARRAY_BUFFER, GLHCK_RENDER_STREAM_SIZE) != RETURN_OK)
+      DEBUG(GLHCK_DBG_WARNING, "Failed to create stream buffer, dynamic geometry won't be streamed.");
+#endif
+
    RET(0, "%d", RETURN_OK);
    return RETURN_OK;
 
@@ -805,6 +881,12 @@ static void renderTerminate(void)
 {
    TRACE(0);
 
+   /* free stream buffer and meshlet scratch */
+   if (GLHCKR()->renderPointer) {
+      glhStreamRelease(&GLPOINTER()->stream);
+      glhMeshletRangesRelease(&GLPOINTER()->meshletRanges);
+   }
+
    /* free our render structure */
    IFDO(_glhckFree, GLHCKR()->renderPointer);
 
@@ -888,6 +970,7 @@ void _glhckRenderOpenGLFixedPipeline(void)
    GLHCK_RENDER_FUNC(objectRender, rObjectRender);
    GLHCK_RENDER_FUNC(textRender, rTextRender);
    GLHCK_RENDER_FUNC(frustumRender, rFrustumRender);
+   GLHCK_RENDER_FUNC(streamStatistics, rStreamStatistics);
 
    /* screen */
    GLHCK_RENDER_FUNC(bufferGetPixels, glhBufferGetPixels);
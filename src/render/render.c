@@ -42,6 +42,7 @@ void _glhckRenderCheckApi(void)
    GLHCK_API_CHECK(objectRender);
    GLHCK_API_CHECK(textRender);
    GLHCK_API_CHECK(frustumRender);
+   GLHCK_API_CHECK(streamStatistics);
    GLHCK_API_CHECK(bufferGetPixels);
    GLHCK_API_CHECK(textureGenerate);
    GLHCK_API_CHECK(textureDelete);
@@ -121,6 +122,17 @@ GLHCKAPI const glhckRenderFeatures* glhckRenderGetFeatures(void)
    return &GLHCKR()->features;
 }
 
+/* \brief get statistics of dynamic geometry streaming */
+GLHCKAPI void glhckRenderGetStreamStatistics(glhckRenderStreamStatistics *statistics)
+{
+   GLHCK_INITIALIZED();
+   CALL(1, "%p", statistics);
+   assert(statistics);
+   memset(statistics, 0, sizeof(glhckRenderStreamStatistics));
+   if (!_glhckRenderInitialized()) return;
+   GLHCKRA()->streamStatistics(statistics);
+}
+
 /* \brief resize render viewport internally */
 GLHCKAPI void glhckRenderResize(int width, int height)
 {
@@ -6,6 +6,9 @@
 #define GLHCK_RENDER_TERMINATE(x)   GLHCKR()->name  = NULL
 #define GLHCK_RENDER_FUNC(x,y)      GLHCKRA()->x    = y
 
+/* size of the ring buffer used for streaming per-frame geometry */
+#define GLHCK_RENDER_STREAM_SIZE (4 * 1048576) /* 4 MiB */
+
 /* renderers */
 void _glhckRenderOpenGLFixedPipeline(void);
 void _glhckRenderOpenGL(void);
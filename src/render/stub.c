@@ -6,11 +6,71 @@
 #define RENDER_NAME "NULL Renderer"
 #include "helper_stub.h"
 
+/* stream is laid out the same as in OpenGL renderers */
+#define STUB_STREAM_SEGMENTS 4
+#define STUB_STREAM_ALIGN 16
+
+/* stub renderer context, dynamic geometry streaming is tracked in bytes */
+typedef struct __STUBrender {
+   glhckRenderStreamStatistics stream;
+   size_t offset;
+} __STUBrender;
+
+/* typecast the glhck's render pointer where we allocate our context */
+#define STUBPOINTER() ((__STUBrender*)GLHCKR()->renderPointer)
+
+/* \brief sub-allocate bytes from stream ring buffer */
+static void rStreamData(size_t size)
+{
+   __STUBrender *stub = STUBPOINTER();
+   size_t offset = (stub->offset + STUB_STREAM_ALIGN - 1) & ~(size_t)(STUB_STREAM_ALIGN - 1);
+   CALL(2, "%zu", size);
+
+   /* too big to stream, would be drawn from client memory */
+   if (!size || size > stub->stream.size / STUB_STREAM_SEGMENTS)
+      return;
+
+   if (offset + size > stub->stream.size) {
+      offset = 0;
+      stub->stream.wraps++;
+   }
+
+   stub->offset = offset + size;
+   stub->stream.streamed += size;
+}
+
+/* \brief get statistics of dynamic geometry streaming */
+static void rStreamStatistics(glhckRenderStreamStatistics *statistics)
+{
+   CALL(1, "%p", statistics);
+   memcpy(statistics, &STUBPOINTER()->stream, sizeof(glhckRenderStreamStatistics));
+}
+
+/* \brief render single 3d object, vertices skinned on CPU are streamed */
+static void rObjectRender(const glhckObject *object)
+{
+   stubObjectRender(object);
+   if (object->bind && object->geometry)
+      rStreamData(object->geometry->vertexCount * GLHCKVT(object->geometry->vertexType)->size);
+}
+
+/* \brief render text, text geometry is streamed */
+static void rTextRender(const glhckText *text)
+{
+   __GLHCKtextTexture *texture;
+   stubTextRender(text);
+   for (texture = text->textureCache; texture; texture = texture->next)
+      rStreamData(texture->geometry.vertexCount * sizeof(texture->geometry.vertexData[0]));
+}
+
 /* \brief terminate renderer */
 static void renderTerminate(void)
 {
    TRACE(0);
 
+   /* free our render structure */
+   IFDO(_glhckFree, GLHCKR()->renderPointer);
+
    /* this tells library that we are no longer alive. */
    GLHCK_RENDER_TERMINATE(RENDER_NAME);
 }
@@ -28,6 +88,12 @@ void _glhckRenderStub(void)
    features->texture.maxRenderbufferSize = INT_MAX;
    features->texture.hasNativeNpotSupport = 1;
 
+   /* init render's context */
+   if (!(GLHCKR()->renderPointer = _glhckCalloc(1, sizeof(__STUBrender))))
+      return;
+
+   STUBPOINTER()->stream.size = GLHCK_RENDER_STREAM_SIZE;
+
    /* register stub api functions */
 
    GLHCK_RENDER_FUNC(textureGenerate, stubGenerate);
@@ -74,9 +140,10 @@ void _glhckRenderStub(void)
    GLHCK_RENDER_FUNC(setView, stubSetView);
    GLHCK_RENDER_FUNC(clearColor, stubClearColor);
    GLHCK_RENDER_FUNC(clear, stubClear);
-   GLHCK_RENDER_FUNC(objectRender, stubObjectRender);
-   GLHCK_RENDER_FUNC(textRender, stubTextRender);
+   GLHCK_RENDER_FUNC(objectRender, rObjectRender);
+   GLHCK_RENDER_FUNC(textRender, rTextRender);
    GLHCK_RENDER_FUNC(frustumRender, stubFrustumRender);
+   GLHCK_RENDER_FUNC(streamStatistics, rStreamStatistics);
    GLHCK_RENDER_FUNC(bufferGetPixels, stubBufferGetPixels);
    GLHCK_RENDER_FUNC(time, stubTime);
    GLHCK_RENDER_FUNC(viewport, stubViewport);
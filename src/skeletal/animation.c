@@ -1,8 +1,255 @@
 #include "../internal.h"
+#include <math.h> /* for fabs, sqrt, acos */
 
 /* tracing channel for this file */
 #define GLHCK_CHANNEL GLHCK_CHANNEL_ANIMATION
 
+/* quantization limits */
+#define GLHCK_PACKED_ROTATION   32767.0f
+#define GLHCK_SQRT2             1.41421356f
+#define GLHCK_SQRT1_2           0.70710678f
+
+/* \brief quantize value in range to packed key value */
+static unsigned short _glhckAnimationQuantize(float value, float min, float range)
+{
+   if (range <= 0.0f) return 0;
+   return (unsigned short)((value - min) / range * GLHCK_PACKED_MAX + 0.5f);
+}
+
+/* \brief dequantize packed key value */
+static float _glhckAnimationDequantize(unsigned short value, float min, float range)
+{
+   return min + (value / GLHCK_PACKED_MAX) * range;
+}
+
+/* \brief pack quaternion using smallest three components
+ * the dropped component index is stored to highest bits of two first values */
+static void _glhckAnimationPackQuaternion(const kmQuaternion *quaternion, unsigned short *out)
+{
+   float c[4], len, sign;
+   unsigned int i, n, largest;
+
+   c[0] = quaternion->x; c[1] = quaternion->y;
+   c[2] = quaternion->z; c[3] = quaternion->w;
+   len = sqrtf(c[0]*c[0] + c[1]*c[1] + c[2]*c[2] + c[3]*c[3]);
+   if (len <= 0.0f) len = 1.0f, c[3] = 1.0f;
+
+   for (i = 1, largest = 0; i != 4; ++i)
+      if (fabsf(c[i]) > fabsf(c[largest])) largest = i;
+
+   /* q and -q are same rotation, make the dropped component positive */
+   sign = (c[largest] < 0.0f ? -1.0f : 1.0f) / len;
+   for (i = 0, n = 0; i != 4; ++i) {
+      if (i == largest) continue;
+      out[n++] = (unsigned short)(((c[i] * sign * GLHCK_SQRT2) * 0.5f + 0.5f) * GLHCK_PACKED_ROTATION + 0.5f);
+   }
+
+   out[0] |= (largest & 1) << 15;
+   out[1] |= (largest >> 1) << 15;
+}
+
+/* \brief unpack smallest three quaternion */
+static void _glhckAnimationUnpackQuaternion(const unsigned short *in, kmQuaternion *quaternion)
+{
+   float c[4], sum = 0.0f;
+   unsigned int i, n, largest;
+
+   largest = (in[0] >> 15) | ((in[1] >> 15) << 1);
+   for (i = 0, n = 0; i != 4; ++i) {
+      if (i == largest) continue;
+      c[i] = ((in[n++] & 0x7fff) / GLHCK_PACKED_ROTATION * 2.0f - 1.0f) * GLHCK_SQRT1_2;
+      sum += c[i] * c[i];
+   }
+
+   c[largest] = (sum < 1.0f ? sqrtf(1.0f - sum) : 0.0f);
+   quaternion->x = c[0]; quaternion->y = c[1];
+   quaternion->z = c[2]; quaternion->w = c[3];
+}
+
+/* \brief interpolation factor of key between two keys */
+static float _glhckAnimationKeyFactor(float time, float first, float last)
+{
+   return (last > first ? (time - first) / (last - first) : 0.0f);
+}
+
+/* \brief reduce vector keys that can be interpolated within error
+ * returns number of kept keys, and their indices in kept array */
+static unsigned int _glhckAnimationReduceVectorKeys(const glhckAnimationVectorKey *keys, unsigned int memb, float error, unsigned int *kept)
+{
+   unsigned int a, b, k, count = 0;
+   const glhckAnimationVectorKey *ka, *kb;
+   float f;
+
+   if (!memb) return 0;
+   kept[count++] = 0;
+
+   /* extend segment from last kept key, until some key can't be interpolated */
+   for (a = 0, b = 2; b < memb; ++b) {
+      ka = &keys[a], kb = &keys[b];
+      for (k = a + 1; k != b; ++k) {
+         f = _glhckAnimationKeyFactor(keys[k].time, ka->time, kb->time);
+         if (fabsf(ka->vector.x + (kb->vector.x - ka->vector.x) * f - keys[k].vector.x) > error ||
+             fabsf(ka->vector.y + (kb->vector.y - ka->vector.y) * f - keys[k].vector.y) > error ||
+             fabsf(ka->vector.z + (kb->vector.z - ka->vector.z) * f - keys[k].vector.z) > error)
+            break;
+      }
+
+      if (k == b) continue;
+      kept[count++] = a = b - 1;
+   }
+
+   if (memb > 1) kept[count++] = memb - 1;
+   return count;
+}
+
+/* \brief reduce quaternion keys that can be interpolated within angle error
+ * returns number of kept keys, and their indices in kept array */
+static unsigned int _glhckAnimationReduceQuaternionKeys(const glhckAnimationQuaternionKey *keys, unsigned int memb, float error, unsigned int *kept)
+{
+   unsigned int a, b, k, count = 0;
+   const glhckAnimationQuaternionKey *ka, *kb;
+   kmQuaternion q;
+   float dot;
+
+   if (!memb) return 0;
+   kept[count++] = 0;
+
+   for (a = 0, b = 2; b < memb; ++b) {
+      ka = &keys[a], kb = &keys[b];
+      for (k = a + 1; k != b; ++k) {
+         kmQuaternionSlerp(&q, &ka->quaternion, &kb->quaternion,
+               _glhckAnimationKeyFactor(keys[k].time, ka->time, kb->time));
+         dot = fabsf(q.x * keys[k].quaternion.x + q.y * keys[k].quaternion.y +
+                     q.z * keys[k].quaternion.z + q.w * keys[k].quaternion.w);
+         if (2.0f * acosf(dot < 1.0f ? dot : 1.0f) > error)
+            break;
+      }
+
+      if (k == b) continue;
+      kept[count++] = a = b - 1;
+   }
+
+   if (memb > 1) kept[count++] = memb - 1;
+   return count;
+}
+
+/* \brief free packed channel */
+static void _glhckAnimationPackedChannelFree(__GLHCKanimationPackedChannel *channel)
+{
+   IFDO(_glhckFree, channel->keys);
+   memset(channel, 0, sizeof(__GLHCKanimationPackedChannel));
+}
+
+/* \brief allocate packed keys for channel and quantize the key times */
+static int _glhckAnimationPackedChannelTimes(__GLHCKanimationPackedChannel *channel,
+      const void *keys, size_t stride, const unsigned int *kept, unsigned int count)
+{
+   unsigned int i;
+   float time;
+   assert(channel && keys && kept && count);
+
+   if (!(channel->keys = _glhckMalloc(count * sizeof(__GLHCKanimationPackedKey))))
+      return RETURN_FAIL;
+
+   /* keys are sorted by time, time is the last member of key */
+   channel->minTime = *(const float*)((const char*)keys + kept[0] * stride + stride - sizeof(float));
+   channel->timeRange = *(const float*)((const char*)keys + kept[count-1] * stride + stride - sizeof(float)) - channel->minTime;
+   channel->numKeys = count;
+
+   for (i = 0; i != count; ++i) {
+      time = *(const float*)((const char*)keys + kept[i] * stride + stride - sizeof(float));
+      channel->keys[i].time = _glhckAnimationQuantize(time, channel->minTime, channel->timeRange);
+   }
+
+   return RETURN_OK;
+}
+
+/* \brief pack vector keys to channel */
+static int _glhckAnimationPackVectorKeys(__GLHCKanimationPackedChannel *channel,
+      const glhckAnimationVectorKey *keys, unsigned int memb, float error)
+{
+   unsigned int i, count, *kept = NULL;
+   kmVec3 max;
+   assert(channel && keys && memb);
+
+   if (!(kept = _glhckMalloc(memb * sizeof(unsigned int))))
+      goto fail;
+
+   count = _glhckAnimationReduceVectorKeys(keys, memb, error, kept);
+   if (_glhckAnimationPackedChannelTimes(channel, keys, sizeof(glhckAnimationVectorKey), kept, count) != RETURN_OK)
+      goto fail;
+
+   /* range of the channel */
+   channel->min = max = keys[kept[0]].vector;
+   for (i = 1; i != count; ++i) {
+      glhckMinV3(&channel->min, &keys[kept[i]].vector);
+      glhckMaxV3(&max, &keys[kept[i]].vector);
+   }
+   kmVec3Subtract(&channel->range, &max, &channel->min);
+
+   for (i = 0; i != count; ++i) {
+      channel->keys[i].value[0] = _glhckAnimationQuantize(keys[kept[i]].vector.x, channel->min.x, channel->range.x);
+      channel->keys[i].value[1] = _glhckAnimationQuantize(keys[kept[i]].vector.y, channel->min.y, channel->range.y);
+      channel->keys[i].value[2] = _glhckAnimationQuantize(keys[kept[i]].vector.z, channel->min.z, channel->range.z);
+   }
+
+   _glhckFree(kept);
+   return RETURN_OK;
+
+fail:
+   IFDO(_glhckFree, kept);
+   _glhckAnimationPackedChannelFree(channel);
+   return RETURN_FAIL;
+}
+
+/* \brief pack quaternion keys to channel */
+static int _glhckAnimationPackQuaternionKeys(__GLHCKanimationPackedChannel *channel,
+      const glhckAnimationQuaternionKey *keys, unsigned int memb, float error)
+{
+   unsigned int i, count, *kept = NULL;
+   assert(channel && keys && memb);
+
+   if (!(kept = _glhckMalloc(memb * sizeof(unsigned int))))
+      goto fail;
+
+   count = _glhckAnimationReduceQuaternionKeys(keys, memb, error, kept);
+   if (_glhckAnimationPackedChannelTimes(channel, keys, sizeof(glhckAnimationQuaternionKey), kept, count) != RETURN_OK)
+      goto fail;
+
+   for (i = 0; i != count; ++i)
+      _glhckAnimationPackQuaternion(&keys[kept[i]].quaternion, channel->keys[i].value);
+
+   _glhckFree(kept);
+   return RETURN_OK;
+
+fail:
+   IFDO(_glhckFree, kept);
+   _glhckAnimationPackedChannelFree(channel);
+   return RETURN_FAIL;
+}
+
+/* \brief decode vector key from packed channel */
+void _glhckAnimationPackedVectorKey(const __GLHCKanimationPackedChannel *channel, unsigned int index, glhckAnimationVectorKey *out)
+{
+   const __GLHCKanimationPackedKey *key;
+   assert(channel && out && index < channel->numKeys);
+   key = &channel->keys[index];
+   out->time = _glhckAnimationDequantize(key->time, channel->minTime, channel->timeRange);
+   out->vector.x = _glhckAnimationDequantize(key->value[0], channel->min.x, channel->range.x);
+   out->vector.y = _glhckAnimationDequantize(key->value[1], channel->min.y, channel->range.y);
+   out->vector.z = _glhckAnimationDequantize(key->value[2], channel->min.z, channel->range.z);
+}
+
+/* \brief decode quaternion key from packed channel */
+void _glhckAnimationPackedQuaternionKey(const __GLHCKanimationPackedChannel *channel, unsigned int index, glhckAnimationQuaternionKey *out)
+{
+   const __GLHCKanimationPackedKey *key;
+   assert(channel && out && index < channel->numKeys);
+   key = &channel->keys[index];
+   out->time = _glhckAnimationDequantize(key->time, channel->minTime, channel->timeRange);
+   _glhckAnimationUnpackQuaternion(key->value, &out->quaternion);
+}
+
 /* \brief allocate new key animation node object */
 GLHCKAPI glhckAnimationNode* glhckAnimationNodeNew(void)
 {
@@ -56,6 +303,7 @@ GLHCKAPI unsigned int glhckAnimationNodeFree(glhckAnimationNode *object)
    glhckAnimationNodeInsertTranslations(object, NULL, 0);
    glhckAnimationNodeInsertRotations(object, NULL, 0);
    glhckAnimationNodeInsertScalings(object, NULL, 0);
+   IFDO(_glhckFree, object->packed);
 
    /* remove from world */
    _glhckWorldRemove(animationNode, object, glhckAnimationNode*);
@@ -80,6 +328,8 @@ GLHCKAPI void glhckAnimationNodeBoneName(glhckAnimationNode *object, const char
 
    IFDO(_glhckFree, object->boneName);
    object->boneName = nameCopy;
+   object->revision++;
+   GLHCKW()->animationRevision++;
 }
 
 /* \brief return bone index from animation node */
@@ -103,7 +353,10 @@ GLHCKAPI int glhckAnimationNodeInsertTranslations(glhckAnimationNode *object, co
       goto fail;
 
    IFDO(_glhckFree, object->translations);
+   if (object->packed) _glhckAnimationPackedChannelFree(&object->packed->translations);
    object->translations = keysCopy;
+   object->revision++;
+   GLHCKW()->animationRevision++;
    object->numTranslations = (keysCopy?memb:0);
    return RETURN_OK;
 
@@ -132,7 +385,10 @@ GLHCKAPI int glhckAnimationNodeInsertScalings(glhckAnimationNode *object, const
       goto fail;
 
    IFDO(_glhckFree, object->scalings);
+   if (object->packed) _glhckAnimationPackedChannelFree(&object->packed->scalings);
    object->scalings = keysCopy;
+   object->revision++;
+   GLHCKW()->animationRevision++;
    object->numScalings = (keysCopy?memb:0);
    return RETURN_OK;
 
@@ -161,7 +417,10 @@ GLHCKAPI int glhckAnimationNodeInsertRotations(glhckAnimationNode *object, const
       goto fail;
 
    IFDO(_glhckFree, object->rotations);
+   if (object->packed) _glhckAnimationPackedChannelFree(&object->packed->rotations);
    object->rotations = keysCopy;
+   object->revision++;
+   GLHCKW()->animationRevision++;
    object->numRotations = (keysCopy?memb:0);
    return RETURN_OK;
 
@@ -178,6 +437,135 @@ GLHCKAPI const glhckAnimationQuaternionKey* glhckAnimationNodeRotations(glhckAni
    return object->rotations;
 }
 
+/* \brief compress keys of animation node
+ * keys that can be interpolated from their neighbours within the error are dropped,
+ * rest are quantized. vectorError is the maximum error of translation and scaling,
+ * rotationError is the maximum angle error in radians.
+ *
+ * NOTE: The full precision keys are released,
+ * so key getters return NULL for compressed node. */
+GLHCKAPI int glhckAnimationNodeCompress(glhckAnimationNode *object, float vectorError, float rotationError)
+{
+   __GLHCKanimationPacked *packed = NULL;
+   CALL(0, "%p, %f, %f", object, vectorError, rotationError);
+   assert(object);
+
+   if (!(packed = object->packed) && !(packed = _glhckCalloc(1, sizeof(__GLHCKanimationPacked))))
+      goto fail;
+
+   if (object->translations && _glhckAnimationPackVectorKeys(&packed->translations,
+            object->translations, object->numTranslations, vectorError) != RETURN_OK)
+      goto fail;
+   if (object->scalings && _glhckAnimationPackVectorKeys(&packed->scalings,
+            object->scalings, object->numScalings, vectorError) != RETURN_OK)
+      goto fail;
+   if (object->rotations && _glhckAnimationPackQuaternionKeys(&packed->rotations,
+            object->rotations, object->numRotations, rotationError) != RETURN_OK)
+      goto fail;
+
+   /* packed keys replace the full precision keys */
+   IFDO(_glhckFree, object->translations);
+   IFDO(_glhckFree, object->scalings);
+   IFDO(_glhckFree, object->rotations);
+   object->numTranslations = object->numScalings = object->numRotations = 0;
+   object->packed = packed;
+   object->revision++;
+   GLHCKW()->animationRevision++;
+
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+
+fail:
+   if (packed && packed != object->packed) {
+      _glhckAnimationPackedChannelFree(&packed->translations);
+      _glhckAnimationPackedChannelFree(&packed->scalings);
+      _glhckAnimationPackedChannelFree(&packed->rotations);
+      _glhckFree(packed);
+   }
+   RET(0, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
+/* \brief release cached poses of animation */
+static void _glhckAnimationReleasePoses(glhckAnimation *object)
+{
+   unsigned int i;
+   for (i = 0; i != GLHCK_ANIMATION_POSE_CACHE; ++i)
+      IFDO(_glhckFree, object->poses[i].matrices);
+   memset(object->poses, 0, sizeof(object->poses));
+}
+
+/* \brief get revision of animation, cached poses are released when it changes
+ * nodes may be shared by many animations, so their changes are found from sum of node revisions,
+ * and only when some animation node changed since last check */
+unsigned int _glhckAnimationRevision(glhckAnimation *object)
+{
+   unsigned int i, sum = 0;
+   assert(object);
+
+   if (object->worldRevision == GLHCKW()->animationRevision)
+      return object->revision;
+
+   for (i = 0; i != object->numNodes; ++i)
+      sum += object->nodes[i]->revision;
+
+   if (sum != object->nodeRevision) {
+      _glhckAnimationReleasePoses(object);
+      object->nodeRevision = sum;
+      object->revision++;
+   }
+
+   object->worldRevision = GLHCKW()->animationRevision;
+   return object->revision;
+}
+
+/* \brief get cached pose of animation at time
+ * returns local transformation for each node, or NULL if pose is not cached */
+kmMat4* _glhckAnimationGetPose(glhckAnimation *object, float time)
+{
+   unsigned int i;
+   __GLHCKanimationPose *pose;
+   assert(object);
+
+   /* poses are released, if nodes changed */
+   _glhckAnimationRevision(object);
+
+   for (i = 0; i != GLHCK_ANIMATION_POSE_CACHE; ++i) {
+      pose = &object->poses[i];
+      if (!pose->matrices || pose->time != time)
+         continue;
+
+      pose->lastUse = ++object->poseTick;
+      return pose->matrices;
+   }
+
+   return NULL;
+}
+
+/* \brief allocate pose for animation at time, replacing least recently used pose
+ * caller fills the returned local transformation for each node */
+kmMat4* _glhckAnimationNewPose(glhckAnimation *object, float time)
+{
+   unsigned int i;
+   __GLHCKanimationPose *pose;
+   assert(object);
+
+   if (!object->numNodes)
+      return NULL;
+
+   for (i = 1, pose = &object->poses[0]; i != GLHCK_ANIMATION_POSE_CACHE; ++i) {
+      if (object->poses[i].lastUse < pose->lastUse)
+         pose = &object->poses[i];
+   }
+
+   if (!pose->matrices && !(pose->matrices = _glhckMalloc(object->numNodes * sizeof(kmMat4))))
+      return NULL;
+
+   pose->time = time;
+   pose->lastUse = ++object->poseTick;
+   return pose->matrices;
+}
+
 /* \brief allocate new key animation object */
 GLHCKAPI glhckAnimation* glhckAnimationNew(void)
 {
@@ -232,6 +620,7 @@ GLHCKAPI unsigned int glhckAnimationFree(glhckAnimation *object)
 
    /* free nodes */
    glhckAnimationInsertNodes(object, NULL, 0);
+   _glhckAnimationReleasePoses(object);
 
    /* remove from world */
    _glhckWorldRemove(animation, object, glhckAnimation*);
@@ -272,6 +661,11 @@ GLHCKAPI void glhckAnimationDuration(glhckAnimation *object, float duration)
 {
    CALL(2, "%p, %f", object, duration);
    assert(object);
+
+   /* cached poses wrap around the duration */
+   if (object->duration != duration)
+      _glhckAnimationReleasePoses(object);
+
    object->duration = duration;
 }
 
@@ -322,6 +716,9 @@ GLHCKAPI int glhckAnimationInsertNodes(glhckAnimation *object, glhckAnimationNod
 
    object->nodes = nodesCopy;
    object->numNodes = (nodesCopy?memb:0);
+   _glhckAnimationReleasePoses(object);
+   object->revision++;
+   GLHCKW()->animationRevision++;
 
    /* reference new nodes */
    if (object->nodes) {
@@ -335,6 +732,26 @@ fail:
    return RETURN_FAIL;
 }
 
+/* \brief compress keys of all animation nodes */
+GLHCKAPI int glhckAnimationCompress(glhckAnimation *object, float vectorError, float rotationError)
+{
+   unsigned int i;
+   CALL(0, "%p, %f, %f", object, vectorError, rotationError);
+   assert(object);
+
+   for (i = 0; i != object->numNodes; ++i) {
+      if (glhckAnimationNodeCompress(object->nodes[i], vectorError, rotationError) != RETURN_OK)
+         goto fail;
+   }
+
+   RET(0, "%d", RETURN_OK);
+   return RETURN_OK;
+
+fail:
+   RET(0, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
 /* \brief return animation's nodes */
 GLHCKAPI glhckAnimationNode** glhckAnimationNodes(glhckAnimation *object, unsigned int *memb)
 {
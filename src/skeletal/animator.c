@@ -1,5 +1,6 @@
 #include "../internal.h"
 #include <float.h>  /* for float */
+#include <stdlib.h> /* for qsort */
 
 /* tracing channel for this file */
 #define GLHCK_CHANNEL GLHCK_CHANNEL_ANIMATOR
@@ -7,13 +8,25 @@
 /* TODO: Eventually do interpolation using splines for even smoother animation
  * We can also safe some keyframes in glhckm format by doing this. */
 
+/* \brief interpolation factor of time beetwen two key times
+ * wraps around the animation, when next key is before current key */
+static float _glhckAnimatorInterpolation(float time, float duration, float current, float next)
+{
+   float span, interp;
+   if (time <= current) return 0.0f;
+   if (next <= current) next += duration;
+   if ((span = next - current) <= 0.0f) return 0.0f;
+   interp = (time - current) / span;
+   return (interp < 1.0f ? interp : 1.0f);
+}
+
 /* \brief interpolate beetwen two vector keys */
 static void _glhckAnimatorInterpolateVectorKeys(kmVec3 *out, float time, float duration,
       const glhckAnimationVectorKey *current, const glhckAnimationVectorKey *next)
 {
    float interp;
    assert(out);
-   interp = (time < next->time ? time/next->time : time/(duration+next->time));
+   interp = _glhckAnimatorInterpolation(time, duration, current->time, next->time);
    out->x = current->vector.x + (next->vector.x - current->vector.x) * interp;
    out->y = current->vector.y + (next->vector.y - current->vector.y) * interp;
    out->z = current->vector.z + (next->vector.z - current->vector.z) * interp;
@@ -25,25 +38,208 @@ static void _glhckAnimatorInterpolateQuaternionKeys(kmQuaternion *out, float tim
 {
    float interp;
    assert(out);
-   interp = (time < next->time ? time/next->time : time/(duration+next->time));
+   interp = _glhckAnimatorInterpolation(time, duration, current->time, next->time);
    kmQuaternionSlerp(out, &current->quaternion, &next->quaternion, interp);
 }
 
+/* how many keys to step linearly from cursor, before doing binary search */
+#define GLHCK_ANIMATOR_CURSOR_STEPS 4
+
+/* \brief key time accessors for different key arrays */
+typedef float (*_glhckAnimatorKeyTimeFunc)(const void *keys, unsigned int index);
+
+static float _glhckAnimatorVectorKeyTime(const void *keys, unsigned int index)
+{
+   return ((const glhckAnimationVectorKey*)keys)[index].time;
+}
+
+static float _glhckAnimatorQuaternionKeyTime(const void *keys, unsigned int index)
+{
+   return ((const glhckAnimationQuaternionKey*)keys)[index].time;
+}
+
+static float _glhckAnimatorPackedKeyTime(const void *keys, unsigned int index)
+{
+   return ((const __GLHCKanimationPackedKey*)keys)[index].time;
+}
+
+/* \brief find frame for time, starting from cached cursor.
+ * returns the frame which starts the key segment containing time
+ * (the first frame, if time is before it)
+ *
+ * Forward playback is O(1) amortized as the cursor moves only few frames,
+ * seeking and reverse playback fall back to binary search. */
+static unsigned int _glhckAnimatorFindFrame(const void *keys, _glhckAnimatorKeyTimeFunc keyTime,
+      unsigned int memb, float time, unsigned int cursor)
+{
+   unsigned int i, low, high, mid;
+   assert(keys && keyTime && memb);
+
+   /* cursor is valid, if previous key is before time */
+   if (cursor >= memb) cursor = 0;
+   if (cursor == 0 || keyTime(keys, cursor-1) < time) {
+      for (i = 0; i != GLHCK_ANIMATOR_CURSOR_STEPS; ++i, ++cursor) {
+         if (cursor >= memb-1 || !(time > keyTime(keys, cursor)))
+            goto found;
+      }
+      low = cursor, high = memb-1;
+   } else {
+      low = 0, high = cursor;
+   }
+
+   /* binary search the rest */
+   while (low < high) {
+      mid = low + (high - low) / 2;
+      if (time > keyTime(keys, mid)) low = mid + 1;
+      else high = mid;
+   }
+   cursor = low;
+
+found:
+   /* step back to start of the segment */
+   if (cursor > 0 && keyTime(keys, cursor) > time) --cursor;
+   return cursor;
+}
+
+/* \brief sample vector keys at time */
+static void _glhckAnimatorSampleVectorKeys(kmVec3 *out, const glhckAnimationVectorKey *keys,
+      unsigned int memb, float time, float duration, unsigned int *cursor)
+{
+   unsigned int frame;
+   frame = _glhckAnimatorFindFrame(keys, _glhckAnimatorVectorKeyTime, memb, time, *cursor);
+   _glhckAnimatorInterpolateVectorKeys(out, time, duration, &keys[frame], &keys[(frame+1)%memb]);
+   *cursor = frame;
+}
+
+/* \brief sample quaternion keys at time */
+static void _glhckAnimatorSampleQuaternionKeys(kmQuaternion *out, const glhckAnimationQuaternionKey *keys,
+      unsigned int memb, float time, float duration, unsigned int *cursor)
+{
+   unsigned int frame;
+   frame = _glhckAnimatorFindFrame(keys, _glhckAnimatorQuaternionKeyTime, memb, time, *cursor);
+   _glhckAnimatorInterpolateQuaternionKeys(out, time, duration, &keys[frame], &keys[(frame+1)%memb]);
+   *cursor = frame;
+}
+
+/* \brief find frame from packed channel, time is searched in quantized domain */
+static unsigned int _glhckAnimatorFindPackedFrame(const __GLHCKanimationPackedChannel *channel, float time, unsigned int cursor)
+{
+   float packedTime = 0.0f;
+   if (channel->timeRange > 0.0f) packedTime = (time - channel->minTime) / channel->timeRange * GLHCK_PACKED_MAX;
+   return _glhckAnimatorFindFrame(channel->keys, _glhckAnimatorPackedKeyTime, channel->numKeys, packedTime, cursor);
+}
+
+/* \brief sample packed vector channel at time */
+static void _glhckAnimatorSamplePackedVectorKeys(kmVec3 *out, const __GLHCKanimationPackedChannel *channel,
+      float time, float duration, unsigned int *cursor)
+{
+   glhckAnimationVectorKey current, next;
+   unsigned int frame;
+   frame = _glhckAnimatorFindPackedFrame(channel, time, *cursor);
+   _glhckAnimationPackedVectorKey(channel, frame, &current);
+   _glhckAnimationPackedVectorKey(channel, (frame+1)%channel->numKeys, &next);
+   _glhckAnimatorInterpolateVectorKeys(out, time, duration, &current, &next);
+   *cursor = frame;
+}
+
+/* \brief sample packed quaternion channel at time */
+static void _glhckAnimatorSamplePackedQuaternionKeys(kmQuaternion *out, const __GLHCKanimationPackedChannel *channel,
+      float time, float duration, unsigned int *cursor)
+{
+   glhckAnimationQuaternionKey current, next;
+   unsigned int frame;
+   frame = _glhckAnimatorFindPackedFrame(channel, time, *cursor);
+   _glhckAnimationPackedQuaternionKey(channel, frame, &current);
+   _glhckAnimationPackedQuaternionKey(channel, (frame+1)%channel->numKeys, &next);
+   _glhckAnimatorInterpolateQuaternionKeys(out, time, duration, &current, &next);
+   *cursor = frame;
+}
+
 /* \brief lookup bone from animator */
 static glhckBone* _glhckAnimatorLookupBone(glhckAnimator *object, const char *name)
+{
+   int i;
+   unsigned int u;
+
+   if (!name) return NULL;
+
+   /* linear search, if the table could not be built */
+   if (!object->boneTable.slots) {
+      for (u = 0; u != object->numBones && strcmp(object->bones[u]->name, name); ++u);
+      return (u<object->numBones?object->bones[u]:NULL);
+   }
+
+   i = _glhckBoneTableFind(&object->boneTable, object->bones, _glhckBoneTableBoneName, name);
+   return (i >= 0?object->bones[i]:NULL);
+}
+
+/* \brief release cached node -> bone mappings */
+static void _glhckAnimatorReleaseBindings(glhckAnimator *object)
 {
    unsigned int i;
-   for (i = 0; i != object->numBones && strcmp(object->bones[i]->name, name); ++i);
-   return (i<object->numBones?object->bones[i]:NULL);
+   for (i = 0; i != GLHCK_ANIMATOR_BINDING_CACHE; ++i) {
+      IFDO(glhckAnimationFree, object->bindings[i].animation);
+      IFDO(_glhckFree, object->bindings[i].bones);
+   }
+   memset(object->bindings, 0, sizeof(object->bindings));
+   object->nextBinding = 0;
+}
+
+/* \brief get node -> bone mapping for animation
+ * mappings are cached, so switching between animations doesn't need name lookups.
+ * mappings point to bones of this animator, so they are cached here rather than shared between skeletons */
+static glhckBone** _glhckAnimatorBinding(glhckAnimator *object, glhckAnimation *animation)
+{
+   unsigned int i, revision;
+   __GLHCKanimatorBinding *binding;
+
+   /* name table is stale */
+   if (object->boneTable.revision != GLHCKW()->boneNameRevision &&
+       _glhckBoneTableBuild(&object->boneTable, object->bones, object->numBones, _glhckBoneTableBoneName) != RETURN_OK)
+      return NULL;
+
+   revision = _glhckAnimationRevision(animation);
+   for (i = 0; i != GLHCK_ANIMATOR_BINDING_CACHE; ++i) {
+      binding = &object->bindings[i];
+      if (binding->animation == animation &&
+          binding->boneNameRevision == GLHCKW()->boneNameRevision &&
+          binding->animationRevision == revision)
+         return binding->bones;
+   }
+
+   /* replace the oldest binding */
+   binding = &object->bindings[object->nextBinding];
+   object->nextBinding = (object->nextBinding + 1) % GLHCK_ANIMATOR_BINDING_CACHE;
+   IFDO(glhckAnimationFree, binding->animation);
+   IFDO(_glhckFree, binding->bones);
+
+   if (!animation->numNodes || !(binding->bones = _glhckMalloc(animation->numNodes * sizeof(glhckBone*))))
+      return NULL;
+
+   for (i = 0; i != animation->numNodes; ++i)
+      binding->bones[i] = _glhckAnimatorLookupBone(object, animation->nodes[i]->boneName);
+
+   binding->animation = glhckAnimationRef(animation);
+   binding->boneNameRevision = GLHCKW()->boneNameRevision;
+   binding->animationRevision = revision;
+   return binding->bones;
 }
 
 /* \brief resetup animation after bone/animation change */
 static void _glhckAnimatorSetupAnimation(glhckAnimator *object)
 {
    unsigned int i;
-   if (!object->bones || !object->animation) return;
-   for (i = 0; i != object->animation->numNodes; ++i)
-      object->previousNodes[i].bone = _glhckAnimatorLookupBone(object, object->animation->nodes[i]->boneName);
+   glhckBone **bones;
+   if (!object->bones || !object->animation || !object->previousNodes) return;
+
+   if ((bones = _glhckAnimatorBinding(object, object->animation))) {
+      for (i = 0; i != object->animation->numNodes; ++i)
+         object->previousNodes[i].bone = bones[i];
+   } else {
+      for (i = 0; i != object->animation->numNodes; ++i)
+         object->previousNodes[i].bone = _glhckAnimatorLookupBone(object, object->animation->nodes[i]->boneName);
+   }
+
    object->lastTime = FLT_MAX;
 }
 
@@ -60,6 +256,10 @@ GLHCKAPI glhckAnimator* glhckAnimatorNew(void)
    /* increase reference */
    object->refCounter++;
 
+   /* stagger lod updates of animators across ticks */
+   object->updateInterval = 1;
+   object->updatePhase = GLHCKW()->animatorPhase++;
+
    /* insert to world */
    _glhckWorldInsert(animator, object, glhckAnimator*);
 
@@ -157,6 +357,11 @@ GLHCKAPI int glhckAnimatorInsertBones(glhckAnimator *object, glhckBone **bones,
    object->bones = bonesCopy;
    object->numBones = (bonesCopy?memb:0);
 
+   /* mappings of old bones are invalid */
+   _glhckAnimatorReleaseBindings(object);
+   _glhckBoneTableRelease(&object->boneTable);
+   if (object->bones) _glhckBoneTableBuild(&object->boneTable, object->bones, object->numBones, _glhckBoneTableBoneName);
+
    /* reference new bones */
    if (object->bones) {
       for (i = 0; i != object->numBones; ++i)
@@ -183,11 +388,68 @@ GLHCKAPI glhckBone** glhckAnimatorBones(glhckAnimator *object, unsigned int *mem
    return object->bones;
 }
 
-/* \brief transform object with the animation */
-GLHCKAPI void glhckAnimatorTransform(glhckAnimator *object, glhckObject *gobject)
+/* \brief pick update interval from distance of object to active camera */
+static void _glhckAnimatorUpdateLod(glhckAnimator *object, glhckObject *gobject)
 {
-   CALL(2, "%p, %p", object, gobject);
-   assert(object && gobject);
+   glhckCamera *camera;
+   const kmMat4 *matrix;
+   kmVec3 center, eye;
+   float distance, interp;
+
+   if (object->lodMaxInterval <= 1 || !(camera = GLHCKRD()->camera)) {
+      object->updateInterval = 1;
+      return;
+   }
+
+   kmVec3Add(&center, &gobject->view.aabb.min, &gobject->view.aabb.max);
+   kmVec3Scale(&center, &center, 0.5f);
+
+   /* camera's translation is local to its parent, world position is in its matrix */
+   matrix = &camera->object->view.matrix;
+   kmVec3Fill(&eye, matrix->mat[12], matrix->mat[13], matrix->mat[14]);
+   kmVec3Subtract(&center, &center, &eye);
+   distance = kmVec3Length(&center);
+
+   if (distance <= object->lodNear) {
+      object->updateInterval = 1;
+   } else if (distance >= object->lodFar) {
+      object->updateInterval = object->lodMaxInterval;
+   } else {
+      interp = (distance - object->lodNear) / (object->lodFar - object->lodNear);
+      object->updateInterval = 1 + (unsigned int)(interp * (object->lodMaxInterval - 1) + 0.5f);
+   }
+}
+
+/* \brief set update rate lod of animator
+ * animator is updated every tick within near distance from the active camera,
+ * and every maxInterval:th tick beyond far distance, linearly in between.
+ * updates of animators are staggered, so they spread across ticks.
+ * maxInterval of 0 or 1 disables the lod (default) */
+GLHCKAPI void glhckAnimatorLod(glhckAnimator *object, float nearDistance, float farDistance, unsigned int maxInterval)
+{
+   CALL(2, "%p, %f, %f, %u", object, nearDistance, farDistance, maxInterval);
+   assert(object && nearDistance <= farDistance);
+   object->lodNear = nearDistance;
+   object->lodFar = farDistance;
+   object->lodMaxInterval = maxInterval;
+   if (maxInterval <= 1) object->updateInterval = 1;
+}
+
+/* \brief get current update interval of animator */
+GLHCKAPI unsigned int glhckAnimatorGetUpdateInterval(glhckAnimator *object)
+{
+   CALL(2, "%p", object);
+   assert(object);
+   RET(2, "%u", object->updateInterval);
+   return object->updateInterval;
+}
+
+/* \brief transform object with the animation
+ * camera's matrix must be up to date, so this can run on job threads */
+static void _glhckAnimatorTransform(glhckAnimator *object, glhckObject *gobject)
+{
+   /* update interval for next ticks */
+   _glhckAnimatorUpdateLod(object, gobject);
 
    /* we don't have to anything! */
    if (gobject->transformedGeometryTime == object->lastTime)
@@ -201,18 +463,97 @@ GLHCKAPI void glhckAnimatorTransform(glhckAnimator *object, glhckObject *gobject
    object->dirty = 0;
 }
 
+/* \brief transform object with the animation */
+GLHCKAPI void glhckAnimatorTransform(glhckAnimator *object, glhckObject *gobject)
+{
+   CALL(2, "%p, %p", object, gobject);
+   assert(object && gobject);
+
+   if (GLHCKRD()->camera) glhckObjectGetMatrix(GLHCKRD()->camera->object);
+   _glhckAnimatorTransform(object, gobject);
+}
+
+/* \brief set time step of animator
+ * time is quantized to the steps, so animators playing the same animation
+ * in same step evaluate the pose only once and share it.
+ * NOTE: only the local pose of nodes is shared, each object still builds its own palette,
+ *       since objects have their own bones and geometry.
+ * 0 disables quantization and pose sharing (default) */
+GLHCKAPI void glhckAnimatorTimeStep(glhckAnimator *object, float step)
+{
+   CALL(2, "%p, %f", object, step);
+   assert(object);
+   object->timeStep = (step > 0.0f ? step : 0.0f);
+}
+
+/* \brief get time step of animator */
+GLHCKAPI float glhckAnimatorGetTimeStep(glhckAnimator *object)
+{
+   CALL(2, "%p", object);
+   assert(object);
+   RET(2, "%f", object->timeStep);
+   return object->timeStep;
+}
+
+/* \brief evaluate local transformation of animation node at time */
+static void _glhckAnimatorEvaluateNode(glhckAnimationNode *node, _glhckAnimatorState *lastNode,
+      float time, float duration, kmMat4 *matrix)
+{
+   kmVec3 currentTranslation, currentScaling;
+   kmQuaternion currentRotation;
+   kmMat4 tmp;
+
+   /* reset */
+   memset(&currentTranslation, 0, sizeof(kmVec3));
+   kmVec3Fill(&currentScaling, 1.0f, 1.0f, 1.0f);
+   kmQuaternionIdentity(&currentRotation);
+
+   /* translate using translation keys */
+   if (node->translations) {
+      _glhckAnimatorSampleVectorKeys(&currentTranslation, node->translations,
+            node->numTranslations, time, duration, &lastNode->translationFrame);
+   } else if (node->packed && node->packed->translations.keys) {
+      _glhckAnimatorSamplePackedVectorKeys(&currentTranslation, &node->packed->translations,
+            time, duration, &lastNode->translationFrame);
+   }
+
+   /* scale using scaling keys */
+   if (node->scalings) {
+      _glhckAnimatorSampleVectorKeys(&currentScaling, node->scalings,
+            node->numScalings, time, duration, &lastNode->scalingFrame);
+   } else if (node->packed && node->packed->scalings.keys) {
+      _glhckAnimatorSamplePackedVectorKeys(&currentScaling, &node->packed->scalings,
+            time, duration, &lastNode->scalingFrame);
+   }
+
+   /* rotate using rotation keys */
+   if (node->rotations) {
+      _glhckAnimatorSampleQuaternionKeys(&currentRotation, node->rotations,
+            node->numRotations, time, duration, &lastNode->rotationFrame);
+   } else if (node->packed && node->packed->rotations.keys) {
+      _glhckAnimatorSamplePackedQuaternionKeys(&currentRotation, &node->packed->rotations,
+            time, duration, &lastNode->rotationFrame);
+   }
+
+   /* build transformation matrix */
+   kmMat4Identity(matrix);
+   kmMat4Scaling(&tmp, currentScaling.x, currentScaling.y, currentScaling.z);
+   kmMat4Multiply(matrix, &tmp, matrix);
+   kmMat4RotationQuaternion(&tmp, &currentRotation);
+   kmMat4Multiply(matrix, &tmp, matrix);
+   kmMat4Translation(&tmp, currentTranslation.x, currentTranslation.y, currentTranslation.z);
+   kmMat4Multiply(matrix, &tmp, matrix);
+}
+
 /* \brief update the skeletal animation to next tick */
 GLHCKAPI void glhckAnimatorUpdate(glhckAnimator *object, float playTime)
 {
    _glhckAnimatorState *lastNode;
    glhckBone *bone;
    glhckAnimation *animation;
-   glhckAnimationNode *node;
-   kmVec3 currentTranslation, currentScaling;
-   kmQuaternion currentRotation;
-   kmMat4 matrix, tmp;
+   kmMat4 *pose = NULL;
    float duration, time;
-   unsigned int n, frame, nextFrame;
+   unsigned int n;
    CALL(2, "%p", object);
    assert(object);
 
@@ -221,73 +562,163 @@ GLHCKAPI void glhckAnimatorUpdate(glhckAnimator *object, float playTime)
    if (!object->animation) return;
    if (!object->bones) return;
 
+   /* skip ticks on lod, but always do the first update */
+   object->updateTick++;
+   if (object->updateInterval > 1 && object->lastTime != FLT_MAX &&
+       (object->updateTick + object->updatePhase) % object->updateInterval != 0)
+      return;
+
    animation = object->animation;
    duration = animation->duration;
    if (duration <= 0.0)  return;
 
    time = fmod(playTime, duration);
+   if (object->timeStep > 0.0f) time = floorf(time / object->timeStep) * object->timeStep;
    if (time == object->lastTime) return;
 
+   if (object->timeStep > 0.0f) {
+      /* pose was already evaluated by other animator */
+      if ((pose = _glhckAnimationGetPose(animation, time))) {
+         for (n = 0; n != animation->numNodes; ++n) {
+            if ((bone = object->previousNodes[n].bone))
+               bone->transformationMatrix = pose[n];
+         }
+         goto done;
+      }
+
+      /* evaluate every node to the shared pose, other animators may have different bones */
+      if ((pose = _glhckAnimationNewPose(animation, time))) {
+         for (n = 0; n != animation->numNodes; ++n) {
+            lastNode = &object->previousNodes[n];
+            _glhckAnimatorEvaluateNode(animation->nodes[n], lastNode, time, duration, &pose[n]);
+            if ((bone = lastNode->bone)) bone->transformationMatrix = pose[n];
+         }
+         goto done;
+      }
+   }
+
    for (n = 0; n != animation->numNodes; ++n) {
-      node = animation->nodes[n];
       lastNode = &object->previousNodes[n];
 
       /* we don't have bone for this */
       if (!(bone = lastNode->bone))
          continue;
 
-      /* reset */
-      memset(&currentTranslation, 0, sizeof(kmVec3));
-      kmVec3Fill(&currentScaling, 1.0f, 1.0f, 1.0f);
-      kmQuaternionIdentity(&currentRotation);
-
-      /* translate using translation keys */
-      if (node->translations) {
-         frame = (time >= object->lastTime?lastNode->translationFrame:0);
-         for (; frame < node->numTranslations-1 && time > node->translations[frame].time; ++frame);
+      _glhckAnimatorEvaluateNode(animation->nodes[n], lastNode, time, duration, &bone->transformationMatrix);
+   }
 
-         nextFrame = (frame+1)%node->numTranslations;
-         _glhckAnimatorInterpolateVectorKeys(&currentTranslation, time, duration,
-               &node->translations[frame], &node->translations[nextFrame]);
-         lastNode->translationFrame = frame;
-      }
+done:
+   /* store last time and mark dirty */
+   object->lastTime = time;
+   object->dirty = 1;
+}
 
-      /* scale using scaling keys */
-      if (node->scalings) {
-         frame = (time >= object->lastTime?lastNode->scalingFrame:0);
-         for (; frame < node->numScalings-1 && time > node->scalings[frame].time; ++frame);
+/* arguments for batched animator jobs */
+typedef struct __GLHCKanimatorJobs {
+   glhckAnimator **objects;
+   glhckObject **gobjects;
+   const float *playTimes;
+   unsigned int *order; /* animator indices grouped by shared animation */
+   unsigned int *groups; /* start of each group in order */
+} __GLHCKanimatorJobs;
+
+/* sort key for grouping animators */
+typedef struct __GLHCKanimatorSortKey {
+   const glhckAnimation *animation; /* NULL, if poses are not shared */
+   unsigned int index;
+} __GLHCKanimatorSortKey;
+
+/* \brief compare animator sort keys */
+static int _glhckAnimatorSortKeyCmp(const void *a, const void *b)
+{
+   const __GLHCKanimatorSortKey *ka = a, *kb = b;
+   if (ka->animation != kb->animation) return (ka->animation < kb->animation ? -1 : 1);
+   return (ka->index < kb->index ? -1 : (ka->index > kb->index));
+}
 
-         nextFrame = (frame+1)%node->numScalings;
-         _glhckAnimatorInterpolateVectorKeys(&currentScaling, time, duration,
-               &node->scalings[frame], &node->scalings[nextFrame]);
-         lastNode->scalingFrame = frame;
-      }
+/* \brief update group of animators */
+static void _glhckAnimatorUpdateJob(void *userData, unsigned int group)
+{
+   unsigned int i;
+   __GLHCKanimatorJobs *jobs = userData;
+   for (i = jobs->groups[group]; i != jobs->groups[group+1]; ++i)
+      glhckAnimatorUpdate(jobs->objects[jobs->order[i]], jobs->playTimes[jobs->order[i]]);
+}
 
-      /* rotate using rotation keys */
-      if (node->rotations) {
-         frame = (time >= object->lastTime?lastNode->rotationFrame:0);
-         for (; frame < node->numRotations-1 && time > node->rotations[frame].time; ++frame);
+/* \brief transform object with animator */
+static void _glhckAnimatorTransformJob(void *userData, unsigned int index)
+{
+   __GLHCKanimatorJobs *jobs = userData;
+   _glhckAnimatorTransform(jobs->objects[index], jobs->gobjects[index]);
+}
 
-         nextFrame = (frame+1)%node->numRotations;
-         _glhckAnimatorInterpolateQuaternionKeys(&currentRotation, time, duration,
-               &node->rotations[frame], &node->rotations[nextFrame]);
-         lastNode->rotationFrame = frame;
-      }
+/* \brief update many animators, on job threads if there are any
+ * animators sharing poses of same animation are updated on same job,
+ * others are updated independently. animators must not share bones. */
+GLHCKAPI void glhckAnimatorUpdateMany(glhckAnimator **objects, const float *playTimes, unsigned int memb)
+{
+   __GLHCKanimatorJobs jobs;
+   __GLHCKanimatorSortKey *keys = NULL;
+   unsigned int i, numGroups;
+   CALL(2, "%p, %p, %u", objects, playTimes, memb);
+   assert(objects && playTimes);
+
+   memset(&jobs, 0, sizeof(__GLHCKanimatorJobs));
+   if (glhckJobGetThreads() == 0 || memb < 2)
+      goto serial;
+
+   if (!(keys = _glhckMalloc(memb * sizeof(__GLHCKanimatorSortKey))))
+      goto serial;
+   if (!(jobs.order = _glhckMalloc(memb * sizeof(unsigned int))))
+      goto serial;
+   if (!(jobs.groups = _glhckMalloc((memb + 1) * sizeof(unsigned int))))
+      goto serial;
+
+   for (i = 0; i != memb; ++i) {
+      keys[i].animation = (objects[i]->timeStep > 0.0f ? objects[i]->animation : NULL);
+      keys[i].index = i;
+   }
+   qsort(keys, memb, sizeof(__GLHCKanimatorSortKey), _glhckAnimatorSortKeyCmp);
 
-      /* build transformation matrix */
-      kmMat4Identity(&matrix);
-      kmMat4Scaling(&tmp, currentScaling.x, currentScaling.y, currentScaling.z);
-      kmMat4Multiply(&matrix, &tmp, &matrix);
-      kmMat4RotationQuaternion(&tmp, &currentRotation);
-      kmMat4Multiply(&matrix, &tmp, &matrix);
-      kmMat4Translation(&tmp, currentTranslation.x, currentTranslation.y, currentTranslation.z);
-      kmMat4Multiply(&matrix, &tmp, &matrix);
-      bone->transformationMatrix = matrix;
+   for (i = 0, numGroups = 0; i != memb; ++i) {
+      jobs.order[i] = keys[i].index;
+      if (i == 0 || !keys[i].animation || keys[i].animation != keys[i-1].animation)
+         jobs.groups[numGroups++] = i;
    }
+   jobs.groups[numGroups] = memb;
+
+   jobs.objects = objects;
+   jobs.playTimes = playTimes;
+   _glhckJobParallelFor(numGroups, _glhckAnimatorUpdateJob, &jobs);
+
+   _glhckFree(keys);
+   _glhckFree(jobs.order);
+   _glhckFree(jobs.groups);
+   return;
+
+serial:
+   IFDO(_glhckFree, keys);
+   IFDO(_glhckFree, jobs.order);
+   IFDO(_glhckFree, jobs.groups);
+   for (i = 0; i != memb; ++i)
+      glhckAnimatorUpdate(objects[i], playTimes[i]);
+}
 
-   /* store last time and mark dirty */
-   object->lastTime = time;
-   object->dirty = 1;
+/* \brief transform many objects with their animators, on job threads if there are any
+ * objects must be separate hierarchies, and not share bones. */
+GLHCKAPI void glhckAnimatorTransformMany(glhckAnimator **objects, glhckObject **gobjects, unsigned int memb)
+{
+   __GLHCKanimatorJobs jobs;
+   CALL(2, "%p, %p, %u", objects, gobjects, memb);
+   assert(objects && gobjects);
+
+   /* camera's matrix is updated here once, jobs only read it */
+   if (GLHCKRD()->camera) glhckObjectGetMatrix(GLHCKRD()->camera->object);
+
+   memset(&jobs, 0, sizeof(__GLHCKanimatorJobs));
+   jobs.objects = objects;
+   jobs.gobjects = gobjects;
+   _glhckJobParallelFor(memb, _glhckAnimatorTransformJob, &jobs);
 }
 
 /* vim: set ts=8 sw=3 tw=0 :*/
@@ -3,6 +3,84 @@
 /* tracing channel for this file */
 #define GLHCK_CHANNEL GLHCK_CHANNEL_BONE
 
+/* \brief hash bone name (FNV-1a) */
+static unsigned int _glhckBoneNameHash(const char *name)
+{
+   unsigned int hash = 2166136261u;
+   for (; *name; ++name) hash = (hash ^ (unsigned char)*name) * 16777619u;
+   return hash;
+}
+
+/* \brief name function for bone table of glhckBone array */
+const char* _glhckBoneTableBoneName(const void *array, unsigned int index)
+{
+   return ((glhckBone**)array)[index]->name;
+}
+
+/* \brief build bone name hash table for array */
+int _glhckBoneTableBuild(__GLHCKboneTable *table, const void *array, unsigned int memb, __GLHCKboneTableNameFunc nameFunc)
+{
+   unsigned int i, size, hash, slot;
+   const char *name;
+   CALL(2, "%p, %p, %u, %p", table, array, memb, nameFunc);
+   assert(table && nameFunc);
+
+   /* keep load factor under half */
+   for (size = 8; size < memb * 2; size *= 2);
+
+   if (table->size != size) {
+      IFDO(_glhckFree, table->slots);
+      if (!(table->slots = _glhckMalloc(size * sizeof(__GLHCKboneTableSlot))))
+         goto fail;
+      table->size = size;
+   }
+
+   memset(table->slots, 0, size * sizeof(__GLHCKboneTableSlot));
+   for (i = 0; i != memb; ++i) {
+      if (!(name = nameFunc(array, i)))
+         continue;
+
+      /* linear probing, first inserted name wins as in linear search */
+      hash = _glhckBoneNameHash(name);
+      for (slot = hash & (size - 1); table->slots[slot].index; slot = (slot + 1) & (size - 1));
+      table->slots[slot].hash = hash;
+      table->slots[slot].index = i + 1;
+   }
+
+   table->revision = GLHCKW()->boneNameRevision;
+   RET(2, "%d", RETURN_OK);
+   return RETURN_OK;
+
+fail:
+   _glhckBoneTableRelease(table);
+   RET(2, "%d", RETURN_FAIL);
+   return RETURN_FAIL;
+}
+
+/* \brief find index of named item from bone table, -1 if not found */
+int _glhckBoneTableFind(const __GLHCKboneTable *table, const void *array, __GLHCKboneTableNameFunc nameFunc, const char *name)
+{
+   unsigned int hash, slot;
+   const __GLHCKboneTableSlot *s;
+   const char *n;
+   assert(table && table->slots && nameFunc && name);
+
+   hash = _glhckBoneNameHash(name);
+   for (slot = hash & (table->size - 1); (s = &table->slots[slot])->index; slot = (slot + 1) & (table->size - 1)) {
+      if (s->hash == hash && (n = nameFunc(array, s->index - 1)) && !strcmp(n, name))
+         return s->index - 1;
+   }
+
+   return -1;
+}
+
+/* \brief release bone table */
+void _glhckBoneTableRelease(__GLHCKboneTable *table)
+{
+   IFDO(_glhckFree, table->slots);
+   memset(table, 0, sizeof(__GLHCKboneTable));
+}
+
 /* \brief allocate new bone object */
 GLHCKAPI glhckBone* glhckBoneNew(void)
 {
@@ -65,6 +143,10 @@ GLHCKAPI unsigned int glhckBoneFree(glhckBone *object)
    for (sb = GLHCKW()->skinBone; sb; sb = sb->next)
       if (sb->bone == object) sb->bone = NULL;
 
+   /* flattened hierarchies need rebuild, skin bones pointing to this lost their name */
+   GLHCKW()->boneRevision++;
+   GLHCKW()->boneNameRevision++;
+
    /* remove from world */
    _glhckWorldRemove(bone, object, glhckBone*);
 
@@ -82,11 +164,18 @@ GLHCKAPI void glhckBoneName(glhckBone *object, const char *name)
    char *nameCopy = NULL;
    CALL(2, "%p, %s", object, name);
 
+   /* same name, keep bone tables */
+   if (name == object->name || (name && object->name && !strcmp(name, object->name)))
+      return;
+
    if (name && !(nameCopy = _glhckStrdup(name)))
       return;
 
    IFDO(_glhckFree, object->name);
    object->name = nameCopy;
+
+   /* invalidate bone tables */
+   GLHCKW()->boneNameRevision++;
 }
 
 /* \brief get bone name */
@@ -102,7 +191,9 @@ GLHCKAPI void glhckBoneParentBone(glhckBone *object, glhckBone *parentBone)
 {
    CALL(0, "%p, %p", object, parentBone);
    assert(object);
+   if (object->parent == parentBone) return;
    object->parent = parentBone;
+   GLHCKW()->boneRevision++;
 }
 
 /* \brief return parent bone index of this bone */
@@ -1,4 +1,7 @@
 #include "../internal.h"
+#include <float.h>  /* for FLT_MAX */
+#include <limits.h> /* for SHRT_MAX */
+#include <math.h>   /* for floorf */
 
 /* tracing channel for this file */
 #define GLHCK_CHANNEL GLHCK_CHANNEL_SKINBONE
@@ -8,23 +11,504 @@
    for (_cbc_ = 0; _cbc_ != parent->numChilds; ++_cbc_)    \
       function(parent->childs[_cbc_], ##__VA_ARGS__); }
 
+/* \brief release flattened bone hierarchy of object */
+void _glhckSkinBoneReleaseHierarchy(glhckObject *object)
+{
+   assert(object);
+   IFDO(_glhckFree, object->hierarchy.bones);
+   IFDO(_glhckFree, object->hierarchy.parents);
+   IFDO(_glhckFree, object->skinning.vertices);
+   IFDO(_glhckFree, object->skinning.boneBounds);
+   IFDO(_glhckFree, object->skinning.influences);
+   IFDO(_glhckFree, object->skinning.influenceOffsets);
+   memset(&object->hierarchy, 0, sizeof(__GLHCKboneHierarchy));
+}
+
+/* \brief insert bone to hierarchy list, if it isn't there yet */
+static void _glhckSkinBoneHierarchyInsert(glhckBone **bones, unsigned int *memb, glhckBone *bone)
+{
+   unsigned int i;
+   for (i = 0; i != *memb && bones[i] != bone; ++i);
+   if (i == *memb) bones[(*memb)++] = bone;
+}
+
+/* \brief flatten object's bone hierarchy to parent before child order */
+static int _glhckSkinBoneBuildHierarchy(glhckObject *object)
+{
+   glhckBone *bone, **bones = NULL;
+   int *parents = NULL;
+   unsigned int i, d, n, memb = 0, maxBones = 0, depth, maxDepth = 0, *depths = NULL;
+   assert(object);
+
+   _glhckSkinBoneReleaseHierarchy(object);
+
+   /* count upper bound of bones, including the parents of skin bones */
+   maxBones = object->numBones;
+   for (i = 0; i != object->numSkinBones; ++i)
+      for (bone = object->skinBones[i]->bone; bone; bone = bone->parent) ++maxBones;
+
+   if (!maxBones) goto success;
+
+   if (!(bones = _glhckMalloc(maxBones * sizeof(glhckBone*))))
+      goto fail;
+   if (!(depths = _glhckMalloc(maxBones * sizeof(unsigned int))))
+      goto fail;
+
+   /* collect every bone that affects the skin */
+   for (i = 0; i != object->numBones; ++i)
+      for (bone = object->bones[i]; bone; bone = bone->parent)
+         _glhckSkinBoneHierarchyInsert(bones, &memb, bone);
+   for (i = 0; i != object->numSkinBones; ++i)
+      for (bone = object->skinBones[i]->bone; bone; bone = bone->parent)
+         _glhckSkinBoneHierarchyInsert(bones, &memb, bone);
+
+   /* calculate depths */
+   for (i = 0; i != memb; ++i) {
+      for (depth = 0, bone = bones[i]->parent; bone; bone = bone->parent, ++depth);
+      if (depth > maxDepth) maxDepth = depth;
+      depths[i] = depth;
+   }
+
+   if (!(object->hierarchy.bones = _glhckMalloc(memb * sizeof(glhckBone*))))
+      goto fail;
+   if (!(parents = object->hierarchy.parents = _glhckMalloc(memb * sizeof(int))))
+      goto fail;
+
+   /* sort by depth, so parents come always before childs */
+   for (d = 0, n = 0; d <= maxDepth; ++d) {
+      for (i = 0; i != memb; ++i) {
+         if (depths[i] != d) continue;
+         object->hierarchy.bones[n++] = bones[i];
+      }
+   }
+
+   /* resolve parent indices */
+   for (n = 0; n != memb; ++n) {
+      parents[n] = -1;
+      if (!(bone = object->hierarchy.bones[n]->parent)) continue;
+      for (i = 0; i != n && object->hierarchy.bones[i] != bone; ++i);
+      parents[n] = i;
+   }
+
+   object->hierarchy.numBones = memb;
+   _glhckFree(bones);
+   _glhckFree(depths);
+
+success:
+   object->hierarchy.revision = GLHCKW()->boneRevision;
+   return RETURN_OK;
+
+fail:
+   IFDO(_glhckFree, bones);
+   IFDO(_glhckFree, depths);
+   _glhckSkinBoneReleaseHierarchy(object);
+   return RETURN_FAIL;
+}
+
 /* \brief update bone structure's transformed matrices */
-static void _glhckSkinBoneUpdateBones(glhckSkinBone **skinBones, unsigned int memb)
+static void _glhckSkinBoneUpdateBones(glhckObject *object)
 {
-   glhckBone *bone, *parent;
+   glhckBone *bone;
    unsigned int n;
-   assert(skinBones);
+   int parent;
+   assert(object);
 
    /* 1. Transform bone to 0,0,0 using offset matrix so we can transform it locally
     * 2. Apply all transformations from parent bones
-    * 3. We'll end up back to bone space with the transformed matrix */
+    * 3. We'll end up back to bone space with the transformed matrix
+    *
+    * Parents are always before childs in the hierarchy,
+    * so each transformed matrix is calculated only once. */
+
+   if ((!object->hierarchy.bones || object->hierarchy.revision != GLHCKW()->boneRevision) &&
+         _glhckSkinBoneBuildHierarchy(object) != RETURN_OK)
+      return;
+
+   for (n = 0; n != object->hierarchy.numBones; ++n) {
+      bone = object->hierarchy.bones[n];
+      if ((parent = object->hierarchy.parents[n]) < 0) {
+         memcpy(&bone->transformedMatrix, &bone->transformationMatrix, sizeof(kmMat4));
+      } else {
+         kmMat4Multiply(&bone->transformedMatrix,
+               &object->hierarchy.bones[parent]->transformedMatrix, &bone->transformationMatrix);
+      }
+   }
+}
 
-   for (n = 0; n != memb; ++n) {
-      if (!(bone = skinBones[n]->bone)) continue;
-      memcpy(&bone->transformedMatrix, &bone->transformationMatrix, sizeof(kmMat4));
-      for (parent = bone->parent; parent; parent = parent->parent)
-         kmMat4Multiply(&bone->transformedMatrix, &parent->transformationMatrix, &bone->transformedMatrix);
+/* geometry's internal space for skinning matrices */
+typedef struct __GLHCKskinSpace {
+   kmMat4 bias, biasinv, scale, scaleinv;
+} __GLHCKskinSpace;
+
+/* \brief get geometry's internal space for skinning matrices */
+static void _glhckSkinBoneSpace(const glhckObject *object, __GLHCKskinSpace *space)
+{
+   kmMat4Translation(&space->bias, object->geometry->bias.x, object->geometry->bias.y, object->geometry->bias.z);
+   kmMat4Scaling(&space->scale, object->geometry->scale.x, object->geometry->scale.y, object->geometry->scale.z);
+   kmMat4Inverse(&space->biasinv, &space->bias);
+   kmMat4Inverse(&space->scaleinv, &space->scale);
+}
+
+/* \brief build skinning matrix for skin bone of object */
+static void _glhckSkinBoneMatrix(const glhckObject *object, unsigned int i, const __GLHCKskinSpace *space, kmMat4 *out)
+{
+   kmMat4 transformedMatrix, offsetMatrix;
+
+   if (!object->skinBones[i]->bone) {
+      kmMat4Identity(out);
+      return;
    }
+
+   kmMat4Multiply(&transformedMatrix, &space->biasinv, &object->skinBones[i]->bone->transformedMatrix);
+   kmMat4Multiply(&transformedMatrix, &space->scaleinv, &transformedMatrix);
+   kmMat4Multiply(&offsetMatrix, &object->skinBones[i]->offsetMatrix, &space->bias);
+   kmMat4Multiply(&offsetMatrix, &offsetMatrix, &space->scale);
+   kmMat4Multiply(out, &transformedMatrix, &offsetMatrix);
+}
+
+/* \brief build skinning matrices for skin bones of object
+ * these take the bind pose vertices to the transformed pose,
+ * in geometry's internal (biased and scaled) space. */
+void _glhckSkinBoneBuildPalette(const glhckObject *object, kmMat4 *palette)
+{
+   unsigned int i;
+   __GLHCKskinSpace space;
+   assert(object && object->geometry && palette);
+
+   _glhckSkinBoneSpace(object, &space);
+   for (i = 0; i != object->numSkinBones; ++i)
+      _glhckSkinBoneMatrix(object, i, &space, &palette[i]);
+}
+
+/* \brief get rest pose vertices of object
+ * geometry holds the rest pose, unless object is skinned on CPU */
+static const void* _glhckSkinBoneRestPose(const glhckObject *object)
+{
+   return (object->bind?object->bind:object->geometry->vertices);
+}
+
+/* \brief build bind pose bounds of vertices weighted by each skin bone */
+static int _glhckSkinBoneBuildBounds(glhckObject *object)
+{
+   kmAABB *bounds = NULL;
+   unsigned char *weighted = NULL;
+   glhckVertexWeight *weight;
+   __GLHCKvertexType *type;
+   unsigned int i, w, v;
+   kmVec3 position;
+   assert(object && object->geometry);
+
+   type = GLHCKVT(object->geometry->vertexType);
+   if (!(bounds = _glhckMalloc(object->numSkinBones * sizeof(kmAABB))))
+      goto fail;
+   if (!(weighted = _glhckCalloc(object->geometry->vertexCount, sizeof(unsigned char))))
+      goto fail;
+
+   for (i = 0; i != object->numSkinBones; ++i) {
+      /* empty box, min > max */
+      kmVec3Fill(&bounds[i].min, FLT_MAX, FLT_MAX, FLT_MAX);
+      kmVec3Fill(&bounds[i].max, -FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+      for (w = 0; w != object->skinBones[i]->numWeights; ++w) {
+         weight = &object->skinBones[i]->weights[w];
+         if ((v = weight->vertexIndex) >= (unsigned int)object->geometry->vertexCount || weight->weight <= 0.0f)
+            continue;
+
+         if (_glhckGeometryVertexPosition(type, _glhckSkinBoneRestPose(object), v, &position) != RETURN_OK)
+            goto fail;
+
+         glhckMinV3(&bounds[i].min, &position);
+         glhckMaxV3(&bounds[i].max, &position);
+         weighted[v] = 1;
+      }
+   }
+
+   for (v = 0; v != (unsigned int)object->geometry->vertexCount && weighted[v]; ++v);
+   object->skinning.unweighted = (v != (unsigned int)object->geometry->vertexCount);
+
+   _glhckFree(weighted);
+   IFDO(_glhckFree, object->skinning.boneBounds);
+   object->skinning.boneBounds = bounds;
+   return RETURN_OK;
+
+fail:
+   IFDO(_glhckFree, bounds);
+   IFDO(_glhckFree, weighted);
+   return RETURN_FAIL;
+}
+
+/* \brief calculate skinned bounding box from bone bounds
+ * skinned vertex is a weighted average of the vertex transformed by its bones,
+ * so it's always inside the union of the bone bounds transformed with each bone.
+ * this is O(bones) and doesn't touch the vertices. */
+static int _glhckSkinBoneCalculateBB(glhckObject *object, const kmMat4 *palette, kmAABB *aabb)
+{
+   unsigned int i, c, empty = 1;
+   kmVec3 corner;
+   const kmAABB *bounds;
+   assert(object && palette && aabb);
+
+   if (!object->skinning.boneBounds && _glhckSkinBoneBuildBounds(object) != RETURN_OK)
+      return RETURN_FAIL;
+
+   if (object->skinning.unweighted) {
+      memset(aabb, 0, sizeof(kmAABB));
+      empty = 0;
+   }
+
+   for (i = 0; i != object->numSkinBones; ++i) {
+      bounds = &object->skinning.boneBounds[i];
+      if (bounds->min.x > bounds->max.x) continue;
+
+      for (c = 0; c != 8; ++c) {
+         corner.x = (c & 1 ? bounds->max.x : bounds->min.x);
+         corner.y = (c & 2 ? bounds->max.y : bounds->min.y);
+         corner.z = (c & 4 ? bounds->max.z : bounds->min.z);
+         kmVec3MultiplyMat4(&corner, &corner, &palette[i]);
+         if (empty) {
+            aabb->min = aabb->max = corner;
+            empty = 0;
+            continue;
+         }
+         glhckMinV3(&aabb->min, &corner);
+         glhckMaxV3(&aabb->max, &corner);
+      }
+   }
+
+   if (empty) memset(aabb, 0, sizeof(kmAABB));
+   return RETURN_OK;
+}
+
+/* \brief build per vertex bone influences from skin bone weights
+ * only the GLHCK_SKIN_INFLUENCES strongest weights are kept for each vertex */
+static int _glhckSkinBoneBuildVertices(glhckObject *object)
+{
+   __GLHCKskinVertex *vertices = NULL;
+   float *weights = NULL, sum;
+   glhckVertexWeight *weight;
+   unsigned int i, w, v, s, min, max, total;
+   assert(object && object->geometry);
+
+   if (!(vertices = _glhckCalloc(object->geometry->vertexCount, sizeof(__GLHCKskinVertex))))
+      goto fail;
+   if (!(weights = _glhckCalloc(object->geometry->vertexCount * GLHCK_SKIN_INFLUENCES, sizeof(float))))
+      goto fail;
+
+   /* keep strongest influences */
+   for (i = 0; i != object->numSkinBones; ++i) {
+      for (w = 0; w != object->skinBones[i]->numWeights; ++w) {
+         weight = &object->skinBones[i]->weights[w];
+         if ((v = weight->vertexIndex) >= (unsigned int)object->geometry->vertexCount) continue;
+         for (s = 1, min = 0; s != GLHCK_SKIN_INFLUENCES; ++s)
+            if (weights[v * GLHCK_SKIN_INFLUENCES + s] < weights[v * GLHCK_SKIN_INFLUENCES + min]) min = s;
+         if (weight->weight <= weights[v * GLHCK_SKIN_INFLUENCES + min]) continue;
+         weights[v * GLHCK_SKIN_INFLUENCES + min] = weight->weight;
+         vertices[v].bones[min] = i;
+      }
+   }
+
+   /* normalize weights to bytes */
+   for (v = 0; v != (unsigned int)object->geometry->vertexCount; ++v) {
+      for (s = 0, sum = 0.0f; s != GLHCK_SKIN_INFLUENCES; ++s) sum += weights[v * GLHCK_SKIN_INFLUENCES + s];
+      if (sum <= 0.0f) continue;
+
+      for (s = 0, max = 0, total = 0; s != GLHCK_SKIN_INFLUENCES; ++s) {
+         vertices[v].weights[s] = (unsigned char)(weights[v * GLHCK_SKIN_INFLUENCES + s] / sum * 255.0f + 0.5f);
+         if (vertices[v].weights[s] > vertices[v].weights[max]) max = s;
+         total += vertices[v].weights[s];
+      }
+
+      /* give rounding error to the strongest influence */
+      vertices[v].weights[max] += 255 - (int)total;
+   }
+
+   _glhckFree(weights);
+   IFDO(_glhckFree, object->skinning.vertices);
+   object->skinning.vertices = vertices;
+   return RETURN_OK;
+
+fail:
+   IFDO(_glhckFree, vertices);
+   IFDO(_glhckFree, weights);
+   return RETURN_FAIL;
+}
+
+/* \brief build per vertex influence lists from skin bone weights for CPU skinning
+ * weights are normalized like for the renderer, so skinned vertex stays inside the bone bounds */
+static int _glhckSkinBoneBuildInfluences(glhckObject *object)
+{
+   __GLHCKskinInfluence *influences = NULL;
+   unsigned int *offsets = NULL, *fill = NULL;
+   glhckVertexWeight *weight;
+   unsigned int i, w, v, vertexCount;
+   float sum;
+   assert(object && object->geometry);
+
+   vertexCount = object->geometry->vertexCount;
+   if (!(offsets = _glhckCalloc(vertexCount + 1, sizeof(unsigned int))))
+      goto fail;
+   if (!(fill = _glhckCalloc(vertexCount, sizeof(unsigned int))))
+      goto fail;
+
+   /* count influences of each vertex */
+   for (i = 0; i != object->numSkinBones; ++i) {
+      for (w = 0; w != object->skinBones[i]->numWeights; ++w) {
+         weight = &object->skinBones[i]->weights[w];
+         if (weight->vertexIndex < vertexCount && weight->weight > 0.0f) ++offsets[weight->vertexIndex + 1];
+      }
+   }
+
+   for (v = 0; v != vertexCount; ++v) offsets[v + 1] += offsets[v];
+   if (offsets[vertexCount] && !(influences = _glhckMalloc(offsets[vertexCount] * sizeof(__GLHCKskinInfluence))))
+      goto fail;
+
+   for (i = 0; i != object->numSkinBones; ++i) {
+      for (w = 0; w != object->skinBones[i]->numWeights; ++w) {
+         weight = &object->skinBones[i]->weights[w];
+         if ((v = weight->vertexIndex) >= vertexCount || weight->weight <= 0.0f) continue;
+         influences[offsets[v] + fill[v]].bone = i;
+         influences[offsets[v] + fill[v]].weight = weight->weight;
+         ++fill[v];
+      }
+   }
+
+   for (v = 0; v != vertexCount; ++v) {
+      for (w = offsets[v], sum = 0.0f; w != offsets[v+1]; ++w) sum += influences[w].weight;
+      for (w = offsets[v]; w != offsets[v+1]; ++w) influences[w].weight /= sum;
+   }
+
+   _glhckFree(fill);
+   IFDO(_glhckFree, object->skinning.influences);
+   IFDO(_glhckFree, object->skinning.influenceOffsets);
+   object->skinning.influences = influences;
+   object->skinning.influenceOffsets = offsets;
+   return RETURN_OK;
+
+fail:
+   IFDO(_glhckFree, offsets);
+   IFDO(_glhckFree, fill);
+   IFDO(_glhckFree, influences);
+   return RETURN_FAIL;
+}
+
+/* \brief can renderer skin this object? */
+static int _glhckSkinBoneCanSkinOnRenderer(const glhckObject *object)
+{
+   /* custom material shaders don't know about skinning */
+   if (object->material && object->material->shader) return RETURN_FALSE;
+   return (object->numSkinBones <= (unsigned int)GLHCKRF()->skinning.maxBones);
+}
+
+/* \brief transform object on renderer with skinning matrices */
+static int _glhckSkinBoneTransformObjectOnRenderer(glhckObject *object)
+{
+   assert(object);
+
+   if (!object->skinning.vertices && _glhckSkinBoneBuildVertices(object) != RETURN_OK)
+      goto fail;
+   if (!object->skinning.palette && !(object->skinning.palette = _glhckMalloc(object->numSkinBones * sizeof(kmMat4))))
+      goto fail;
+
+   /* switching from CPU skinning, restore rest pose for renderer */
+   if (object->bind) {
+      __GLHCKvertexType *type = GLHCKVT(object->geometry->vertexType);
+      memcpy(object->geometry->vertices, object->bind, object->geometry->vertexCount * type->size);
+      NULLDO(_glhckFree, object->bind);
+   }
+
+   object->skinning.renderer = 1;
+   _glhckSkinBoneBuildPalette(object, object->skinning.palette);
+   if (_glhckSkinBoneCalculateBB(object, object->skinning.palette, &object->view.bounding) != RETURN_OK)
+      glhckGeometryCalculateBB(object->geometry, &object->view.bounding);
+
+   return RETURN_OK;
+
+fail:
+   return RETURN_FAIL;
+}
+
+/* \brief transform object on CPU with transform function of its vertex type
+ * used for vertex types which positions can't be read in single pass */
+static int _glhckSkinBoneTransformObjectWithApi(glhckObject *object)
+{
+   int v;
+   __GLHCKvertexType *type;
+   assert(object);
+
+   type = GLHCKVT(object->geometry->vertexType);
+   if (!type->api.transform)
+      goto fail;
+
+   /* geometry holds the rest pose, until first skinned on CPU */
+   if (!object->bind && !(object->bind = _glhckCopy(object->geometry->vertices, object->geometry->vertexCount * type->size)))
+      goto fail;
+
+   object->skinning.renderer = 0;
+
+   /* zero pose, transform function accumulates positions to it */
+   memcpy(object->geometry->vertices, object->bind, object->geometry->vertexCount * type->size);
+   for (v = 0; v != object->geometry->vertexCount; ++v)
+      memset((char*)object->geometry->vertices + v * type->size + type->offset[0], 0, type->memb[0] * type->msize[0]);
+
+   type->api.transform(object->geometry, object->bind, object->skinBones, object->numSkinBones);
+   glhckGeometryCalculateBB(object->geometry, &object->view.bounding);
+   return RETURN_OK;
+
+fail:
+   return RETURN_FAIL;
+}
+
+/* \brief transform object on CPU with skinning matrices
+ * positions are read from the rest pose and written to geometry in single pass,
+ * rest of the vertex data is left untouched. */
+static int _glhckSkinBoneTransformObjectOnCPU(glhckObject *object)
+{
+   unsigned int v, i, end;
+   kmVec3 rest, skinned, position;
+   const __GLHCKskinInfluence *influence;
+   __GLHCKvertexType *type;
+   assert(object);
+
+   type = GLHCKVT(object->geometry->vertexType);
+   switch (type->dataType[0]) {
+      case GLHCK_BYTE: case GLHCK_SHORT: case GLHCK_FLOAT: break;
+      default: return _glhckSkinBoneTransformObjectWithApi(object);
+   }
+   if (!object->skinning.influenceOffsets && _glhckSkinBoneBuildInfluences(object) != RETURN_OK)
+      goto fail;
+   if (!object->skinning.palette && !(object->skinning.palette = _glhckMalloc(object->numSkinBones * sizeof(kmMat4))))
+      goto fail;
+
+   /* geometry holds the rest pose, until first skinned on CPU */
+   if (!object->bind && !(object->bind = _glhckCopy(object->geometry->vertices, object->geometry->vertexCount * type->size)))
+      goto fail;
+
+   object->skinning.renderer = 0;
+   _glhckSkinBoneBuildPalette(object, object->skinning.palette);
+
+   for (v = 0; v != (unsigned int)object->geometry->vertexCount; ++v) {
+      if (_glhckGeometryVertexPosition(type, object->bind, v, &rest) != RETURN_OK)
+         goto fail;
+
+      memset(&skinned, 0, sizeof(kmVec3));
+      for (i = object->skinning.influenceOffsets[v], end = object->skinning.influenceOffsets[v+1]; i != end; ++i) {
+         influence = &object->skinning.influences[i];
+         kmVec3MultiplyMat4(&position, &rest, &object->skinning.palette[influence->bone]);
+         skinned.x += position.x * influence->weight;
+         skinned.y += position.y * influence->weight;
+         skinned.z += position.z * influence->weight;
+      }
+
+      _glhckGeometryWriteVertexPosition(type, object->geometry->vertices, v, &skinned);
+   }
+
+   if (_glhckSkinBoneCalculateBB(object, object->skinning.palette, &object->view.bounding) != RETURN_OK)
+      glhckGeometryCalculateBB(object->geometry, &object->view.bounding);
+
+   return RETURN_OK;
+
+fail:
+   return RETURN_FAIL;
 }
 
 /* \brief transform object with its skin bones */
@@ -38,16 +522,22 @@ void _glhckSkinBoneTransformObject(glhckObject *object, int updateBones)
    /* ah, we can't do this ;_; */
    if (!object->geometry || !object->skinBones) return;
 
-   /* update bones, if requested */
-   if (updateBones) _glhckSkinBoneUpdateBones(object->skinBones, object->numSkinBones);
+   /* bones or weights have changed */
+   if (object->hierarchy.revision != GLHCKW()->boneRevision)
+      _glhckSkinBoneReleaseHierarchy(object);
 
-   assert(object->zero && object->bind);
-   __GLHCKvertexType *type = GLHCKVT(object->geometry->vertexType);
-   memcpy(object->geometry->vertices, object->zero, object->geometry->vertexCount * type->size);
-   type->api.transform(object->geometry, object->bind, object->skinBones, object->numSkinBones);
+   /* update bones, if requested */
+   if (updateBones) _glhckSkinBoneUpdateBones(object);
+
+   /* let the renderer do the skinning, if it can
+    * otherwise fallback to CPU skinning */
+   if (!_glhckSkinBoneCanSkinOnRenderer(object) ||
+         _glhckSkinBoneTransformObjectOnRenderer(object) != RETURN_OK) {
+      if (_glhckSkinBoneTransformObjectOnCPU(object) != RETURN_OK)
+         DEBUG(GLHCK_DBG_ERROR, "Failed to skin object %p", object);
+   }
 
    /* update bounding box for object */
-   glhckGeometryCalculateBB(object->geometry, &object->view.bounding);
    _glhckObjectUpdateBoxes(object);
 }
 
@@ -117,9 +607,19 @@ success:
 /* \brief set pointer to real bone from skinned bone */
 GLHCKAPI void glhckSkinBoneBone(glhckSkinBone *object, glhckBone *bone)
 {
+   const char *name, *oldName;
    CALL(0, "%p, %p", object, bone);
    assert(object);
+   if (object->bone == bone) return;
+
+   /* skin bone is named by its bone */
+   oldName = (object->bone?object->bone->name:NULL);
+   name = (bone?bone->name:NULL);
+   if (name != oldName && (!name || !oldName || strcmp(name, oldName)))
+      GLHCKW()->boneNameRevision++;
+
    object->bone = bone;
+   GLHCKW()->boneRevision++;
 }
 
 /* \brief return pointer to real bone */
@@ -152,6 +652,9 @@ GLHCKAPI int glhckSkinBoneInsertWeights(glhckSkinBone *object, const glhckVertex
    IFDO(_glhckFree, object->weights);
    object->weights = weightsCopy;
    object->numWeights = (weightsCopy?memb:0);
+
+   /* influences of skinned objects need rebuild */
+   GLHCKW()->boneRevision++;
    return RETURN_OK;
 
 fail:
@@ -17,14 +17,28 @@
 
 #define GLHCK_TEXT_HASH_SIZE 256
 #define GLHCK_TEXT_ROWS 128
-#define GLHCK_TEXT_VERT_COUNT (6*GLHCK_TEXT_ROWS)
+#define GLHCK_TEXT_VERT_COUNT (4*GLHCK_TEXT_ROWS)
+#define GLHCK_TEXT_PENDING 64
+#define GLHCK_TEXT_LAYOUT_HASH_SIZE 256
+#define GLHCK_TEXT_LAYOUTS 256
+#define GLHCK_TEXT_SUBPIXEL 4
+#define GLHCK_TEXT_SDF_SPREAD 6
+#define GLHCK_TEXT_SDF_INF 1e20f
 
 /* \brief font types */
 typedef enum _glhckTextFontType {
    GLHCK_FONT_TTF,
    GLHCK_FONT_BMP,
+   GLHCK_FONT_SDF,
 } _glhckTextFontType;
 
+/* \brief vertex of text geometry */
+#if GLHCK_TEXT_FLOAT_PRECISION
+typedef glhckVertexData2f __GLHCKtextVertex;
+#else
+typedef glhckVertexData2s __GLHCKtextVertex;
+#endif
+
 /* \brief quad helper struct */
 typedef struct __GLHCKtextQuad {
 #if GLHCK_TEXT_FLOAT_PRECISION /* floats ftw */
@@ -51,16 +65,56 @@ typedef struct __GLHCKtextGlyph
 typedef struct __GLHCKtextFont
 {
    struct stbtt_fontinfo font;
-   struct __GLHCKtextFont *next;
    struct __GLHCKtextGlyph *glyphCache;
    struct __GLHCKtextTexture *texture; /* only used on bitmap fonts */
    void *data;
    float ascender, descender, lineHeight;
    unsigned int id, glyphCount;
    int lut[GLHCK_TEXT_HASH_SIZE];
+   short referenceSize; /* size distance fields are generated at */
    _glhckTextFontType type;
 } __GLHCKtextFont;
 
+/* \brief glyph waiting for batched rasterization */
+typedef struct __GLHCKtextPendingGlyph
+{
+   const struct stbtt_fontinfo *font;
+   struct __GLHCKtextTexture *texture;
+   float scale;
+   int gid, x, y, w, h;
+   int spread; /* padding of distance field, 0 for plain coverage */
+} __GLHCKtextPendingGlyph;
+
+/* \brief laid out vertices of string in one cache page */
+typedef struct __GLHCKtextLayoutRun
+{
+   struct __GLHCKtextTexture *texture;
+   struct __GLHCKtextGeometry geometry;
+} __GLHCKtextLayoutRun;
+
+/* \brief laid out string, drawn with translation only */
+typedef struct __GLHCKtextLayout
+{
+   struct __GLHCKtextLayout *prev, *next; /* recency list, or list of retained layouts */
+   struct __GLHCKtextLayout *hnext; /* hash chain */
+   struct __GLHCKtextLayoutRun *runs;
+   char *string;
+   float width;
+   float fx, fy; /* quantized sub-pixel origin laid out at, drawn translated by whole pixels */
+   unsigned int id, fontId, hash, numRuns;
+   short isize;
+   char stale; /* glyph cache was flushed, lay out again before drawing */
+} __GLHCKtextLayout;
+
+/* \brief layout cache of text object */
+typedef struct __GLHCKtextLayoutCache
+{
+   struct __GLHCKtextLayout *lut[GLHCK_TEXT_LAYOUT_HASH_SIZE];
+   struct __GLHCKtextLayout *head, *tail; /* most recently used first */
+   struct __GLHCKtextLayout *retained;
+   unsigned int count, nextId;
+} __GLHCKtextLayoutCache;
+
 // Copyright (c) 2008-2009 Bjoern Hoehrmann <bjoern@hoehrmann.de>
 // See http://bjoern.hoehrmann.de/utf-8/decoder/dfa/ for details.
 
@@ -133,6 +187,30 @@ static unsigned int hashint(unsigned int a)
    return a;
 }
 
+/* \brief get font by id */
+static __GLHCKtextFont* _glhckTextFontGet(const glhckText *object, unsigned int id)
+{
+   return (id && id <= object->fontCount ? object->fonts[id-1] : NULL);
+}
+
+/* \brief get id for new font, ids of freed fonts are reused */
+static unsigned int _glhckTextFontSlot(glhckText *object)
+{
+   unsigned int i;
+   __GLHCKtextFont **fonts;
+
+   for (i = 0; i != object->fontCount && object->fonts[i]; ++i);
+   if (i != object->fontCount)
+      return i+1;
+
+   if (!(fonts = _glhckRealloc(object->fonts, object->fontCount, object->fontCount+1, sizeof(__GLHCKtextFont*))))
+      return 0;
+
+   object->fonts = fonts;
+   object->fonts[object->fontCount++] = NULL;
+   return object->fontCount;
+}
+
 /* \brief resize geometry data */
 static int _glhckTextGeometryAllocateMore(__GLHCKtextGeometry *geometry)
 {
@@ -160,6 +238,97 @@ fail:
    return RETURN_FAIL;
 }
 
+/* \brief append glyph quad to text geometry
+ * quads are drawn as indexed triangles, with indices shared by all quads */
+static int _glhckTextGeometryInsertQuad(__GLHCKtextGeometry *geometry, const __GLHCKtextQuad *q)
+{
+   int i;
+   __GLHCKtextVertex *v;
+
+   if (geometry->vertexCount+4 >= geometry->allocatedCount) {
+      if (_glhckTextGeometryAllocateMore(geometry) != RETURN_OK)
+         return RETURN_FAIL;
+   }
+
+   /* insert geometry data */
+   v = &geometry->vertexData[geometry->vertexCount];
+
+   /* NOTE: Text geometry has inverse winding to glhck's planes.
+    * This is so we don't need to toggle winding order in GL when drawing.
+    *
+    * The end effect is basically same as using glhckRenderFlip,
+    * only these vertices are pre-multiplied. */
+
+   i = 0;
+   v[i].vertex.x = q->v1.x; v[i+0].vertex.y = q->v1.y;
+   v[i].coord.x  = q->t1.x; v[i++].coord.y  = q->t1.y;
+   v[i].vertex.x = q->v2.x; v[i+0].vertex.y = q->v1.y;
+   v[i].coord.x  = q->t2.x; v[i++].coord.y  = q->t1.y;
+   v[i].vertex.x = q->v2.x; v[i+0].vertex.y = q->v2.y;
+   v[i].coord.x  = q->t2.x; v[i++].coord.y  = q->t2.y;
+   v[i].vertex.x = q->v1.x; v[i+0].vertex.y = q->v2.y;
+   v[i].coord.x  = q->t1.x; v[i++].coord.y  = q->t2.y;
+
+   geometry->vertexCount += i;
+   return RETURN_OK;
+}
+
+/* \brief append laid out run to text geometry, translated by whole pixels */
+static int _glhckTextGeometryInsertRun(__GLHCKtextGeometry *geometry, const __GLHCKtextGeometry *run, int tx, int ty)
+{
+   int i;
+   __GLHCKtextVertex *v;
+
+   if (!run->vertexCount)
+      return RETURN_OK;
+
+   while (geometry->vertexCount + run->vertexCount >= geometry->allocatedCount) {
+      if (_glhckTextGeometryAllocateMore(geometry) != RETURN_OK)
+         return RETURN_FAIL;
+   }
+
+   v = &geometry->vertexData[geometry->vertexCount];
+   for (i = 0; i != run->vertexCount; ++i) {
+      memcpy(&v[i], &run->vertexData[i], sizeof(__GLHCKtextVertex));
+      v[i].vertex.x += tx; v[i].vertex.y += ty;
+   }
+
+   geometry->vertexCount += run->vertexCount;
+   return RETURN_OK;
+}
+
+/* \brief make shared quad indices cover the largest cache page
+ * 16-bit indices address GLHCK_TEXT_QUAD_BATCH quads, bigger pages are drawn in batches */
+static int _glhckTextIndicesReserve(glhckText *object)
+{
+   unsigned int i, quads = 0;
+   unsigned short *indices;
+   __GLHCKtextTexture *t;
+
+   for (t = object->textureCache; t; t = t->next)
+      if ((unsigned int)t->geometry.vertexCount/4 > quads) quads = t->geometry.vertexCount/4;
+
+   if (quads > GLHCK_TEXT_QUAD_BATCH) quads = GLHCK_TEXT_QUAD_BATCH;
+   if (quads <= object->indexQuads)
+      return RETURN_OK;
+
+   /* grow in steps, so the indices aren't rebuilt for every new glyph */
+   quads = (quads + GLHCK_TEXT_ROWS-1) & ~(GLHCK_TEXT_ROWS-1);
+   if (quads > GLHCK_TEXT_QUAD_BATCH) quads = GLHCK_TEXT_QUAD_BATCH;
+
+   if (!(indices = _glhckRealloc(object->indices, object->indexQuads*6, quads*6, sizeof(unsigned short))))
+      return RETURN_FAIL;
+
+   for (i = object->indexQuads; i != quads; ++i) {
+      indices[i*6+0] = i*4+0; indices[i*6+1] = i*4+1; indices[i*6+2] = i*4+2;
+      indices[i*6+3] = i*4+0; indices[i*6+4] = i*4+2; indices[i*6+5] = i*4+3;
+   }
+
+   object->indices = indices;
+   object->indexQuads = quads;
+   return RETURN_OK;
+}
+
 /* \brief resize row data */
 static int _glhckTextTextureRowsAllocateMore(__GLHCKtextTexture *texture)
 {
@@ -218,11 +387,142 @@ fail:
    return RETURN_FAIL;
 }
 
+/* \brief hash layout key (FNV-1a) */
+static unsigned int _glhckTextLayoutHash(unsigned int fontId, short isize, const char *s)
+{
+   unsigned int hash = 2166136261u;
+   hash = (hash ^ fontId) * 16777619u;
+   hash = (hash ^ (unsigned short)isize) * 16777619u;
+   for (; *s; ++s) hash = (hash ^ *(unsigned char*)s) * 16777619u;
+   return hash;
+}
+
+/* \brief free laid out vertices of layout */
+static void _glhckTextLayoutFreeRuns(__GLHCKtextLayout *layout)
+{
+   unsigned int i;
+   for (i = 0; i != layout->numRuns; ++i)
+      IFDO(_glhckFree, layout->runs[i].geometry.vertexData);
+   IFDO(_glhckFree, layout->runs);
+   layout->numRuns = 0;
+}
+
+/* \brief free layout */
+static void _glhckTextLayoutFree(__GLHCKtextLayout *layout)
+{
+   _glhckTextLayoutFreeRuns(layout);
+   IFDO(_glhckFree, layout->string);
+   _glhckFree(layout);
+}
+
+/* \brief unlink layout from recency list and hash chain of cache */
+static void _glhckTextLayoutUnlink(__GLHCKtextLayoutCache *cache, __GLHCKtextLayout *layout)
+{
+   __GLHCKtextLayout **l;
+
+   for (l = &cache->lut[layout->hash & (GLHCK_TEXT_LAYOUT_HASH_SIZE-1)]; *l && *l != layout; l = &(*l)->hnext);
+   if (*l) *l = layout->hnext;
+
+   if (layout->prev) layout->prev->next = layout->next;
+   else cache->head = layout->next;
+   if (layout->next) layout->next->prev = layout->prev;
+   else cache->tail = layout->prev;
+
+   layout->prev = layout->next = layout->hnext = NULL;
+   cache->count--;
+}
+
+/* \brief link layout as most recently used */
+static void _glhckTextLayoutLink(__GLHCKtextLayoutCache *cache, __GLHCKtextLayout *layout)
+{
+   unsigned int h = layout->hash & (GLHCK_TEXT_LAYOUT_HASH_SIZE-1);
+   layout->hnext = cache->lut[h];
+   cache->lut[h] = layout;
+
+   layout->prev = NULL;
+   layout->next = cache->head;
+   if (cache->head) cache->head->prev = layout;
+   else cache->tail = layout;
+   cache->head = layout;
+   cache->count++;
+}
+
+/* \brief get layout cache of text, allocated on first use */
+static __GLHCKtextLayoutCache* _glhckTextLayoutCache(glhckText *object)
+{
+   if (!object->layoutCache)
+      object->layoutCache = _glhckCalloc(1, sizeof(__GLHCKtextLayoutCache));
+   return object->layoutCache;
+}
+
+/* \brief allocate layout for string */
+static __GLHCKtextLayout* _glhckTextLayoutNew(unsigned int fontId, short isize, unsigned int hash, const char *s)
+{
+   __GLHCKtextLayout *layout;
+
+   if (!(layout = _glhckCalloc(1, sizeof(__GLHCKtextLayout))))
+      goto fail;
+
+   if (!(layout->string = _glhckStrdup(s)))
+      goto fail;
+
+   layout->fontId = fontId;
+   layout->isize = isize;
+   layout->hash = hash;
+   layout->stale = 1;
+   return layout;
+
+fail:
+   IFDO(_glhckFree, layout);
+   return NULL;
+}
+
+/* \brief glyph cache changed, cached layouts are freed and retained ones laid out again on next draw */
+static void _glhckTextLayoutsInvalidate(glhckText *object)
+{
+   __GLHCKtextLayout *l, *ln;
+   __GLHCKtextLayoutCache *cache;
+
+   if (!(cache = object->layoutCache))
+      return;
+
+   for (l = cache->head; l; l = ln) {
+      ln = l->next;
+      _glhckTextLayoutFree(l);
+   }
+
+   memset(cache->lut, 0, sizeof(cache->lut));
+   cache->head = cache->tail = NULL;
+   cache->count = 0;
+
+   for (l = cache->retained; l; l = l->next) {
+      _glhckTextLayoutFreeRuns(l);
+      l->stale = 1;
+   }
+}
+
+/* \brief free layout cache of text */
+static void _glhckTextLayoutsFree(glhckText *object)
+{
+   __GLHCKtextLayout *l, *ln;
+
+   if (!object->layoutCache)
+      return;
+
+   _glhckTextLayoutsInvalidate(object);
+   for (l = object->layoutCache->retained; l; l = ln) {
+      ln = l->next;
+      _glhckTextLayoutFree(l);
+   }
+
+   NULLDO(_glhckFree, object->layoutCache);
+}
+
 /* \brief free cache texture from text object
  * NOTE: all glyphs from fonts pointing to this cache texture are flushed after this! */
 static void _glhckTextTextureFree(glhckText *object, __GLHCKtextTexture *texture)
 {
-   unsigned int i;
+   unsigned int i, n, fi;
    __GLHCKtextTexture *t, *tp;
    __GLHCKtextFont *f;
    CALL(1, "%p, %p", object, texture);
@@ -233,7 +533,8 @@ static void _glhckTextTextureFree(glhckText *object, __GLHCKtextTexture *texture
    if (!t) return;
 
    /* remove glyphs from fonts that contain this texture */
-   for (f = object->fontCache; f; f = f->next) {
+   for (fi = 0; fi != object->fontCount; ++fi) {
+      if (!(f = object->fonts[fi])) continue;
       for (i = 0; i != f->glyphCount; ++i) {
          if (f->glyphCache[i].texture != t) continue;
          IFDO(_glhckFree, f->glyphCache);
@@ -243,16 +544,51 @@ static void _glhckTextTextureFree(glhckText *object, __GLHCKtextTexture *texture
       }
    }
 
+   /* layouts may refer to this texture */
+   _glhckTextLayoutsInvalidate(object);
+
+   /* drop glyphs waiting for this texture */
+   for (i = 0, n = 0; i != object->pendingCount; ++i)
+      if (object->pending[i].texture != t) object->pending[n++] = object->pending[i];
+   object->pendingCount = n;
+
    if (!tp) object->textureCache = t->next;
    else tp->next = t->next;
    IFDO(glhckTextureFree, t->texture);
    IFDO(_glhckFree, t->geometry.vertexData);
    IFDO(_glhckFree, t->rows);
+   IFDO(_glhckFree, t->pixels);
    _glhckFree(t);
 }
 
-/* \brief get texture where to cache the glyph, will allocate new cache page if glyph doesn't fit any existing pages. */
-static __GLHCKtextTexture* _glhckTextGetTextureCache(glhckText *object, int gw, int gh, __GLHCKtextTextureRow **row)
+/* \brief free cache pages holding glyphs of font, so their rows can be used again.
+ * NOTE: glyphs of other fonts on those pages are flushed too! */
+static void _glhckTextFontFreeGlyphs(glhckText *object, __GLHCKtextFont *font)
+{
+   unsigned int i, p, n;
+   __GLHCKtextTexture **pages;
+   CALL(1, "%p, %p", object, font);
+   assert(object && font);
+
+   /* freeing a page frees the glyph cache, so collect the pages first */
+   if (font->glyphCount && (pages = _glhckMalloc(font->glyphCount * sizeof(__GLHCKtextTexture*)))) {
+      for (i = 0, n = 0; i != font->glyphCount; ++i) {
+         for (p = 0; p != n && pages[p] != font->glyphCache[i].texture; ++p);
+         if (p == n && font->glyphCache[i].texture) pages[n++] = font->glyphCache[i].texture;
+      }
+      for (p = 0; p != n; ++p) _glhckTextTextureFree(object, pages[p]);
+      _glhckFree(pages);
+   }
+
+   IFDO(_glhckFree, font->glyphCache);
+   font->glyphCount = 0;
+   memset(font->lut, -1, GLHCK_TEXT_HASH_SIZE * sizeof(int));
+}
+
+/* \brief get texture where to cache the glyph, will allocate new cache page if glyph doesn't fit any existing pages.
+ * distance field glyphs are kept in their own pages, as they are drawn with different shader. */
+static __GLHCKtextTexture* _glhckTextGetTextureCache(glhckText *object, int gw, int gh, char distanceField,
+      __GLHCKtextTextureRow **row)
 {
    short py;
    int i, rh;
@@ -269,14 +605,17 @@ static __GLHCKtextTexture* _glhckTextGetTextureCache(glhckText *object, int gw,
       if (_glhckTextTextureNew(object, GLHCK_ALPHA, GLHCK_UNSIGNED_BYTE, NULL) != RETURN_OK)
          return NULL;
       texture = object->textureCache;
+      texture->distanceField = distanceField;
    }
 
    while (!br) {
-      /* skip textures with INT_MAX rows (these are either really big text blobs or bitmap fonts) */
-      while (texture && texture->rowsCount == INT_MAX) {
+      /* skip textures with INT_MAX rows (these are either really big text blobs or bitmap fonts),
+       * and pages of the other glyph kind */
+      while (texture && (texture->rowsCount == INT_MAX || texture->distanceField != distanceField)) {
          if (!texture->next) {
             if (_glhckTextTextureNew(object, GLHCK_ALPHA, GLHCK_UNSIGNED_BYTE, NULL) != RETURN_OK)
                return NULL;
+            texture->next->distanceField = distanceField;
          }
          texture = texture->next;
       }
@@ -317,6 +656,7 @@ static __GLHCKtextTexture* _glhckTextGetTextureCache(glhckText *object, int gw,
             /* as last resort create new texture, if this was used */
             if (_glhckTextTextureNew(object, GLHCK_ALPHA, GLHCK_UNSIGNED_BYTE, NULL) != RETURN_OK)
                return NULL;
+            texture->next->distanceField = distanceField;
 
             /* cycle and hope for best */
             texture = texture->next;
@@ -344,12 +684,178 @@ fail:
    return NULL;
 }
 
+/* \brief queue glyph for batched rasterization, glyph is rasterized to CPU copy of the page */
+static void _glhckTextQueueGlyph(glhckText *object, __GLHCKtextFont *font, __GLHCKtextTexture *texture,
+      const __GLHCKtextGlyph *glyph, int gid, float scale, int spread)
+{
+   unsigned int newCount;
+   __GLHCKtextPendingGlyph *pending;
+
+   if (!texture->pixels && !(texture->pixels = _glhckCalloc(object->cacheWidth * object->cacheHeight, 1)))
+      goto fail;
+
+   if (object->pendingCount >= object->pendingAllocated) {
+      newCount = object->pendingAllocated + GLHCK_TEXT_PENDING;
+      if (!(pending = _glhckRealloc(object->pending, object->pendingAllocated, newCount, sizeof(__GLHCKtextPendingGlyph))))
+         goto fail;
+
+      object->pending = pending;
+      object->pendingAllocated = newCount;
+   }
+
+   pending = &object->pending[object->pendingCount++];
+   pending->font = &font->font;
+   pending->texture = texture;
+   pending->scale = scale;
+   pending->gid = gid;
+   pending->x = glyph->x1;
+   pending->y = glyph->y1;
+   pending->w = glyph->x2 - glyph->x1;
+   pending->h = glyph->y2 - glyph->y1;
+   pending->spread = spread;
+
+   /* grow band of rows to upload */
+   if (texture->dirtyY2 <= texture->dirtyY1) {
+      texture->dirtyY1 = glyph->y1;
+      texture->dirtyY2 = glyph->y2;
+   } else {
+      if (glyph->y1 < texture->dirtyY1) texture->dirtyY1 = glyph->y1;
+      if (glyph->y2 > texture->dirtyY2) texture->dirtyY2 = glyph->y2;
+   }
+   return;
+
+fail:
+   DEBUG(GLHCK_DBG_WARNING, "TEXT :: [%p] out of memory!", object);
+}
+
+/* \brief squared euclidean distance transform of one line (Felzenszwalb & Huttenlocher)
+ * v needs n, z needs n+1 elements */
+static void _glhckTextDistanceLine(const float *f, float *d, int *v, float *z, int n)
+{
+   int q, k = 0;
+   float s;
+
+   v[0] = 0; z[0] = -GLHCK_TEXT_SDF_INF; z[1] = GLHCK_TEXT_SDF_INF;
+   for (q = 1; q < n; ++q) {
+      while (1) {
+         s = ((f[q] + q*q) - (f[v[k]] + v[k]*v[k])) / (2*q - 2*v[k]);
+         if (s > z[k] || !k) break;
+         --k;
+      }
+      ++k; v[k] = q; z[k] = s; z[k+1] = GLHCK_TEXT_SDF_INF;
+   }
+
+   for (k = 0, q = 0; q < n; ++q) {
+      while (z[k+1] < q) ++k;
+      d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+   }
+}
+
+/* \brief squared euclidean distance transform of grid, in place */
+static void _glhckTextDistanceGrid(float *grid, int w, int h, float *f, float *d, int *v, float *z)
+{
+   int x, y;
+
+   for (x = 0; x < w; ++x) {
+      for (y = 0; y < h; ++y) f[y] = grid[y*w+x];
+      _glhckTextDistanceLine(f, d, v, z, h);
+      for (y = 0; y < h; ++y) grid[y*w+x] = d[y];
+   }
+
+   for (y = 0; y < h; ++y) {
+      _glhckTextDistanceLine(&grid[y*w], d, v, z, w);
+      memcpy(&grid[y*w], d, w * sizeof(float));
+   }
+}
+
+/* \brief rasterize glyph as signed distance field to page
+ * 0.5 is the outline, distance of spread pixels maps to 0.0 (outside) and 1.0 (inside) */
+static void _glhckTextRasterizeDistanceField(const glhckText *object, const __GLHCKtextPendingGlyph *pending)
+{
+   int i, x, y, n = pending->w * pending->h, l = (pending->w > pending->h ? pending->w : pending->h);
+   float *inside, *outside, *f, *d, *z, dist;
+   unsigned char *coverage, *data;
+   int *v;
+
+   /* distances to both sides of outline, line temporaries and glyph coverage,
+    * bytes go last so the floats and ints stay aligned */
+   if (!(inside = _glhckCalloc(1, (n*2 + l*3 + 1) * sizeof(float) + l * sizeof(int) + n)))
+      return;
+
+   outside = inside + n;
+   f = outside + n; d = f + l; z = d + l;
+   v = (int*)(z + l + 1);
+   coverage = (unsigned char*)(v + l);
+
+   stbtt_MakeGlyphBitmap(pending->font, coverage + pending->spread * pending->w + pending->spread,
+         pending->w - pending->spread * 2, pending->h - pending->spread * 2, pending->w,
+         pending->scale, pending->scale, pending->gid);
+
+   for (i = 0; i < n; ++i) {
+      inside[i] = (coverage[i] >= 128 ? GLHCK_TEXT_SDF_INF : 0.0f);
+      outside[i] = (coverage[i] >= 128 ? 0.0f : GLHCK_TEXT_SDF_INF);
+   }
+
+   _glhckTextDistanceGrid(inside, pending->w, pending->h, f, d, v, z);
+   _glhckTextDistanceGrid(outside, pending->w, pending->h, f, d, v, z);
+
+   /* outline lies half a pixel from centers of the pixels next to it */
+   for (y = 0; y < pending->h; ++y) {
+      data = pending->texture->pixels + (pending->y + y) * object->cacheWidth + pending->x;
+      for (x = 0; x < pending->w; ++x) {
+         i = y * pending->w + x;
+         if (coverage[i] >= 128) dist = sqrtf(inside[i]) - 0.5f;
+         else dist = 0.5f - sqrtf(outside[i]);
+         dist = 0.5f + dist / (pending->spread * 2);
+         data[x] = (dist <= 0.0f ? 0 : dist >= 1.0f ? 255 : (unsigned char)(dist * 255.0f));
+      }
+   }
+
+   _glhckFree(inside);
+}
+
+/* \brief rasterize one pending glyph on job thread, glyphs never overlap in page */
+static void _glhckTextRasterizeJob(void *userData, unsigned int index)
+{
+   const glhckText *object = userData;
+   const __GLHCKtextPendingGlyph *pending = &object->pending[index];
+   unsigned char *data = pending->texture->pixels + pending->y * object->cacheWidth + pending->x;
+
+   if (pending->spread) {
+      _glhckTextRasterizeDistanceField(object, pending);
+      return;
+   }
+
+   stbtt_MakeGlyphBitmap(pending->font, data, pending->w, pending->h, object->cacheWidth, pending->scale, pending->scale, pending->gid);
+}
+
+/* \brief rasterize pending glyphs in parallel and upload them with one fill for each cache page */
+static void _glhckTextFlushGlyphs(glhckText *object)
+{
+   int h;
+   __GLHCKtextTexture *t;
+   assert(object);
+
+   if (!object->pendingCount)
+      return;
+
+   _glhckJobParallelFor(object->pendingCount, _glhckTextRasterizeJob, object);
+   object->pendingCount = 0;
+
+   /* page has full rows, so band of rows is contiguous in memory */
+   for (t = object->textureCache; t; t = t->next) {
+      if (!t->pixels || (h = t->dirtyY2 - t->dirtyY1) <= 0) continue;
+      glhckTextureFill(t->texture, 0, 0, t->dirtyY1, 0, object->cacheWidth, h, 0,
+            GLHCK_ALPHA, GLHCK_UNSIGNED_BYTE, object->cacheWidth * h, t->pixels + t->dirtyY1 * object->cacheWidth);
+      t->dirtyY1 = t->dirtyY2 = 0;
+   }
+}
+
 /* \brief get glyph from font */
 __GLHCKtextGlyph* _glhckTextGetGlyph(glhckText *object, __GLHCKtextFont *font, unsigned int code, short isize)
 {
-   int i, x1, y1, x2, y2, gw, gh, gid, advance, lsb;
+   int i, x1, y1, x2, y2, gw, gh, gid, advance, lsb, spread = 0;
    unsigned int h;
-   unsigned char *data;
    float scale;
    float size = (float)isize/10.0f;
    __GLHCKtextGlyph *glyph;
@@ -361,7 +867,7 @@ __GLHCKtextGlyph* _glhckTextGetGlyph(glhckText *object, __GLHCKtextFont *font, u
    i = font->lut[h];
    while (font->glyphCache && i != -1) {
       if (font->glyphCache[i].code == code &&
-         (font->type == GLHCK_FONT_BMP ||
+         (font->type != GLHCK_FONT_TTF ||
           font->glyphCache[i].size == isize))
          return &font->glyphCache[i];
       i = font->glyphCache[i].next;
@@ -371,6 +877,13 @@ __GLHCKtextGlyph* _glhckTextGetGlyph(glhckText *object, __GLHCKtextFont *font, u
    if (font->type == GLHCK_FONT_BMP)
       return NULL;
 
+   /* distance field glyphs are generated once at reference size, and scaled when drawn */
+   if (font->type == GLHCK_FONT_SDF) {
+      isize = font->referenceSize;
+      size = (float)isize/10.0f;
+      spread = GLHCK_TEXT_SDF_SPREAD;
+   }
+
    /* create glyph if ttf font */
    scale = stbtt_ScaleForPixelHeight(&font->font, size);
    gid   = stbtt_FindGlyphIndex(&font->font, code);
@@ -378,8 +891,14 @@ __GLHCKtextGlyph* _glhckTextGetGlyph(glhckText *object, __GLHCKtextFont *font, u
    stbtt_GetGlyphBitmapBox(&font->font, gid, scale, scale, &x1, &y1, &x2, &y2);
    gw = x2-x1; gh = y2-y1;
 
+   /* distance field extends spread pixels out of the outline */
+   if (spread && gw && gh) {
+      x1 -= spread; y1 -= spread;
+      gw += spread*2; gh += spread*2;
+   }
+
    /* get cache texture where to store the glyph */
-   if (!(texture = _glhckTextGetTextureCache(object, gw, gh, &row)))
+   if (!(texture = _glhckTextGetTextureCache(object, gw, gh, (spread != 0), &row)))
       return NULL;
 
    /* create new glyph */
@@ -412,14 +931,8 @@ __GLHCKtextGlyph* _glhckTextGetGlyph(glhckText *object, __GLHCKtextFont *font, u
    /* advance in row */
    row->x += gw+1;
 
-   /* rasterize */
-   if ((data = _glhckMalloc(gw*gh))) {
-      stbtt_MakeGlyphBitmap(&font->font, data, gw, gh, gw, scale, scale, gid);
-      glhckTextureFill(texture->texture, 0, glyph->x1, glyph->y1, 0, gw, gh, 0,
-            GLHCK_ALPHA, GLHCK_UNSIGNED_BYTE, gw*gh, data);
-      _glhckFree(data);
-   }
-
+   /* rasterized with other glyphs of the frame, before text is rendered */
+   _glhckTextQueueGlyph(object, font, texture, glyph, gid, scale, spread);
    return glyph;
 }
 
@@ -437,6 +950,7 @@ static int _getQuad(glhckText *object, __GLHCKtextFont *font, __GLHCKtextGlyph *
 #endif
 
    if (font->type == GLHCK_FONT_BMP) scale = (float)isize/(glyph->size*10.0f);
+   else if (font->type == GLHCK_FONT_SDF) scale = (float)isize/glyph->size;
 
    rx = floorf(*x + scale * glyph->xoff);
    ry = floorf(*y + scale * glyph->yoff);
@@ -455,6 +969,9 @@ static int _getQuad(glhckText *object, __GLHCKtextFont *font, __GLHCKtextGlyph *
    memcpy(&q->v1, &v1, sizeof(glhckVector2f));
    memcpy(&q->v2, &v2, sizeof(glhckVector2f));
 #else /* short precision version */
+   /* scaled far edges would be truncated, round them to the nearest pixel instead */
+   v1.x = floorf(v1.x + 0.5f);
+   v2.y = floorf(v2.y + 0.5f);
    glhckSetV2(&q->v1, &v1);
    glhckSetV2(&q->v2, &v2);
 #endif
@@ -473,6 +990,138 @@ static int _getQuad(glhckText *object, __GLHCKtextFont *font, __GLHCKtextGlyph *
    return RETURN_OK;
 }
 
+/* \brief lay out string of layout at its sub-pixel origin, one run for each cache page the glyphs are in */
+static int _glhckTextLayoutBuild(glhckText *object, __GLHCKtextLayout *layout)
+{
+   unsigned int r, codepoint, state = 0;
+   float x = layout->fx, y = layout->fy;
+   const char *s;
+   __GLHCKtextLayoutRun *run;
+   __GLHCKtextGlyph *glyph;
+   __GLHCKtextFont *font;
+   __GLHCKtextQuad q;
+
+   _glhckTextLayoutFreeRuns(layout);
+   layout->width = 0.0f;
+
+   /* search font */
+   if (!(font = _glhckTextFontGet(object, layout->fontId)))
+      goto fail;
+
+   for (s = layout->string; *s; ++s) {
+      if (decutf8(&state, &codepoint, *(unsigned char*)s)) continue;
+      if (!(glyph = _glhckTextGetGlyph(object, font, codepoint, layout->isize)))
+         continue;
+      if (!glyph->texture)
+         continue;
+
+      for (r = 0; r != layout->numRuns && layout->runs[r].texture != glyph->texture; ++r);
+      if (r == layout->numRuns) {
+         if (!(run = _glhckRealloc(layout->runs, layout->numRuns, layout->numRuns+1, sizeof(__GLHCKtextLayoutRun))))
+            goto fail;
+
+         layout->runs = run;
+         run = &layout->runs[layout->numRuns++];
+         memset(run, 0, sizeof(__GLHCKtextLayoutRun));
+         run->texture = glyph->texture;
+      }
+
+      /* should not ever fail */
+      if (_getQuad(object, font, glyph, layout->isize, &x, &y, &q) != RETURN_OK)
+         continue;
+
+      if (_glhckTextGeometryInsertQuad(&layout->runs[r].geometry, &q) != RETURN_OK)
+         goto fail;
+   }
+
+   layout->width = x - layout->fx;
+   layout->stale = 0;
+   return RETURN_OK;
+
+fail:
+   _glhckTextLayoutFreeRuns(layout);
+   layout->stale = 1;
+   return RETURN_FAIL;
+}
+
+/* \brief sub-pixel origin of coordinate, quantized to GLHCK_TEXT_SUBPIXEL steps
+ * so moving text reuses a few layouts instead of missing the cache on every draw */
+static float _glhckTextSubpixel(float f)
+{
+   return floorf((f - floorf(f)) * GLHCK_TEXT_SUBPIXEL) / GLHCK_TEXT_SUBPIXEL;
+}
+
+/* \brief draw layout translated to x, y
+ * glyphs are snapped to whole pixels from the sub-pixel origin, so they land where they would without layout */
+static void _glhckTextLayoutDraw(glhckText *object, __GLHCKtextLayout *layout, float x, float y, float *width)
+{
+   unsigned int i;
+   int tx = floorf(x), ty = floorf(y);
+   float fx = _glhckTextSubpixel(x), fy = _glhckTextSubpixel(y);
+
+   if (width) *width = 0.0f;
+
+   /* retained layouts are laid out again when drawn at different sub-pixel origin */
+   if (layout->fx != fx || layout->fy != fy) {
+      layout->fx = fx;
+      layout->fy = fy;
+      layout->stale = 1;
+   }
+
+   if (layout->stale && _glhckTextLayoutBuild(object, layout) != RETURN_OK)
+      return;
+
+   for (i = 0; i != layout->numRuns; ++i) {
+      if (_glhckTextGeometryInsertRun(&layout->runs[i].texture->geometry, &layout->runs[i].geometry, tx, ty) != RETURN_OK)
+         DEBUG(GLHCK_DBG_WARNING, "TEXT :: [%p] out of memory!", object);
+   }
+
+   if (width) *width = x + layout->width;
+}
+
+/* \brief get cached layout of string at sub-pixel origin, laying it out if it's not cached
+ * least recently used layouts are evicted, when cache is full */
+static __GLHCKtextLayout* _glhckTextLayoutGet(glhckText *object, unsigned int fontId, short isize, float fx, float fy, const char *s)
+{
+   unsigned int hash;
+   __GLHCKtextLayout *layout;
+   __GLHCKtextLayoutCache *cache;
+
+   if (!(cache = _glhckTextLayoutCache(object)))
+      return NULL;
+
+   hash = _glhckTextLayoutHash(fontId, isize, s);
+   for (layout = cache->lut[hash & (GLHCK_TEXT_LAYOUT_HASH_SIZE-1)]; layout; layout = layout->hnext) {
+      if (layout->hash == hash && layout->fontId == fontId && layout->isize == isize &&
+          layout->fx == fx && layout->fy == fy && !strcmp(layout->string, s))
+         break;
+   }
+
+   if (layout) {
+      /* move to front */
+      if (cache->head != layout) {
+         _glhckTextLayoutUnlink(cache, layout);
+         _glhckTextLayoutLink(cache, layout);
+      }
+      return layout;
+   }
+
+   if (!(layout = _glhckTextLayoutNew(fontId, isize, hash, s)))
+      return NULL;
+
+   layout->fx = fx;
+   layout->fy = fy;
+
+   if (cache->count >= GLHCK_TEXT_LAYOUTS) {
+      __GLHCKtextLayout *lru = cache->tail;
+      _glhckTextLayoutUnlink(cache, lru);
+      _glhckTextLayoutFree(lru);
+   }
+
+   _glhckTextLayoutLink(cache, layout);
+   return layout;
+}
+
 /* \brief create new internal font */
 static unsigned int glhckTextFontNewInternal(glhckText *object, const _glhckBitmapFontInfo *font, int *nativeSize)
 {
@@ -572,7 +1221,8 @@ GLHCKAPI glhckText* glhckTextRef(glhckText *object)
 /* \brief free text stack */
 GLHCKAPI unsigned int glhckTextFree(glhckText *object)
 {
-   __GLHCKtextFont *f, *fn;
+   unsigned int i;
+   __GLHCKtextFont *f;
    __GLHCKtextTexture *t, *tn;
    if (!glhckInitialized()) return 0;
    CALL(FREE_CALL_PRIO(object), "%p", object);
@@ -587,16 +1237,23 @@ GLHCKAPI unsigned int glhckTextFree(glhckText *object)
       IFDO(glhckTextureFree, t->texture);
       IFDO(_glhckFree, t->geometry.vertexData);
       IFDO(_glhckFree, t->rows);
+      IFDO(_glhckFree, t->pixels);
       _glhckFree(t);
    }
 
+   /* glyphs are gone, no need to rasterize */
+   IFDO(_glhckFree, object->pending);
+   _glhckTextLayoutsFree(object);
+
    /* free font cache */
-   for (f = object->fontCache; f; f = fn) {
-      fn = f->next;
+   for (i = 0; i != object->fontCount; ++i) {
+      if (!(f = object->fonts[i])) continue;
       IFDO(_glhckFree, f->glyphCache);
       IFDO(_glhckFree, f->data);
       _glhckFree(f);
    }
+   IFDO(_glhckFree, object->fonts);
+   IFDO(_glhckFree, object->indices);
 
    /* free shader */
    glhckTextShader(object, NULL);
@@ -615,29 +1272,30 @@ success:
 /* \brief free font from text */
 GLHCKAPI void glhckTextFontFree(glhckText *object, unsigned int font_id)
 {
-   __GLHCKtextFont *f, *fp;
-   __GLHCKtextGlyph *g;
+   __GLHCKtextFont *f;
    CALL(1, "%p, %u", object, font_id);
    assert(object);
 
    /* search font */
-   for (f = object->fontCache, fp = NULL; f && f->id != font_id; fp = f, f = f->next);
-   if (!f) return;
+   if (!(f = _glhckTextFontGet(object, font_id)))
+      return;
+
+   /* pending glyphs refer to the font */
+   _glhckTextFlushGlyphs(object);
+
+   /* ids of freed fonts are reused */
+   _glhckTextLayoutsInvalidate(object);
 
    /* free font */
-   for (g = f->glyphCache; g; g = (g->next!=-1?&f->glyphCache[g->next]:NULL))
-      _glhckTextTextureFree(object, g->texture);
-   IFDO(_glhckFree, f->glyphCache);
-   f->glyphCount = 0;
-   memset(f->lut, -1, GLHCK_TEXT_HASH_SIZE * sizeof(int));
-   if (!fp) object->fontCache = f->next;
-   else fp->next = f->next;
+   _glhckTextFontFreeGlyphs(object, f);
+   object->fonts[font_id-1] = NULL;
    _glhckFree(f);
 }
 
 /* \brief flush text glyph cache */
 GLHCKAPI void glhckTextFlushCache(glhckText *object)
 {
+   unsigned int i;
    __GLHCKtextTexture *t, *tn, *tp;
    __GLHCKtextFont *f;
    CALL(1, "%p", object);
@@ -648,8 +1306,8 @@ GLHCKAPI void glhckTextFlushCache(glhckText *object)
       tn = t->next;
 
       /* skip bitmap font textures */
-      for (f = object->fontCache; f && f->texture != t; f = f->next);
-      if (f) { tp = t; continue; }
+      for (i = 0; i != object->fontCount && (!object->fonts[i] || object->fonts[i]->texture != t); ++i);
+      if (i != object->fontCount) { tp = t; continue; }
 
       if (!object->textureCache) object->textureCache = tp;
       if (tp) tp->next = t->next;
@@ -658,13 +1316,18 @@ GLHCKAPI void glhckTextFlushCache(glhckText *object)
 
       IFDO(_glhckFree, t->geometry.vertexData);
       IFDO(_glhckFree, t->rows);
+      IFDO(_glhckFree, t->pixels);
       IFDO(glhckTextureFree, t->texture);
       _glhckFree(t);
    }
 
+   /* cached glyphs are gone, so are the pending ones */
+   object->pendingCount = 0;
+   _glhckTextLayoutsInvalidate(object);
+
    /* free font cache */
-   for (f = object->fontCache; f; f = f->next) {
-      if (f->type == GLHCK_FONT_BMP) continue;
+   for (i = 0; i != object->fontCount; ++i) {
+      if (!(f = object->fonts[i]) || f->type == GLHCK_FONT_BMP) continue;
       IFDO(_glhckFree, f->glyphCache);
       f->glyphCount = 0;
       memset(f->lut, -1, GLHCK_TEXT_HASH_SIZE * sizeof(int));
@@ -683,8 +1346,8 @@ GLHCKAPI void glhckTextGetMetrics(glhckText *object, unsigned int font_id,
    if (lineHeight) *lineHeight = 0.0f;
 
    /* search font */
-   for (font = object->fontCache; font && font->id != font_id; font = font->next);
-   if (!font) return;
+   if (!(font = _glhckTextFontGet(object, font_id)))
+      return;
 
    /* must not fail */
    if (ascender)   *ascender   = font->ascender*size;
@@ -709,8 +1372,8 @@ GLHCKAPI void glhckTextGetMinMax(glhckText *object, unsigned int font_id, float
    if (max) memset(max, 0, sizeof(kmVec2));
 
    /* search font */
-   for (font = object->fontCache; font && font->id != font_id; font = font->next);
-   if (!font) return;
+   if (!(font = _glhckTextFontGet(object, font_id)))
+      return;
 
    for (x = 0, y = 0; *s; ++s) {
       if (decutf8(&state, &codepoint, *(unsigned char*)s)) continue;
@@ -766,7 +1429,7 @@ GLHCKAPI unsigned int glhckTextFontNewFromMemory(glhckText *object, const void *
 {
    unsigned int id;
    int ascent, descent, fh, lineGap;
-   __GLHCKtextFont *font, *f;
+   __GLHCKtextFont *font;
    CALL(0, "%p, %p", object, data);
    assert(object && data);
 
@@ -776,7 +1439,8 @@ GLHCKAPI unsigned int glhckTextFontNewFromMemory(glhckText *object, const void *
 
    /* init */
    memset(font->lut, -1, GLHCK_TEXT_HASH_SIZE * sizeof(int));
-   for (id = 1, f = object->fontCache; f; f = f->next, ++id);
+   if (!(id = _glhckTextFontSlot(object)))
+      goto fail;
 
    /* copy the data */
    if (!(font->data = _glhckCopy(data, size)))
@@ -794,8 +1458,7 @@ GLHCKAPI unsigned int glhckTextFontNewFromMemory(glhckText *object, const void *
    font->lineHeight  = (float)(fh + lineGap)/fh;
    font->id          = id;
    font->type        = GLHCK_FONT_TTF;
-   font->next        = object->fontCache;
-   object->fontCache = font;
+   object->fonts[id-1] = font;
 
    RET(0, "%d", id);
    return id;
@@ -858,7 +1521,7 @@ GLHCKAPI unsigned int glhckTextFontNewFromTexture(glhckText *object, glhckTextur
 {
    int fh;
    unsigned int id;
-   __GLHCKtextFont *font, *f;
+   __GLHCKtextFont *font;
    __GLHCKtextTexture *textTexture = NULL, *t;
    CALL(0, "%p, %p, %d, %d, %d", object, texture, ascent, descent, lineGap);
    assert(object && texture);
@@ -869,7 +1532,8 @@ GLHCKAPI unsigned int glhckTextFontNewFromTexture(glhckText *object, glhckTextur
 
    /* init */
    memset(font->lut, -1, GLHCK_TEXT_HASH_SIZE * sizeof(int));
-   for (id = 1, f = object->fontCache; f; f = f->next, ++id);
+   if (!(id = _glhckTextFontSlot(object)))
+      goto fail;
 
    /* allocate text texture */
    if (!(textTexture = _glhckCalloc(1, sizeof(__GLHCKtextTexture))))
@@ -898,8 +1562,7 @@ GLHCKAPI unsigned int glhckTextFontNewFromTexture(glhckText *object, glhckTextur
    font->texture     = textTexture;
    font->id          = id;
    font->type        = GLHCK_FONT_BMP;
-   font->next        = object->fontCache;
-   object->fontCache = font;
+   object->fonts[id-1] = font;
 
    RET(0, "%d", id);
    return id;
@@ -942,6 +1605,34 @@ fail:
    return 0;
 }
 
+/* \brief generate glyphs of truetype font once at reference size as signed distance fields,
+ * and draw them scaled to any size with distance field shader. size 0 switches back to bitmap glyphs. */
+GLHCKAPI void glhckTextFontDistanceField(glhckText *object, unsigned int font_id, float referenceSize)
+{
+   short isize = (short)(referenceSize*10.0f);
+   _glhckTextFontType type = (isize > 0 ? GLHCK_FONT_SDF : GLHCK_FONT_TTF);
+   __GLHCKtextFont *font;
+   CALL(0, "%p, %u, %f", object, font_id, referenceSize);
+   assert(object);
+
+   /* search font */
+   if (!(font = _glhckTextFontGet(object, font_id)) || font->type == GLHCK_FONT_BMP)
+      return;
+
+   if (font->type == type && (type == GLHCK_FONT_TTF || font->referenceSize == isize))
+      return;
+
+   /* pending glyphs refer to the font */
+   _glhckTextFlushGlyphs(object);
+
+   /* glyphs are generated again in new mode */
+   _glhckTextFontFreeGlyphs(object, font);
+   _glhckTextLayoutsInvalidate(object);
+
+   font->type = type;
+   font->referenceSize = (type == GLHCK_FONT_SDF ? isize : 0);
+}
+
 /* \brief add new glyph to bitmap font */
 GLHCKAPI void glhckTextGlyphNew(glhckText *object,
       unsigned int font_id, const char *s,
@@ -956,8 +1647,7 @@ GLHCKAPI void glhckTextGlyphNew(glhckText *object,
    assert(object && s);
 
    /* search font */
-   for (font = object->fontCache; font && font->id != font_id; font = font->next);
-   if (!font || font->type != GLHCK_FONT_BMP)
+   if (!(font = _glhckTextFontGet(object, font_id)) || font->type != GLHCK_FONT_BMP)
       return;
 
    /* decode utf8 character */
@@ -986,12 +1676,20 @@ GLHCKAPI void glhckTextGlyphNew(glhckText *object,
    hh = hashint(codepoint) & (GLHCK_TEXT_HASH_SIZE-1);
    glyph->next   = font->lut[hh];
    font->lut[hh] = font->glyphCount-1;
+
+   /* strings may have skipped this glyph when laid out */
+   _glhckTextLayoutsInvalidate(object);
 }
 
 /* \brief render all drawn text */
 GLHCKAPI void glhckTextRender(glhckText *object)
 {
    CALL(2, "%p", object); assert(object);
+   _glhckTextFlushGlyphs(object);
+
+   if (_glhckTextIndicesReserve(object) != RETURN_OK)
+      DEBUG(GLHCK_DBG_WARNING, "TEXT :: [%p] out of memory!", object);
+
    GLHCKRA()->textRender(object);
 }
 
@@ -1004,109 +1702,91 @@ GLHCKAPI void glhckTextClear(glhckText *object)
    }
 }
 
-/* \brief draw text using font */
+/* \brief draw text using font
+ * strings are laid out once for each sub-pixel origin and replayed from layout cache with translation */
 GLHCKAPI void glhckTextStash(glhckText *object, unsigned int font_id, float size, float x, float y, const char *s, float *width)
 {
-   unsigned int i, codepoint, state = 0;
    short isize = (short)size*10.0f;
-   int vcount, newVcount;
-#if GLHCK_TEXT_FLOAT_PRECISION
-   glhckVertexData2f *v;
-#if GLHCK_TRISTRIP
-   glhckVertexData2f *d;
-#endif
-#else
-   glhckVertexData2s *v;
-#if GLHCK_TRISTRIP
-   glhckVertexData2s *d;
-#endif
-#endif
-   __GLHCKtextTexture *texture;
-   __GLHCKtextGlyph *glyph;
-   __GLHCKtextFont *font;
-   __GLHCKtextQuad q;
+   __GLHCKtextLayout *layout;
    CALL(2, "%p, %u, %f, %f, %f, %s, %p", object, font_id, size, x, y, s, width);
    assert(object && s);
    if (width) *width = 0;
 
-   /* search font */
-   for (font = object->fontCache; font && font->id != font_id; font = font->next);
-   if (!font) return;
+   if (!(layout = _glhckTextLayoutGet(object, font_id, isize, _glhckTextSubpixel(x), _glhckTextSubpixel(y), s))) {
+      DEBUG(GLHCK_DBG_WARNING, "TEXT :: [%p] out of memory!", object);
+      return;
+   }
 
-   for (; *s; ++s) {
-      if (decutf8(&state, &codepoint, *(unsigned char*)s)) continue;
-      if (!(glyph = _glhckTextGetGlyph(object, font, codepoint, isize)))
-         continue;
-      if (!(texture = glyph->texture))
-         continue;
+   _glhckTextLayoutDraw(object, layout, x, y, width);
+}
 
-      vcount = texture->geometry.vertexCount;
-#if GLHCK_TRISTRIP
-      newVcount = (vcount?vcount+6:4);
-#else
-      newVcount = vcount+6;
-#endif
-      if (newVcount >= texture->geometry.allocatedCount) {
-         if (_glhckTextGeometryAllocateMore(&texture->geometry) != RETURN_OK) {
-            DEBUG(GLHCK_DBG_WARNING, "TEXT :: [%p] out of memory!", object);
-            continue;
-         }
-      }
+/* \brief lay out string for drawing it many times, layout is never evicted from cache */
+GLHCKAPI unsigned int glhckTextLayoutNew(glhckText *object, unsigned int font_id, float size, const char *s)
+{
+   short isize = (short)size*10.0f;
+   __GLHCKtextLayout *layout;
+   __GLHCKtextLayoutCache *cache;
+   CALL(1, "%p, %u, %f, %s", object, font_id, size, s);
+   assert(object && s);
 
-      /* should not ever fail */
-      if (_getQuad(object, font, glyph, isize, &x, &y, &q) != RETURN_OK)
-         continue;
+   if (!(cache = _glhckTextLayoutCache(object)))
+      goto fail;
 
-      /* insert geometry data */
-      v = &texture->geometry.vertexData[vcount];
-
-      /* NOTE: Text geometry has inverse winding to glhck's planes.
-       * This is so we don't need to toggle winding order in GL when drawing.
-       *
-       * The end effect is basically same as using glhckRenderFlip,
-       * only these vertices are pre-multiplied. */
-
-      i = 0;
-#if GLHCK_TRISTRIP
-      /* degenerate */
-      if (vcount) {
-         d = &texture->geometry.vertexData[vcount-1];
-         v[i].vertex.x = d->vertex.x; v[i+0].vertex.y = d->vertex.y;
-         v[i].coord.x  = d->coord.x;  v[i++].coord.y  = d->coord.y;
-         v[i].vertex.x = q.v2.x; v[i+0].vertex.y = q.v2.y;
-         v[i].coord.x  = q.t2.x; v[i++].coord.y  = q.t2.y;
-      }
+   if (!(layout = _glhckTextLayoutNew(font_id, isize, _glhckTextLayoutHash(font_id, isize, s), s)))
+      goto fail;
 
-      /* tristrip */
-      v[i].vertex.x = q.v2.x; v[i+0].vertex.y = q.v2.y;
-      v[i].coord.x  = q.t2.x; v[i++].coord.y  = q.t2.y;
-      v[i].vertex.x = q.v1.x; v[i+0].vertex.y = q.v2.y;
-      v[i].coord.x  = q.t1.x; v[i++].coord.y  = q.t2.y;
-      v[i].vertex.x = q.v2.x; v[i+0].vertex.y = q.v1.y;
-      v[i].coord.x  = q.t2.x; v[i++].coord.y  = q.t1.y;
-      v[i].vertex.x = q.v1.x; v[i+0].vertex.y = q.v1.y;
-      v[i].coord.x  = q.t1.x; v[i++].coord.y  = q.t1.y;
-#else
-      /* triangle */
-      v[i].vertex.x = q.v1.x; v[i+0].vertex.y = q.v1.y;
-      v[i].coord.x  = q.t1.x; v[i++].coord.y  = q.t1.y;
-      v[i].vertex.x = q.v2.x; v[i+0].vertex.y = q.v1.y;
-      v[i].coord.x  = q.t2.x; v[i++].coord.y  = q.t1.y;
-      v[i].vertex.x = q.v2.x; v[i+0].vertex.y = q.v2.y;
-      v[i].coord.x  = q.t2.x; v[i++].coord.y  = q.t2.y;
-
-      v[i].vertex.x = q.v1.x; v[i+0].vertex.y = q.v1.y;
-      v[i].coord.x  = q.t1.x; v[i++].coord.y  = q.t1.y;
-      v[i].vertex.x = q.v2.x; v[i+0].vertex.y = q.v2.y;
-      v[i].coord.x  = q.t2.x; v[i++].coord.y  = q.t2.y;
-      v[i].vertex.x = q.v1.x; v[i+0].vertex.y = q.v2.y;
-      v[i].coord.x  = q.t1.x; v[i++].coord.y  = q.t2.y;
-#endif
+   layout->id = ++cache->nextId;
+   layout->next = cache->retained;
+   if (cache->retained) cache->retained->prev = layout;
+   cache->retained = layout;
 
-      texture->geometry.vertexCount += i;
-   }
+   /* lay out now, so glyphs get rasterized with the next batch */
+   _glhckTextLayoutBuild(object, layout);
+
+   RET(1, "%u", layout->id);
+   return layout->id;
+
+fail:
+   RET(1, "%u", 0);
+   return 0;
+}
+
+/* \brief free retained layout */
+GLHCKAPI void glhckTextLayoutFree(glhckText *object, unsigned int layout_id)
+{
+   __GLHCKtextLayout *l;
+   CALL(1, "%p, %u", object, layout_id);
+   assert(object);
+
+   if (!object->layoutCache)
+      return;
+
+   /* search layout */
+   for (l = object->layoutCache->retained; l && l->id != layout_id; l = l->next);
+   if (!l) return;
+
+   if (l->prev) l->prev->next = l->next;
+   else object->layoutCache->retained = l->next;
+   if (l->next) l->next->prev = l->prev;
+   _glhckTextLayoutFree(l);
+}
+
+/* \brief draw retained layout */
+GLHCKAPI void glhckTextLayoutStash(glhckText *object, unsigned int layout_id, float x, float y, float *width)
+{
+   __GLHCKtextLayout *l;
+   CALL(2, "%p, %u, %f, %f, %p", object, layout_id, x, y, width);
+   assert(object);
+   if (width) *width = 0;
+
+   if (!object->layoutCache)
+      return;
+
+   /* search layout */
+   for (l = object->layoutCache->retained; l && l->id != layout_id; l = l->next);
+   if (!l) return;
 
-   if (width) *width = x;
+   _glhckTextLayoutDraw(object, l, x, y, width);
 }
 
 /* \brief set shader to text */
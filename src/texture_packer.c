@@ -1,31 +1,39 @@
 #include "internal.h"
-#include <stdlib.h> /* for malloc */
+#include <limits.h> /* for INT_MAX */
+#include <stdlib.h> /* for qsort */
 #include <assert.h> /* for assert */
 
-#ifndef NULLDO
-#  define NULLDO(f,x) { f(x); x = NULL; }
-#endif
+/* tracing channel for this file */
+#define GLHCK_CHANNEL GLHCK_CHANNEL_ATLAS
+
+#define GLHCK_PACKER_STEP 32
 
 typedef struct tpRect {
-   int x1, x2, y1, y2;
+   int x, y, width, height;
 } tpRect;
 
 typedef struct tpTexture {
    int width, height, x, y;
-   int longest_edge, area;
    int flipped, placed;
 } tpTexture;
 
-typedef struct tpNode {
-   struct tpNode *next;
-   int x, y, width, height;
-} tpNode;
+typedef struct tpSkyline {
+   int x, y, width;
+} tpSkyline;
 
-static void rect_set(tpRect *rect, int x1, int y1, int x2, int y2)
+static void rect_set(tpRect *rect, int x, int y, int width, int height)
 {
    assert(rect);
-   rect->x1 = x1; rect->y1 = y1;
-   rect->x2 = x2; rect->y2 = y2;
+   rect->x = x; rect->y = y;
+   rect->width = width; rect->height = height;
+}
+
+static int rect_contains(const tpRect *a, const tpRect *b)
+{
+   assert(a && b);
+   return (b->x >= a->x && b->y >= a->y &&
+           b->x + b->width  <= a->x + a->width &&
+           b->y + b->height <= a->y + a->height);
 }
 
 static void texture_set(tpTexture *t, int width, int height)
@@ -34,8 +42,6 @@ static void texture_set(tpTexture *t, int width, int height)
    t->width   = width;  t->height  = height;
    t->x       = 0;      t->y       = 0;
    t->flipped = 0;      t->placed  = 0;
-   t->area    = width * height;
-   t->longest_edge = width >= height ? width:height;
 }
 
 static void texture_place(tpTexture *t, int x, int y, int flipped)
@@ -45,202 +51,349 @@ static void texture_place(tpTexture *t, int x, int y, int flipped)
    t->flipped  = flipped;  t->placed   = 1;
 }
 
-static void node_set(tpNode *n, int x, int y, int width, int height)
+static int next_pow2(int v)
 {
-   assert(n);
-   n->x       = x;      n->y       = y;
-   n->width   = width;  n->height  = height;
-   n->next    = NULL;
+   int p;
+   for (p = 1; p < v; p = p * 2);
+   return p;
 }
 
-static int node_fits(tpNode *n, int width, int height, int *edge_count)
+/* \brief grow array of count elements to fit one more */
+static int array_reserve(void **array, int *allocated, int count, size_t size)
 {
-   int ec = 0;
-   assert(n);
+   void *tmp;
+   if (count < *allocated) return RETURN_OK;
+   if (!(tmp = _glhckRealloc(*array, *allocated, *allocated + GLHCK_PACKER_STEP, size)))
+      return RETURN_FAIL;
+   *array = tmp;
+   *allocated += GLHCK_PACKER_STEP;
+   return RETURN_OK;
+}
 
-   if (width == n->width  || height == n->height ||
-       width == n->height || height == n->width) {
-      if (width == n->width)        ec += (height==n->height) ? 2:1;
-      else if (width == n->height)  ec += (height==n->width)  ? 2:1;
-      else if (height == n->width)  ec++;
-      else if (height == n->height) ec++;
-   }
+/***
+ * maxrects
+ ***/
+
+static int maxrects_push(_glhckTexturePacker *tp, int x, int y, int width, int height)
+{
+   if (array_reserve((void**)&tp->free_rects, &tp->free_allocated, tp->free_count, sizeof(tpRect)) != RETURN_OK)
+      return RETURN_FAIL;
+   rect_set(&tp->free_rects[tp->free_count++], x, y, width, height);
+   return RETURN_OK;
+}
+
+/* \brief score placement by leftover of shorter and longer side, smaller is better */
+static void maxrects_score(const tpRect *r, int width, int height, int flipped,
+      int *best_short, int *best_long, tpRect *best, int *best_flipped)
+{
+   int lw = r->width - width, lh = r->height - height;
+   int short_side = (lw < lh ? lw : lh), long_side = (lw < lh ? lh : lw);
 
-   *edge_count = ec;
-   return ((width  <= n->width && height <= n->height) ||
-           (height <= n->width && width  <= n->height));
+   if (lw < 0 || lh < 0)
+      return;
+
+   if (short_side < *best_short || (short_side == *best_short && long_side < *best_long)) {
+      rect_set(best, r->x, r->y, width, height);
+      *best_short = short_side;
+      *best_long = long_side;
+      *best_flipped = flipped;
+   }
 }
 
-static void node_get_rect(tpNode *n, tpRect *r)
+/* \brief find best short side fit from free rectangles */
+static int maxrects_find(const _glhckTexturePacker *tp, int width, int height, tpRect *best, int *flipped)
 {
-   assert(n);
-   rect_set(r, n->x, n->y, n->x + n->width - 1, n->y + n->height - 1);
+   int i, best_short = INT_MAX, best_long = INT_MAX;
+
+   for (i = 0; i != tp->free_count; ++i) {
+      maxrects_score(&tp->free_rects[i], width, height, 0, &best_short, &best_long, best, flipped);
+      if (tp->rotate && width != height)
+         maxrects_score(&tp->free_rects[i], height, width, 1, &best_short, &best_long, best, flipped);
+   }
+
+   return (best_short != INT_MAX);
 }
 
-#ifndef NDEBUG
-static int rect_intersects(tpRect *r1, tpRect *r2)
+/* \brief split free rectangle around used area into maximal rectangles
+ * split rectangle is marked with zero width, and its pieces appended */
+static int maxrects_split(_glhckTexturePacker *tp, int index, const tpRect *u)
 {
-   assert(r1 && r2);
-   return !(r1->x2 < r2->x1 ||
-            r1->x1 > r2->x2 ||
-            r1->y2 < r2->y1 ||
-            r1->y1 > r2->y2);
+   const tpRect f = tp->free_rects[index];
+
+   if (u->x >= f.x + f.width  || u->x + u->width  <= f.x ||
+       u->y >= f.y + f.height || u->y + u->height <= f.y)
+      return RETURN_OK;
+
+   /* above and below of used area */
+   if (u->y > f.y && maxrects_push(tp, f.x, f.y, f.width, u->y - f.y) != RETURN_OK)
+      return RETURN_FAIL;
+   if (u->y + u->height < f.y + f.height &&
+         maxrects_push(tp, f.x, u->y + u->height, f.width, f.y + f.height - (u->y + u->height)) != RETURN_OK)
+      return RETURN_FAIL;
+
+   /* left and right of used area */
+   if (u->x > f.x && maxrects_push(tp, f.x, f.y, u->x - f.x, f.height) != RETURN_OK)
+      return RETURN_FAIL;
+   if (u->x + u->width < f.x + f.width &&
+         maxrects_push(tp, u->x + u->width, f.y, f.x + f.width - (u->x + u->width), f.height) != RETURN_OK)
+      return RETURN_FAIL;
+
+   tp->free_rects[index].width = 0;
+   return RETURN_OK;
 }
 
-static void node_validate(tpNode *n1, tpNode *n2)
+/* \brief mark used area in bin
+ * old free rectangles never contain each other, so only the new ones need pruning */
+static int maxrects_place(_glhckTexturePacker *tp, const tpRect *used)
 {
-   tpRect r1, r2;
-   assert(n1 && n2);
-   node_get_rect(n1, &r1);
-   node_get_rect(n2, &r2);
-   assert(!rect_intersects(&r1, &r2));
+   int i, k, n, count = tp->free_count;
+
+   for (i = 0; i != count; ++i) {
+      if (maxrects_split(tp, i, used) != RETURN_OK)
+         return RETURN_FAIL;
+   }
+
+   for (i = count; i != tp->free_count; ++i) {
+      for (k = 0; k != tp->free_count; ++k) {
+         if (k == i || !tp->free_rects[k].width) continue;
+         if (!rect_contains(&tp->free_rects[k], &tp->free_rects[i])) continue;
+         tp->free_rects[i].width = 0;
+         break;
+      }
+   }
+
+   for (i = n = 0; i != tp->free_count; ++i)
+      if (tp->free_rects[i].width) tp->free_rects[n++] = tp->free_rects[i];
+   tp->free_count = n;
+   return RETURN_OK;
 }
-#endif
 
-static int node_merge(tpNode *n1, tpNode *n2)
+/***
+ * skyline
+ ***/
+
+/* \brief y where area fits on skyline starting from node, -1 if it doesn't fit */
+static int skyline_fit(const _glhckTexturePacker *tp, int node, int width, int height)
 {
-   int ret;
-   tpRect r1, r2;
+   int y, left = width;
+
+   if (tp->skyline[node].x + width > tp->bin_width)
+      return -1;
 
-   node_get_rect(n1, &r1);
-   node_get_rect(n2, &r2);
+   for (y = tp->skyline[node].y; left > 0; left -= tp->skyline[node++].width) {
+      assert(node < tp->skyline_count);
+      if (tp->skyline[node].y > y) y = tp->skyline[node].y;
+      if (y + height > tp->bin_height) return -1;
+   }
 
-   r1.x2++; r1.y2++;
-   r2.x2++; r2.y2++;
+   return y;
+}
 
-   /* if we share the top edge then.. */
-   if (r1.x1 == r2.x1 && r1.x2 == r2.x2 && r1.y1 == r2.y2) {
-      n1->y        = n2->y;
-      n1->height  += n2->height;
-      ret          = 1;
+/* \brief find bottom left position from skyline, ties are broken by narrower node */
+static int skyline_find(const _glhckTexturePacker *tp, int width, int height, tpRect *best, int *flipped, int *best_node)
+{
+   int i, r, y, w, h, best_top = INT_MAX, best_width = INT_MAX;
+
+   for (i = 0; i != tp->skyline_count; ++i) {
+      for (r = 0; r != (tp->rotate && width != height ? 2 : 1); ++r) {
+         w = (r ? height : width); h = (r ? width : height);
+         if ((y = skyline_fit(tp, i, w, h)) < 0) continue;
+         if (y + h < best_top || (y + h == best_top && tp->skyline[i].width < best_width)) {
+            rect_set(best, tp->skyline[i].x, y, w, h);
+            best_top = y + h;
+            best_width = tp->skyline[i].width;
+            *best_node = i;
+            *flipped = r;
+         }
+      }
    }
-   /* if we share the bottom edge  */
-   else if (r1.x1 == r2.x1 && r1.x2 == r2.x2 && r1.y2 == r2.y1) {
-      n1->height  += n2->height;
-      ret          = 1;
+
+   return (best_top != INT_MAX);
+}
+
+/* \brief raise skyline under used area */
+static int skyline_place(_glhckTexturePacker *tp, int node, const tpRect *used)
+{
+   int i, shrink;
+   tpSkyline *prev;
+
+   if (array_reserve((void**)&tp->skyline, &tp->skyline_allocated, tp->skyline_count, sizeof(tpSkyline)) != RETURN_OK)
+      return RETURN_FAIL;
+
+   memmove(&tp->skyline[node+1], &tp->skyline[node], (tp->skyline_count - node) * sizeof(tpSkyline));
+   tp->skyline[node].x = used->x;
+   tp->skyline[node].y = used->y + used->height;
+   tp->skyline[node].width = used->width;
+   tp->skyline_count++;
+
+   /* cut nodes now under the new one */
+   for (i = node+1; i < tp->skyline_count; ) {
+      prev = &tp->skyline[i-1];
+      if (tp->skyline[i].x >= prev->x + prev->width) break;
+
+      shrink = prev->x + prev->width - tp->skyline[i].x;
+      tp->skyline[i].x += shrink;
+      tp->skyline[i].width -= shrink;
+      if (tp->skyline[i].width > 0) break;
+
+      memmove(&tp->skyline[i], &tp->skyline[i+1], (tp->skyline_count - i - 1) * sizeof(tpSkyline));
+      tp->skyline_count--;
    }
-   /* if we share the left edge */
-   else if (r1.y1 == r2.y1 && r1.y2 == r2.y1 && r1.x1 == r2.x2) {
-      n1->x        = n2->x;
-      n1->width   += n2->width;
-      ret          = 1;
+
+   /* merge nodes on same level */
+   for (i = 0; i < tp->skyline_count-1; ) {
+      if (tp->skyline[i].y != tp->skyline[i+1].y) { ++i; continue; }
+      tp->skyline[i].width += tp->skyline[i+1].width;
+      memmove(&tp->skyline[i+1], &tp->skyline[i+2], (tp->skyline_count - i - 2) * sizeof(tpSkyline));
+      tp->skyline_count--;
    }
-   /* if we share the left edge */
-   else if (r1.y1 == r2.y1 && r1.y2 == r2.y1 && r1.x2 == r2.x1) {
-      n1->width   += n2->width;
-      ret          = 1;
-   } else
-      ret = 0;
 
-   return ret;
+   return RETURN_OK;
 }
 
-static void glhckTexturePackerReset(_glhckTexturePacker *tp)
+/***
+ * packing
+ ***/
+
+/* \brief start empty bin with current method */
+static int packer_bin(_glhckTexturePacker *tp, int width, int height)
 {
-   tpNode *next, *kill;
-   tp->texture_count = 0;
-   tp->longest_edge  = 0;
-   tp->total_area    = 0;
-   tp->texture_index = 0;
+   tp->bin_width = width;
+   tp->bin_height = height;
+   tp->free_count = 0;
+   tp->skyline_count = 0;
+
+   if (tp->method == GLHCK_PACKER_SKYLINE) {
+      if (array_reserve((void**)&tp->skyline, &tp->skyline_allocated, 0, sizeof(tpSkyline)) != RETURN_OK)
+         return RETURN_FAIL;
+      tp->skyline[0].x = tp->skyline[0].y = 0;
+      tp->skyline[0].width = width;
+      tp->skyline_count = 1;
+      return RETURN_OK;
+   }
 
-   if(tp->textures)
-      NULLDO(free, tp->textures);
+   return maxrects_push(tp, 0, 0, width, height);
+}
 
-   if (tp->free_list) {
-      next = tp->free_list;
-      while (next) {
-         kill = next;
-         next = next->next;
-         NULLDO(free, kill);
-      }
+/* \brief clip free space to bin after it was trimmed */
+static void packer_clip(_glhckTexturePacker *tp)
+{
+   int i, n;
+   tpRect *r;
+
+   for (i = n = 0; i != tp->free_count; ++i) {
+      r = &tp->free_rects[i];
+      if (r->x + r->width  > tp->bin_width)  r->width  = tp->bin_width - r->x;
+      if (r->y + r->height > tp->bin_height) r->height = tp->bin_height - r->y;
+      if (r->width > 0 && r->height > 0) tp->free_rects[n++] = *r;
    }
-   tp->free_list = NULL;
+   tp->free_count = n;
+
+   /* skyline nodes past the bin edge are dropped, heights are checked on fit */
+   for (i = n = 0; i != tp->skyline_count; ++i) {
+      if (tp->skyline[i].x >= tp->bin_width) continue;
+      if (tp->skyline[i].x + tp->skyline[i].width > tp->bin_width)
+         tp->skyline[i].width = tp->bin_width - tp->skyline[i].x;
+      tp->skyline[n++] = tp->skyline[i];
+   }
+   tp->skyline_count = n;
 }
 
-static void glhckTexturePackerNodeNew(_glhckTexturePacker *tp, int x, int y, int width, int height)
+/* \brief place texture to bin with current method
+ * returns RETURN_FAIL only when out of memory, fits tells whether texture was placed */
+static int packer_place(_glhckTexturePacker *tp, tpTexture *t, int *fits)
 {
-   tpNode *node;
-   node = malloc(sizeof(tpNode));
-   node_set(node, x, y, width, height);
-   node->next = tp->free_list;
-   tp->free_list = node;
+   tpRect r;
+   int flipped = 0, node = 0;
+
+   if (tp->method == GLHCK_PACKER_SKYLINE) {
+      if (!(*fits = skyline_find(tp, t->width, t->height, &r, &flipped, &node)))
+         return RETURN_OK;
+      if (skyline_place(tp, node, &r) != RETURN_OK)
+         return RETURN_FAIL;
+   } else {
+      if (!(*fits = maxrects_find(tp, t->width, t->height, &r, &flipped)))
+         return RETURN_OK;
+      if (maxrects_place(tp, &r) != RETURN_OK)
+         return RETURN_FAIL;
+   }
+
+   texture_place(t, r.x, r.y, flipped);
+   return RETURN_OK;
 }
 
-static int next_pow2(int v)
+static int sort_area(const void *a, const void *b)
 {
-   int p;
-   for (p = 1; p < v; p = p * 2);
-   return p;
+   const tpTexture *t1 = *(const tpTexture**)a, *t2 = *(const tpTexture**)b;
+   return t2->width * t2->height - t1->width * t1->height;
 }
 
-#ifndef NDEBUG
-static void validate(_glhckTexturePacker *tp)
+static int sort_max_side(const void *a, const void *b)
 {
-   tpNode *c, *f = tp->free_list;
+   const tpTexture *t1 = *(const tpTexture**)a, *t2 = *(const tpTexture**)b;
+   int m1 = (t1->width > t1->height ? t1->width : t1->height);
+   int m2 = (t2->width > t2->height ? t2->width : t2->height);
+   return (m1 != m2 ? m2 - m1 : sort_area(a, b));
+}
 
-   while (f) {
-      c = tp->free_list;
-      while (c) {
-         if (f != c)
-            node_validate(f, c);
-         c = c->next;
-      }
-      f = f->next;
-   }
+static int sort_perimeter(const void *a, const void *b)
+{
+   const tpTexture *t1 = *(const tpTexture**)a, *t2 = *(const tpTexture**)b;
+   return (t2->width + t2->height) - (t1->width + t1->height);
 }
-#else
-#  define validate(ignore) ;
-#endif
-
-static int merge_nodes(_glhckTexturePacker *tp)
-{
-   tpNode *prev, *c, *f = tp->free_list;
-
-   while (f) {
-      prev  = NULL;
-      c     = tp->free_list;
-      while (c) {
-         if (f != c) {
-            if (node_merge(f, c)) {
-               assert(prev);
-               prev->next = c->next;
-               free(c);
-               return 1;
-            }
-         }
-         prev = c;
-         c = c->next;
-      }
-      f = f->next;
-   }
-   return 0;
+
+static int sort_height(const void *a, const void *b)
+{
+   const tpTexture *t1 = *(const tpTexture**)a, *t2 = *(const tpTexture**)b;
+   return (t1->height != t2->height ? t2->height - t1->height : t2->width - t1->width);
+}
+
+static void glhckTexturePackerReset(_glhckTexturePacker *tp)
+{
+   tp->texture_count = 0;
+   tp->texture_index = 0;
+   tp->longest_edge  = 0;
+   tp->total_area    = 0;
+   IFDO(_glhckFree, tp->textures);
 }
 
 _glhckTexturePacker* _glhckTexturePackerNew(void)
 {
    _glhckTexturePacker *tp;
 
-   tp = calloc(1, sizeof(_glhckTexturePacker));
-   if(!tp) return NULL;
-
-   /* null */
-   tp->free_list = NULL;
-   tp->textures  = NULL;
+   if (!(tp = _glhckCalloc(1, sizeof(_glhckTexturePacker))))
+      return NULL;
 
+   /* skyline packs tightest when bin is grown to fit everything,
+    * maxrects reuses holes better when inserting to fixed bin */
+   tp->method = GLHCK_PACKER_SKYLINE;
+   tp->sort   = GLHCK_PACKER_SORT_MAX_SIDE;
+   tp->rotate = 1;
    return tp;
 }
 
 void _glhckTexturePackerFree(_glhckTexturePacker *tp)
 {
    glhckTexturePackerReset(tp);
-   free(tp);
+   IFDO(_glhckFree, tp->free_rects);
+   IFDO(_glhckFree, tp->skyline);
+   _glhckFree(tp);
+}
+
+/* \brief select placement method, sort order of _glhckTexturePackerPack and whether textures may be rotated */
+void _glhckTexturePackerHeuristics(_glhckTexturePacker *tp, _glhckTexturePackerMethod method, _glhckTexturePackerSort sort, int rotate)
+{
+   assert(tp);
+   tp->method = method;
+   tp->sort   = sort;
+   tp->rotate = rotate;
 }
 
 void _glhckTexturePackerCount(_glhckTexturePacker *tp, short texture_count)
 {
    glhckTexturePackerReset(tp);
-   tp->texture_count = texture_count;
-   tp->textures      = calloc(texture_count, sizeof(tpTexture));
+   if ((tp->textures = _glhckCalloc(texture_count, sizeof(tpTexture))))
+      tp->texture_count = texture_count;
 }
 
 short _glhckTexturePackerAdd(_glhckTexturePacker *tp, int width, int height)
@@ -256,6 +409,50 @@ short _glhckTexturePackerAdd(_glhckTexturePacker *tp, int width, int height)
    return tp->texture_index-1;
 }
 
+/* \brief start empty bin for incremental insertion, textures added before are forgotten */
+int _glhckTexturePackerBin(_glhckTexturePacker *tp, int width, int height)
+{
+   assert(tp && width > 0 && height > 0);
+   glhckTexturePackerReset(tp);
+   return packer_bin(tp, width, height);
+}
+
+/* \brief insert texture to bin started with _glhckTexturePackerBin, or to free space left by _glhckTexturePackerPack
+ * returns index of the texture, or -1 if it doesn't fit or we run out of memory */
+short _glhckTexturePackerInsert(_glhckTexturePacker *tp, int width, int height)
+{
+   tpTexture *t;
+   int fits;
+   assert(tp && tp->bin_width);
+
+   if (tp->texture_index >= tp->texture_count) {
+      if (tp->texture_count >= SHRT_MAX)
+         return -1;
+      if (!(t = _glhckRealloc(tp->textures, tp->texture_count, tp->texture_count+1, sizeof(tpTexture))))
+         return -1;
+      tp->textures = t;
+      tp->texture_count++;
+   }
+
+   t = &tp->textures[tp->texture_index];
+   texture_set(t, width, height);
+   if (packer_place(tp, t, &fits) != RETURN_OK || !fits)
+      return -1;
+
+   if (width  > tp->longest_edge) tp->longest_edge = width;
+   if (height > tp->longest_edge) tp->longest_edge = height;
+   tp->total_area += width * height;
+   return tp->texture_index++;
+}
+
+/* \brief fraction of bin covered by textures */
+float _glhckTexturePackerOccupancy(const _glhckTexturePacker *tp)
+{
+   assert(tp);
+   if (!tp->bin_width || !tp->bin_height) return 0.0f;
+   return (float)tp->total_area/((float)tp->bin_width * tp->bin_height);
+}
+
 int _glhckTexturePackerGetLocation(const _glhckTexturePacker *tp, int index, int *in_x, int *in_y, int *in_width, int *in_height)
 {
    int ret = 0, x = 0, y = 0, width = 0, height = 0;
@@ -284,231 +481,106 @@ int _glhckTexturePackerGetLocation(const _glhckTexturePacker *tp, int index, int
    return ret;
 }
 
-void checkDimensions(_glhckTexturePacker *tp, int *width, int *height)
-{
-   tpTexture *t;
-   unsigned short i;
-   for (i = 0; i != tp->texture_count; ++i) {
-      t = &tp->textures[i];
-      if (t->width  > *width)  *width  = t->width;
-      if (t->height > *height) *height = t->height;
-   }
-}
-
+/* \brief pack all added textures to smallest bin they fit
+ * textures are placed largest first in sort order, bin grows from square of total area until everything fits */
 int _glhckTexturePackerPack(_glhckTexturePacker *tp, int *in_width, int *in_height, int force_power_of_two, int one_pixel_border)
 {
-   tpTexture *t;
-   int width, height;
-   unsigned short count, i, i2;
-   int least_y, least_x;
-   int edge_count, ec;
-   int index, longest_edge, most_area;
-   int flipped, wid, hit, y;
-   tpNode *previous_best_fit, *best_fit, *previous, *search;
+   tpTexture *t, **order = NULL;
+   int width, height, longest_edge, fits = 1, area = 0;
+   unsigned short i;
+   int (*compare)(const void*, const void*) = NULL;
    assert(tp);
 
-   if (one_pixel_border) {
-      for (i = 0; i != tp->texture_count; ++i) {
-         t = &tp->textures[i];
+   *in_width = *in_height = 0;
+   if (!tp->texture_count)
+      return 0;
+
+   if (!(order = _glhckMalloc(tp->texture_count * sizeof(tpTexture*))))
+      return 0;
+
+   for (i = 0; i != tp->texture_count; ++i) {
+      t = order[i] = &tp->textures[i];
+      if (one_pixel_border) {
          t->width  += 2;
          t->height += 2;
       }
-      tp->longest_edge += 2;
+      area += t->width * t->height;
    }
 
-   if (force_power_of_two)
-      tp->longest_edge = next_pow2(tp->longest_edge);
-
-   width = tp->longest_edge;
-   count = round((float)tp->total_area/(tp->longest_edge * tp->longest_edge));
-   height = (count + 2) * tp->longest_edge;
-
-   if (force_power_of_two)
-      height = next_pow2(height);
-
-   _glhckPrintf("\4Total area: \3%d", tp->total_area);
-   _glhckPrintf("\4Count: \3%d", count);
-   _glhckPrintf("\1Initial size: \3%d\5x\3%d", width, height);
-
-   /* more sane packing area */
-   if (width > height) {
-      if (height != width/2) {
-         height  = width/2;
-         width  /= 2;
-         checkDimensions(tp, &width, &height);
-      }
-   } else if (height > width) {
-      if (width != height/2) {
-         width   = height/2;
-         height /= 2;
-         checkDimensions(tp, &width, &height);
-      }
+   switch (tp->sort) {
+      case GLHCK_PACKER_SORT_AREA: compare = sort_area; break;
+      case GLHCK_PACKER_SORT_MAX_SIDE: compare = sort_max_side; break;
+      case GLHCK_PACKER_SORT_PERIMETER: compare = sort_perimeter; break;
+      case GLHCK_PACKER_SORT_HEIGHT: compare = sort_height; break;
+      default: break;
+   }
+   if (compare) qsort(order, tp->texture_count, sizeof(tpTexture*), compare);
+
+   /* start from square that could hold the total area */
+   longest_edge = tp->longest_edge + (one_pixel_border ? 2 : 0);
+   width = height = ceilf(sqrtf(area));
+   if (width < longest_edge) width = height = longest_edge;
+   if (force_power_of_two) {
+      width = height = next_pow2(width);
+      if (height/2 >= longest_edge && width * (height/2) >= area) height /= 2;
    }
 
-   _glhckPrintf("\2Good size: \3%d\5x\3%d", width, height);
-
-   tp->debug_count = 0;
-   glhckTexturePackerNodeNew(tp, 0, 0, width, height);
+   while (1) {
+      if (packer_bin(tp, width, height) != RETURN_OK)
+         goto fail;
 
-   for (i = 0; i != tp->texture_count; ++i) {
-      index        = 0;
-      longest_edge = 0;
-      most_area    = 0;
-
-      for(i2 = 0; i2 != tp->texture_count; ++i2) {
-         t = &tp->textures[i2];
-         if (!t->placed) {
-            if (t->longest_edge > longest_edge) {
-               most_area    = t->area;
-               longest_edge = t->longest_edge;
-               index        = i2;
-            } else if (t->longest_edge == longest_edge) {
-               if (t->area > most_area) {
-                  most_area = t->area;
-                  index     = i2;
-               }
-            }
-         }
+      for (i = 0; i != tp->texture_count && fits; ++i) {
+         if (packer_place(tp, order[i], &fits) != RETURN_OK)
+            goto fail;
       }
+      if (fits) break;
 
-      least_y = 0x7FFFFFFF;
-      least_x = 0x7FFFFFFF;
-      t = &tp->textures[index];
-      previous_best_fit = NULL;
-      best_fit          = NULL;
-      previous          = NULL;
-      search            = tp->free_list;
-      edge_count        = 0;
-
-      while (search) {
-         ec = 0;
-         if (node_fits(search, t->width, t->height, &ec)) {
-            if (ec == 2) {
-               previous_best_fit = previous;
-               best_fit          = search;
-               edge_count        = ec;
-               break;
-            }
-            else if (search->y < least_y) {
-               least_y           = search->y;
-               least_x           = search->x;
-               previous_best_fit = previous;
-               best_fit          = search;
-               edge_count        = ec;
-            }
-            else if (search->y == least_y && search->x < least_x) {
-               least_x           = search->x;
-               previous_best_fit = previous;
-               best_fit          = search;
-               edge_count        = ec;
-            }
-         }
-         previous = search;
-         search   = search->next;
-      }
-      assert(best_fit); /* should always find a fit */
-
-      validate(tp);
-      switch(edge_count) {
-         case 0:
-            if (t->longest_edge <= best_fit->width) {
-               flipped  = 0;
-               wid      = t->width;
-               hit      = t->height;
-
-               if (hit > wid) {
-                  wid      = t->height;
-                  hit      = t->width;
-                  flipped  = 1;
-               }
-
-               texture_place(t, best_fit->x, best_fit->y, flipped);
-               glhckTexturePackerNodeNew(tp, best_fit->x, best_fit->y + hit, best_fit->width, best_fit->height - hit);
-
-               best_fit->x        += wid;
-               best_fit->width    -= wid;
-               best_fit->height    = hit;
-               validate(tp);
-            } else {
-               assert(t->longest_edge <= best_fit->height);
-               flipped  = 0;
-               wid      = t->width;
-               hit      = t->height;
-
-               if (hit < wid) {
-                  wid      = t->height;
-                  hit      = t->width;
-                  flipped  = 1;
-               }
-
-               texture_place(t, best_fit->x, best_fit->y, flipped);
-               glhckTexturePackerNodeNew(tp, best_fit->x, best_fit->y + hit, best_fit->width, best_fit->height - hit);
-
-               best_fit->x     += wid;
-               best_fit->width -= wid;
-               best_fit->height = hit;
-               validate(tp);
-            }
-            break;
-         case 1:
-            if (t->width == best_fit->width) {
-               texture_place(t, best_fit->x, best_fit->y, 0);
-               best_fit->y      += t->height;
-               best_fit->height -= t->height;
-               validate(tp);
-            }
-            else if (t->height == best_fit->height) {
-               texture_place(t, best_fit->x, best_fit->y, 0);
-               best_fit->x     += t->width;
-               best_fit->width -= t->width;
-               validate(tp);
-            }
-            else if (t->width == best_fit->height) {
-               texture_place(t, best_fit->x, best_fit->y, 1);
-               best_fit->x     += t->height;
-               best_fit->width -= t->height;
-               validate(tp);
-            }
-            else if (t->height == best_fit->width) {
-               texture_place(t, best_fit->x, best_fit->y, 1);
-               best_fit->y      += t->width;
-               best_fit->height -= t->width;
-               validate(tp);
-            }
-            break;
-         case 2:
-            flipped = t->width != best_fit->width || t->height != best_fit->height;
-            texture_place(t, best_fit->x, best_fit->y, flipped);
-            if (previous_best_fit)  previous_best_fit->next = best_fit->next;
-            else                    tp->free_list = best_fit->next;
-            NULLDO(free, best_fit);
-            validate(tp);
-            break;
-      }
-      while (merge_nodes(tp)); /* merge as much as we can */
+      /* grow the shorter side */
+      for (i = 0; i != tp->texture_count; ++i) order[i]->placed = 0;
+      fits = 1;
+      if (width <= height) width = (force_power_of_two ? width * 2 : width + width/8 + 1);
+      else height = (force_power_of_two ? height * 2 : height + height/8 + 1);
    }
 
-   height = 0;
-   for(i = 0; i < tp->texture_count; ++i) {
+   /* trim bin to used area */
+   width = height = 0;
+   for (i = 0; i != tp->texture_count; ++i) {
       t = &tp->textures[i];
+      if (t->x + (t->flipped ? t->height : t->width) > width) width = t->x + (t->flipped ? t->height : t->width);
+      if (t->y + (t->flipped ? t->width : t->height) > height) height = t->y + (t->flipped ? t->width : t->height);
+
       if (one_pixel_border) {
-         t->width    -= 2;
-         t->height   -= 2;
+         t->width  -= 2;
+         t->height -= 2;
          t->x++;
          t->y++;
       }
-
-      y = t->flipped?t->y+t->width:t->y+t->height;
-      height = y>height?y:height;
    }
 
-   if (force_power_of_two)
+   if (force_power_of_two) {
+      width  = next_pow2(width);
       height = next_pow2(height);
+   }
 
-   *in_width   = width;
-   *in_height  = height;
+   tp->bin_width = *in_width = width;
+   tp->bin_height = *in_height = height;
+   packer_clip(tp);
+   _glhckFree(order);
 
+   DEBUG(GLHCK_DBG_CRAP, "Packed %u textures to %dx%d, %.1f%% occupied",
+         tp->texture_count, width, height, _glhckTexturePackerOccupancy(tp) * 100.0f);
    return (width * height) - tp->total_area;
+
+fail:
+   for (i = 0; i != tp->texture_count; ++i) {
+      tp->textures[i].placed = 0;
+      if (one_pixel_border) {
+         tp->textures[i].width  -= 2;
+         tp->textures[i].height -= 2;
+      }
+   }
+   IFDO(_glhckFree, order);
+   return 0;
 }
 
 /* vim: set ts=8 sw=3 tw=0 :*/
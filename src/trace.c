@@ -34,6 +34,7 @@ static __GLHCKtraceChannel _traceChannels[] =
    { GLHCK_CHANNEL_HWBUFFER,        0 },
    { GLHCK_CHANNEL_SHADER,          0 },
    { GLHCK_CHANNEL_COLLISION,       0 },
+   { GLHCK_CHANNEL_JOB,             0 },
 
    /* trace channel */
    { GLHCK_CHANNEL_TRACE,  0 },